@@ -0,0 +1,27 @@
+// app.h
+#ifndef INC_APP_H_
+#define INC_APP_H_
+
+#include "main.h"
+#include "room_control.h"
+
+/// @brief Sistema de control de la habitación (definido en app.c)
+extern room_control_t room_system;
+
+/**
+ * @brief Inicializa los módulos de la aplicación (LED, OLED, teclado, control, DHT11)
+ *        y envía el mensaje de arranque por UART.
+ * @note  Debe llamarse después de inicializar los periféricos (MX_*_Init).
+ */
+void app_init(void);
+
+/**
+ * @brief Ejecuta una pasada del bucle principal: despacha los eventos que dejaron las
+ *        interrupciones (teclado, UART, fin de DMA del OLED) y los temporizadores vencidos
+ *        (heartbeat, DHT11, timeouts de room_control), y si no queda trabajo duerme hasta el
+ *        siguiente temporizador o interrupción (WFI, Sleep sin tick o STOP2, ver lowpower.h).
+ * @note  main() la llama dentro de while(1); el simulador de host la llama sobre un reloj virtual.
+ */
+void app_loop_step(void);
+
+#endif /* INC_APP_H_ */
@@ -0,0 +1,40 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include "room_control.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/// Comandos de texto "NOMBRE" o "NOMBRE:VALOR", una línea cada uno: X(nombre, manejador).
+/// tools/command_hashgen.py lee esta lista para generar la tabla de hash perfecto.
+#define COMMAND_LIST(X)                 \
+    X(GET_TEMP,   command_get_temp)     \
+    X(GET_STATUS, command_get_status)   \
+    X(SET_PASS,   command_set_pass)     \
+    X(FORCE_FAN,  command_force_fan)    \
+    X(FAN_MODE,   command_fan_mode)     \
+    X(SET_POINT,  command_set_point)
+
+/// Tamaño suficiente para cualquier respuesta, incluido el "\r\n" final
+#define COMMAND_REPLY_MAX 48
+
+typedef enum {
+    COMMAND_OK = 0,
+    COMMAND_UNKNOWN,        // nombre que no está en COMMAND_LIST
+    COMMAND_BAD_VALUE,      // falta el valor o no es válido
+    COMMAND_NOT_ALLOWED     // el estado del sistema no lo permite (p. ej. bloqueado)
+} command_status_t;
+
+/**
+ * @brief Interpreta y ejecuta una línea de comando.
+ * @param room Sistema sobre el que actúa el comando.
+ * @param line Línea sin terminador; se analiza en su sitio, sin copiarla.
+ * @param len Longitud de la línea.
+ * @param reply Respuesta a enviar ("TEMP:24.5\r\n", "OK\r\n", "ERROR:...\r\n").
+ * @param reply_max Tamaño de reply (COMMAND_REPLY_MAX basta).
+ * @return Resultado del comando.
+ */
+command_status_t command_execute(room_control_t *room, const char *line, uint16_t len,
+                                 char *reply, size_t reply_max);
+
+#endif // COMMANDS_H
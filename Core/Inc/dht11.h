@@ -8,10 +8,26 @@
 // Asegúrate de que coincidan con tu hardware
 #define DHT11_PORT GPIOA
 #define DHT11_PIN  GPIO_PIN_5
+#define DHT11_PIN_AF      GPIO_AF1_TIM2   // PA5 como TIM2_CH1 durante la captura
+#define DHT11_TIM_CHANNEL TIM_CHANNEL_1
+
+/// Flancos de una trama: bajada y subida de la respuesta, bajada que abre el
+/// primer bit y, por cada bit, su subida y su bajada.
+#define DHT11_FRAME_EDGES (3 + 40 * 2)
+
+/// Resultado de DHT11_DecodeEdges()
+typedef enum {
+    DHT11_DECODE_OK = 0,
+    DHT11_DECODE_NO_RESPONSE,   // no aparece el pulso de respuesta de 80/80 µs
+    DHT11_DECODE_SHORT_FRAME,   // faltan flancos para completar los 40 bits
+    DHT11_DECODE_BAD_PULSE,     // un pulso de bit fuera de tiempos
+    DHT11_DECODE_CHECKSUM       // trama completa pero con checksum incorrecto
+} DHT11_DecodeStatus_t;
 
 /**
  * @brief Inicializa el driver del DHT11.
- * @param htim Puntero al handle del timer configurado a 1MHz (1 tick = 1µs).
+ * @param htim Timer a 1MHz (1 tick = 1µs) con el canal DHT11_TIM_CHANNEL en captura
+ *             de entrada por ambos flancos y su DMA enlazado (TIM_DMA_ID_CC1).
  */
 void DHT11_Init(TIM_HandleTypeDef *htim);
 
@@ -24,7 +40,8 @@ bool DHT11_StartReading(void);
 
 /**
  * @brief Procesa la máquina de estados de la comunicación con el DHT11.
- *        Debe ser llamada continuamente en el bucle principal.
+ *        Debe ser llamada continuamente en el bucle principal. Nunca espera al sensor:
+ *        los flancos los guarda el DMA y la trama se decodifica al completarse.
  */
 void DHT11_Process(void);
 
@@ -34,13 +51,37 @@ void DHT11_Process(void);
  */
 bool DHT11_IsDataReady(void);
 
+/**
+ * @brief Indica si hay una lectura en curso (pulso de inicio o captura de la trama).
+ * @return true mientras DHT11_Process() tenga trabajo pendiente.
+ */
+bool DHT11_IsBusy(void);
+
+/**
+ * @brief Tiempo hasta que DHT11_Process() vuelva a tener trabajo: lo que falta del pulso
+ *        de inicio, o 1 ms mientras se captura la trama.
+ * @return Milisegundos (al menos 1) con una lectura en curso, 0 si no hay ninguna.
+ */
+uint32_t DHT11_NextPollMs(void);
+
 /**
  * @brief Obtiene el último valor de temperatura y humedad leídos.
- * @param temperature Puntero donde se almacenará la temperatura.
- * @param humidity Puntero donde se almacenará la humedad.
+ * @param temperature Puntero donde se almacenará la temperatura, en décimas de grado.
+ * @param humidity Puntero donde se almacenará la humedad, en décimas de %.
  * @return true si los datos se copiaron con éxito (porque había datos nuevos), false si no.
  *         Al llamar a esta función, se resetea el flag de 'datos listos'.
  */
-bool DHT11_GetNewData(float* temperature, float* humidity);
+bool DHT11_GetNewData(int16_t* temperature, int16_t* humidity);
+
+/**
+ * @brief Decodifica una trama del DHT11 a partir de las marcas de tiempo de sus flancos.
+ * @param edges Marcas de tiempo en µs de flancos consecutivos (ambas polaridades). Solo se
+ *              usan diferencias, así que el desbordamiento del contador no afecta.
+ * @param count Número de marcas en edges.
+ * @param data_out Los 5 bytes recibidos: humedad, decimal, temperatura, decimal, checksum.
+ * @return DHT11_DECODE_OK si la trama es válida.
+ * @note  Función pura (sin hardware ni estado), para poder probarla en el host.
+ */
+DHT11_DecodeStatus_t DHT11_DecodeEdges(const uint32_t *edges, uint32_t count, uint8_t data_out[5]);
 
-#endif /* INC_DHT11_H_ */
\ No newline at end of file
+#endif /* INC_DHT11_H_ */
@@ -2,18 +2,23 @@
 #define ROOM_CONTROL_H
 
 #include "main.h"
+#include "scheduler.h"
+#include "fan_pid.h"
 #include <stdint.h>
 #include <stdbool.h>
 
 #define PASSWORD_LENGTH 4
 #define MAX_TEMP_READINGS 5
+// Una lectura del DHT11 cada 2 s: es también el periodo de muestreo del PID del ventilador
+#define TEMP_READ_INTERVAL_MS 2000
 
 typedef enum {
     ROOM_STATE_LOCKED,
     ROOM_STATE_UNLOCKED,
     ROOM_STATE_INPUT_PASSWORD,
     ROOM_STATE_ACCESS_DENIED,
-    ROOM_STATE_EMERGENCY
+    ROOM_STATE_EMERGENCY,
+    ROOM_STATE_COUNT            // número de estados, no es un estado
 } room_state_t;
 
 typedef enum {
@@ -23,6 +28,55 @@ typedef enum {
     FAN_LEVEL_HIGH = 100  // 100% PWM
 } fan_level_t;
 
+// Control automático del ventilador (sin FORCE_FAN)
+typedef enum {
+    FAN_MODE_PID,         // PI hacia el setpoint, cualquier duty de 0 a 100%
+    FAN_MODE_STEP         // respaldo: tabla de cuatro niveles por umbrales de temperatura
+} fan_mode_t;
+
+// Eventos que recibe el sistema; los genera app.c a partir de interrupciones y temporizadores
+typedef enum {
+    ROOM_EVENT_KEY,             // tecla pulsada: key
+    ROOM_EVENT_TEMPERATURE,     // nueva lectura del DHT11: temperature y humidity
+    ROOM_EVENT_TIMEOUT,         // venció el temporizador del estado actual
+    ROOM_EVENT_DISPLAY_READY,   // el OLED terminó de enviar el frame anterior
+    ROOM_EVENT_EMERGENCY        // acorde de emergencia en el teclado (* y # a la vez)
+} room_event_type_t;
+
+typedef struct {
+    room_event_type_t type;
+    union {
+        char key;
+        struct {
+            int16_t temperature;    // décimas de grado
+            int16_t humidity;       // décimas de %
+        };
+    };
+} room_event_t;
+
+// Columnas de la tabla de transiciones: cada evento cae en una sola (room_control_event_input)
+typedef enum {
+    ROOM_INPUT_DIGIT,           // tecla '0'..'9'
+    ROOM_INPUT_STAR,            // tecla '*'
+    ROOM_INPUT_HASH,            // tecla '#'
+    ROOM_INPUT_KEY,             // cualquier otra tecla ('A'..'D')
+    ROOM_INPUT_TEMPERATURE,
+    ROOM_INPUT_TIMEOUT,
+    ROOM_INPUT_DISPLAY_READY,
+    ROOM_INPUT_EMERGENCY,
+    ROOM_INPUT_COUNT
+} room_input_t;
+
+// Transiciones alternativas por celda (estado x entrada), elegidas por su guarda en orden
+#define ROOM_FSM_ALTS 3
+
+// Uso de una transición; los ciclos son de DWT->CYCCNT: guarda, acciones y cambio de estado
+typedef struct {
+    uint32_t count;
+    uint32_t cycles_total;      // da la vuelta tras 2^32 ciclos acumulados
+    uint32_t cycles_max;
+} room_transition_stats_t;
+
 typedef struct {
     room_state_t current_state;
     char password[PASSWORD_LENGTH + 1];
@@ -30,31 +84,46 @@ typedef struct {
     uint8_t input_index;
     uint32_t last_input_time;
     uint32_t state_enter_time;
+    sched_timer_t state_timer;      // timeout de INPUT_PASSWORD y ACCESS_DENIED
+    bool emergency_latched;         // EMERGENCY activa: solo la clave correcta la levanta
     
     // Door control
     bool door_locked;
     
-    // Temperature and fan control  
-    float current_temperature;
-    fan_level_t current_fan_level;
+    // Temperature and fan control (décimas de grado y de %, sin coma flotante)
+    int16_t current_temperature;
+    int16_t current_humidity;
+    uint8_t fan_duty;               // 0-100%, lo que recibe el PWM
     bool manual_fan_override;
+    fan_mode_t fan_mode;
+    fan_pid_t fan_pid;              // setpoint en décimas de grado
     
     // Display update flags
     bool display_update_needed;
+
+    // Uso de cada transición de la tabla, [estado][entrada][alternativa]
+    room_transition_stats_t transition_stats[ROOM_STATE_COUNT][ROOM_INPUT_COUNT][ROOM_FSM_ALTS];
 } room_control_t;
 
 // Public functions
 void room_control_init(room_control_t *room);
-void room_control_update(room_control_t *room);
-void room_control_process_key(room_control_t *room, char key);
-void room_control_set_temperature(room_control_t *room, float temperature);
-void room_control_force_fan_level(room_control_t *room, fan_level_t level);
-void room_control_change_password(room_control_t *room, const char *new_password);
+void room_control_handle_event(room_control_t *room, const room_event_t *event);
+void room_control_set_temperature(room_control_t *room, int16_t temperature);
+bool room_control_force_fan_level(room_control_t *room, fan_level_t level);
+void room_control_set_fan_mode(room_control_t *room, fan_mode_t mode);
+bool room_control_set_setpoint(room_control_t *room, int16_t setpoint);
+bool room_control_change_password(room_control_t *room, const char *new_password);
+room_input_t room_control_event_input(const room_event_t *event);
+bool room_control_get_transition_stats(room_control_t *room, room_state_t state, room_input_t input, uint8_t alt,
+                                       room_transition_stats_t *stats);
 
 // Status getters
 room_state_t room_control_get_state(room_control_t *room);
 bool room_control_is_door_locked(room_control_t *room);
-fan_level_t room_control_get_fan_level(room_control_t *room);
-float room_control_get_temperature(room_control_t *room);
+uint8_t room_control_get_fan_duty(room_control_t *room);
+fan_mode_t room_control_get_fan_mode(room_control_t *room);
+int16_t room_control_get_setpoint(room_control_t *room);
+int16_t room_control_get_temperature_tenths(room_control_t *room);
+int16_t room_control_get_humidity_tenths(room_control_t *room);
 
 #endif
\ No newline at end of file
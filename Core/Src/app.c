@@ -0,0 +1,273 @@
+#include "app.h"
+#include "led.h"
+#include "keypad.h"
+#include "dht11.h"
+#include "ssd1306.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+#include "fan_ramp.h"
+#include "commands.h"
+#include "scheduler.h"
+#include "lowpower.h"
+#include <string.h>
+
+// Handles de hardware definidos en main.c
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim3;
+extern TIM_HandleTypeDef htim6;
+extern UART_HandleTypeDef huart2;
+
+// Intervalo entre lecturas del DHT11: el periodo de muestreo del PID del ventilador
+#define DHT_READ_INTERVAL_MS TEMP_READ_INTERVAL_MS
+// Periodo del LED de heartbeat
+#define HEARTBEAT_PERIOD_MS  500
+// Rampa del ventilador: 50 periodos del PWM de 100 Hz, medio segundo de un nivel a otro
+#define FAN_RAMP_STEPS       50
+// Tras recibir por la consola no se entra en STOP2 durante este tiempo: USART2 no recibe en STOP2
+#define CONSOLE_HOLD_MS      30000
+// Teclas que, pulsadas a la vez, bloquean el sistema en modo emergencia
+#define EMERGENCY_CHORD      "*#"
+
+uint8_t button_pressed = 0;
+
+led_handle_t heartbeat_led = {
+    .port = LD2_GPIO_Port,
+    .pin = LD2_Pin
+};
+
+/// @brief Recepción por USART2: DMA circular + IDLE hacia el ring buffer, leída por líneas
+uart_rx_t uart2_rx;
+/// @brief Transmisión por USART2: cola en ring buffer enviada por DMA, nunca bloquea el bucle
+uart_tx_t uart2_tx;
+/// @brief Rampas del PWM del ventilador (TIM3 CH2) reproducidas por DMA
+fan_ramp_t fan_ramp;
+/// @brief Manejador del teclado
+/// @note Este manejador contiene la configuración de los pines del teclado y se inicializa
+///       en la función `keypad_init()`. El escaneo corre en la interrupción de TIM6 y deja
+///       los eventos en una cola que vacía keypad_task().
+keypad_handle_t keypad = {
+    .row_ports = {KEYPAD_R1_GPIO_Port, KEYPAD_R2_GPIO_Port, KEYPAD_R3_GPIO_Port, KEYPAD_R4_GPIO_Port},
+    .row_pins  = {KEYPAD_R1_Pin, KEYPAD_R2_Pin, KEYPAD_R3_Pin, KEYPAD_R4_Pin},
+    .col_ports = {KEYPAD_C1_GPIO_Port, KEYPAD_C2_GPIO_Port, KEYPAD_C3_GPIO_Port, KEYPAD_C4_GPIO_Port},
+    .col_pins  = {KEYPAD_C1_Pin, KEYPAD_C2_Pin, KEYPAD_C3_Pin, KEYPAD_C4_Pin}
+};
+
+room_control_t room_system;
+
+// Tareas periódicas en la rueda de temporizadores del scheduler
+static sched_timer_t heartbeat_timer;
+static sched_timer_t dht_read_timer;
+static sched_timer_t dht_poll_timer;
+
+static bool console_active;
+static uint32_t console_last_rx;
+
+// --- Tareas: corren en el bucle principal, cada una hasta terminar ---
+static void keypad_task(void *ctx, uint32_t arg);
+static void uart_rx_task(void *ctx, uint32_t arg);
+static void display_ready_task(void *ctx, uint32_t arg);
+
+/// @brief Salida de printf() y de stdout/stderr: se encola en uart2_tx en una sola copia
+/// @note  Nunca bloquea; si la cola está llena el mensaje se descarta (ver uart_tx.h).
+///        Reemplaza al _write débil de syscalls.c, que iba carácter a carácter.
+int _write(int file, char *ptr, int len)
+{
+    (void)file;
+    uart_tx_write(&uart2_tx, ptr, (uint16_t)len);
+    return len;
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    if (GPIO_Pin == B1_Pin) {
+        button_pressed = 1;
+    } else {
+        keypad_wake(&keypad);
+    }
+}
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim->Instance == TIM6 && keypad_tick(&keypad)) {
+        sched_post(keypad_task, NULL, 0);
+    } else if (htim->Instance == TIM3) {
+        // Fin de la transferencia DMA de la rampa (petición de update de TIM3)
+        fan_ramp_complete(&fan_ramp);
+    }
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    if (huart->Instance == USART2) {
+        uart_rx_event(&uart2_rx, Size);
+        sched_post(uart_rx_task, NULL, 0);
+    }
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART2) {
+        uart_tx_complete(&uart2_tx);
+    }
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance != USART2) {
+        return;
+    }
+    // Un error de DMA termina la transmisión (gState vuelve a READY): se descarta y se sigue con la cola
+    if (huart->gState == HAL_UART_STATE_READY) {
+        uart_tx_error(&uart2_tx);
+    }
+    // Overrun, ruido o error de trama paran el DMA de recepción (RxState vuelve a READY): se rearma
+    if (huart->RxState == HAL_UART_STATE_READY) {
+        uart_rx_restart(&uart2_rx);
+    }
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    ssd1306_I2C_TxCpltCallback(hi2c);
+    if (!ssd1306_IsBusy()) {
+        sched_post(display_ready_task, NULL, 0);
+    }
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    ssd1306_I2C_ErrorCallback(hi2c);
+    sched_post(display_ready_task, NULL, 0);
+}
+
+static void heartbeat_task(void *ctx, uint32_t arg)
+{
+    (void)ctx;
+    (void)arg;
+    led_toggle(&heartbeat_led);
+    // Una rampa cuyo DMA no termina a tiempo pasa directamente al valor final
+    fan_ramp_poll(&fan_ramp);
+}
+
+/// @brief Vacía la cola de eventos del teclado; cada pulsación llega a room_control como evento
+/// @note  Las sueltas y pulsaciones largas también están en la cola; room_control solo usa las pulsaciones.
+///        La pulsación que completa EMERGENCY_CHORD se entrega como ROOM_EVENT_EMERGENCY en su lugar.
+static void keypad_task(void *ctx, uint32_t arg)
+{
+    (void)ctx;
+    (void)arg;
+    const uint16_t chord = keypad_key_mask(EMERGENCY_CHORD);
+    keypad_event_t key_event;
+    while (keypad_get_event(&keypad, &key_event)) {
+        if (key_event.type == KEYPAD_EVENT_PRESS) {
+            const bool emergency = (key_event.keys & chord) == chord;
+            const room_event_t event = { .type = emergency ? ROOM_EVENT_EMERGENCY : ROOM_EVENT_KEY,
+                                         .key = key_event.key };
+            room_control_handle_event(&room_system, &event);
+        }
+    }
+}
+
+/// @brief Comandos recibidos por USART2
+/// @note Cada línea completa se interpreta con command_execute() y se responde por el mismo UART.
+static void uart_rx_task(void *ctx, uint32_t arg)
+{
+    (void)ctx;
+    (void)arg;
+    const char *line;
+    uint16_t line_len;
+    console_active = true;
+    console_last_rx = HAL_GetTick();
+    while ((line = uart_rx_read_line(&uart2_rx, &line_len)) != NULL) {
+        char reply[COMMAND_REPLY_MAX];
+        command_execute(&room_system, line, line_len, reply, sizeof(reply));
+        uart_tx_puts(&uart2_tx, reply);
+    }
+}
+
+static void display_ready_task(void *ctx, uint32_t arg)
+{
+    (void)ctx;
+    (void)arg;
+    const room_event_t event = { .type = ROOM_EVENT_DISPLAY_READY };
+    room_control_handle_event(&room_system, &event);
+}
+
+/// @brief Avanza la lectura en curso del DHT11 hasta que termina: al final del pulso de
+///        inicio y cada milisegundo de la captura, no en cada tick del pulso de 20 ms
+/// @note Si la trama es válida, la temperatura llega a room_control como evento.
+static void dht_poll_task(void *ctx, uint32_t arg)
+{
+    (void)ctx;
+    (void)arg;
+    DHT11_Process();
+    if (DHT11_IsBusy()) {
+        sched_timer_start(&dht_poll_timer, DHT11_NextPollMs(), 0);
+    }
+    int16_t temp, hum;
+    if (DHT11_GetNewData(&temp, &hum)) {
+        const room_event_t event = { .type = ROOM_EVENT_TEMPERATURE, .temperature = temp, .humidity = hum };
+        room_control_handle_event(&room_system, &event);
+    }
+}
+
+/// @brief Inicia una lectura del DHT11 cada DHT_READ_INTERVAL_MS
+static void dht_read_task(void *ctx, uint32_t arg)
+{
+    (void)ctx;
+    (void)arg;
+    if (DHT11_StartReading()) {
+        sched_timer_start(&dht_poll_timer, DHT11_NextPollMs(), 0);
+    }
+}
+
+/// @brief Veto de STOP2 (ver lowpower.h): en STOP2 se paran TIM3, TIM6, los DMA, I2C1 y USART2,
+///        así que solo se entra si ninguno está trabajando
+static bool app_stop_allowed(void)
+{
+    // Con el reloj parado la salida PWM queda congelada: solo 0% y 100% son niveles constantes
+    const uint32_t duty = __HAL_TIM_GET_COMPARE(&htim3, TIM_CHANNEL_2);
+    if (duty != 0 && duty <= __HAL_TIM_GET_AUTORELOAD(&htim3)) {
+        return false;
+    }
+    if (keypad_is_scanning(&keypad) || fan_ramp_is_busy(&fan_ramp) || ssd1306_IsBusy() || DHT11_IsBusy() ||
+        atomic_load(&uart2_tx.busy)) {
+        return false;
+    }
+    return !console_active || HAL_GetTick() - console_last_rx >= CONSOLE_HOLD_MS;
+}
+
+void app_init(void)
+{
+    // Contador de ciclos DWT: room_control mide con él cada transición
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    sched_init();
+    lowpower_init(app_stop_allowed);
+    sched_set_idle_hook(lowpower_idle);
+    led_init(&heartbeat_led);
+    ssd1306_Init();
+    keypad_init(&keypad, &htim6);
+    fan_ramp_init(&fan_ramp, &htim3, TIM_CHANNEL_2, FAN_RAMP_SCURVE, FAN_RAMP_STEPS);
+    room_control_init(&room_system);
+    DHT11_Init(&htim2);
+    if (!uart_rx_init(&uart2_rx, &huart2)) {
+        Error_Handler();
+    }
+    uart_tx_init(&uart2_tx, &huart2);
+
+    sched_timer_init(&heartbeat_timer, heartbeat_task, NULL);
+    sched_timer_start(&heartbeat_timer, HEARTBEAT_PERIOD_MS, HEARTBEAT_PERIOD_MS);
+    sched_timer_init(&dht_read_timer, dht_read_task, NULL);
+    sched_timer_start(&dht_read_timer, DHT_READ_INTERVAL_MS, DHT_READ_INTERVAL_MS);
+    sched_timer_init(&dht_poll_timer, dht_poll_task, NULL);
+
+    uart_tx_puts(&uart2_tx, "ROOM CONTROL ENABLE\r\n");
+}
+
+void app_loop_step(void)
+{
+    // Eventos de las interrupciones y temporizadores vencidos; sin trabajo, la CPU duerme
+    sched_run();
+    sched_idle();
+}
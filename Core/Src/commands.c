@@ -0,0 +1,195 @@
+#include "commands.h"
+#include "fmt.h"
+#include <string.h>
+
+typedef command_status_t (*command_handler_t)(room_control_t *room, const char *value, uint16_t value_len,
+                                              char *reply, size_t reply_max);
+
+typedef struct {
+    const char *name;
+    uint8_t len;
+    command_handler_t handler;
+} command_entry_t;
+
+#define COMMAND_DECLARE(name, handler) \
+    static command_status_t handler(room_control_t *room, const char *value, uint16_t value_len, \
+                                    char *reply, size_t reply_max);
+COMMAND_LIST(COMMAND_DECLARE)
+
+#define COMMAND_ENTRY(name, handler) { #name, sizeof(#name) - 1, handler },
+static const command_entry_t commands[] = { COMMAND_LIST(COMMAND_ENTRY) };
+
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+
+#ifdef COMMAND_USE_PERFECT_HASH
+#include "command_table.h"
+
+_Static_assert(COMMAND_TABLE_COUNT == COMMAND_COUNT, "command_table.h no corresponde a COMMAND_LIST");
+
+/// Hash de tools/command_hashgen.py: un paso FNV-1a por byte, los bits altos indexan la tabla
+static inline uint32_t command_hash(const char *name, uint16_t len)
+{
+    uint32_t h = COMMAND_HASH_SEED;
+    for (uint16_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)name[i]) * 0x01000193U;
+    }
+    return h >> (32 - COMMAND_TABLE_BITS);
+}
+#endif
+
+static const char *const state_names[] = {
+    [ROOM_STATE_LOCKED] = "LOCKED",
+    [ROOM_STATE_UNLOCKED] = "UNLOCKED",
+    [ROOM_STATE_INPUT_PASSWORD] = "INPUT_PASSWORD",
+    [ROOM_STATE_ACCESS_DENIED] = "ACCESS_DENIED",
+    [ROOM_STATE_EMERGENCY] = "EMERGENCY",
+};
+
+static const char *const status_errors[] = {
+    [COMMAND_UNKNOWN] = "ERROR:UNKNOWN_COMMAND\r\n",
+    [COMMAND_BAD_VALUE] = "ERROR:BAD_VALUE\r\n",
+    [COMMAND_NOT_ALLOWED] = "ERROR:NOT_ALLOWED\r\n",
+};
+
+/// Busca el comando: una sola comparación con la entrada que indica el hash
+static const command_entry_t *command_lookup(const char *name, uint16_t len)
+{
+#ifdef COMMAND_USE_PERFECT_HASH
+    const uint8_t slot = command_slots[command_hash(name, len)];
+    if (slot != 0) {
+        const command_entry_t *entry = &commands[slot - 1];
+        if (entry->len == len && memcmp(entry->name, name, len) == 0) {
+            return entry;
+        }
+    }
+#else
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        if (commands[i].len == len && memcmp(commands[i].name, name, len) == 0) {
+            return &commands[i];
+        }
+    }
+#endif
+    return NULL;
+}
+
+command_status_t command_execute(room_control_t *room, const char *line, uint16_t len,
+                                 char *reply, size_t reply_max)
+{
+    // "NOMBRE" o "NOMBRE:VALOR": el separador parte la línea sin copiarla
+    const char *colon = memchr(line, ':', len);
+    const uint16_t name_len = colon ? (uint16_t)(colon - line) : len;
+    const char *value = colon ? colon + 1 : line + len;
+    const uint16_t value_len = (uint16_t)(len - (value - line));
+
+    const command_entry_t *entry = command_lookup(line, name_len);
+    command_status_t status = entry ? entry->handler(room, value, value_len, reply, reply_max) : COMMAND_UNKNOWN;
+
+    if (status != COMMAND_OK) {
+        fmt_format(reply, reply_max, "%s", status_errors[status]);
+    }
+    return status;
+}
+
+static command_status_t command_get_temp(room_control_t *room, const char *value, uint16_t value_len,
+                                         char *reply, size_t reply_max)
+{
+    (void)value;
+    if (value_len != 0) {
+        return COMMAND_BAD_VALUE;
+    }
+    fmt_format(reply, reply_max, "TEMP:%t\r\n", room_control_get_temperature_tenths(room));
+    return COMMAND_OK;
+}
+
+static command_status_t command_get_status(room_control_t *room, const char *value, uint16_t value_len,
+                                           char *reply, size_t reply_max)
+{
+    (void)value;
+    if (value_len != 0) {
+        return COMMAND_BAD_VALUE;
+    }
+    fmt_format(reply, reply_max, "STATUS:%s,FAN:%d\r\n", state_names[room_control_get_state(room)],
+               (int)room_control_get_fan_duty(room));
+    return COMMAND_OK;
+}
+
+static command_status_t command_set_pass(room_control_t *room, const char *value, uint16_t value_len,
+                                         char *reply, size_t reply_max)
+{
+    char password[PASSWORD_LENGTH + 1];
+
+    // Solo dígitos, igual que la clave que se teclea en el keypad
+    if (value_len != PASSWORD_LENGTH) {
+        return COMMAND_BAD_VALUE;
+    }
+    for (uint16_t i = 0; i < PASSWORD_LENGTH; i++) {
+        if (value[i] < '0' || value[i] > '9') {
+            return COMMAND_BAD_VALUE;
+        }
+        password[i] = value[i];
+    }
+    password[PASSWORD_LENGTH] = '\0';
+    if (!room_control_change_password(room, password)) {
+        return COMMAND_BAD_VALUE;
+    }
+    fmt_format(reply, reply_max, "OK\r\n");
+    return COMMAND_OK;
+}
+
+static command_status_t command_force_fan(room_control_t *room, const char *value, uint16_t value_len,
+                                          char *reply, size_t reply_max)
+{
+    static const fan_level_t levels[] = { FAN_LEVEL_OFF, FAN_LEVEL_LOW, FAN_LEVEL_MED, FAN_LEVEL_HIGH };
+
+    if (value_len != 1 || value[0] < '0' || value[0] > '3') {
+        return COMMAND_BAD_VALUE;
+    }
+    if (!room_control_force_fan_level(room, levels[value[0] - '0'])) {
+        return COMMAND_NOT_ALLOWED;
+    }
+    fmt_format(reply, reply_max, "OK\r\n");
+    return COMMAND_OK;
+}
+
+/// "PID" o "STEP": control automático del ventilador; deja sin efecto un FORCE_FAN
+static command_status_t command_fan_mode(room_control_t *room, const char *value, uint16_t value_len,
+                                         char *reply, size_t reply_max)
+{
+    if (value_len == 3 && memcmp(value, "PID", 3) == 0) {
+        room_control_set_fan_mode(room, FAN_MODE_PID);
+    } else if (value_len == 4 && memcmp(value, "STEP", 4) == 0) {
+        room_control_set_fan_mode(room, FAN_MODE_STEP);
+    } else {
+        return COMMAND_BAD_VALUE;
+    }
+    fmt_format(reply, reply_max, "OK\r\n");
+    return COMMAND_OK;
+}
+
+/// Setpoint del PID en grados con un decimal opcional: "25" o "24.5"
+static command_status_t command_set_point(room_control_t *room, const char *value, uint16_t value_len,
+                                          char *reply, size_t reply_max)
+{
+    int16_t tenths = 0;
+    uint16_t i = 0;
+
+    // Como mucho dos cifras enteras: el rango válido lo decide room_control
+    for (; i < value_len && i < 2 && value[i] >= '0' && value[i] <= '9'; i++) {
+        tenths = (int16_t)(tenths * 10 + (value[i] - '0'));
+    }
+    tenths = (int16_t)(tenths * 10);
+    if (i == 0) {
+        return COMMAND_BAD_VALUE;
+    }
+    if (i < value_len) {
+        if (value_len != i + 2 || value[i] != '.' || value[i + 1] < '0' || value[i + 1] > '9') {
+            return COMMAND_BAD_VALUE;
+        }
+        tenths = (int16_t)(tenths + (value[i + 1] - '0'));
+    }
+    if (!room_control_set_setpoint(room, tenths)) {
+        return COMMAND_BAD_VALUE;
+    }
+    fmt_format(reply, reply_max, "OK\r\n");
+    return COMMAND_OK;
+}
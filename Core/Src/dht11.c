@@ -3,44 +3,42 @@
 
 //--- Umbrales de tiempo en microsegundos (µs) ---
 #define START_PULLDOWN_MS            20    // 20ms de pulso de inicio
+#define RESPONSE_MIN_US              60    // Pulsos de respuesta: 80us nominales
 #define RESPONSE_TIMEOUT_US          100   // Timeout para la respuesta inicial del sensor
+#define BIT_LOW_MIN_US               30    // Pulso bajo que precede a cada bit: 50us nominales
 #define BIT_READ_TIMEOUT_US          120   // Timeout máximo para leer un pulso
 #define BIT_HIGH_PULSE_THRESHOLD_US  45    // Umbral para decidir entre '0' y '1'. (Un '0' dura ~28us, un '1' ~70us)
 
-//--- Máquina de Estados Simplificada ---
-/// Esta máquina de estados simplificada maneja la lectura del DHT11 en un solo estado de lectura de bits.
-/// Se inicia con un pulso de inicio, espera la respuesta del sensor y luego lee todos
-/// los bits de una sola vez, lo que es más fiable y rápido que leer bit a bit.
+//--- Captura de la trama ---
+#define FRAME_TIMEOUT_MS             8     // Una trama dura ~5ms como máximo
+#define EDGE_BUFFER_SIZE             (DHT11_FRAME_EDGES + 8)  // Margen para flancos espurios
+
+//--- Máquina de Estados ---
+/// Tras el pulso de inicio el pin pasa a TIM2_CH1: el timer captura cada flanco y el DMA
+/// guarda su marca de tiempo en `edge_buffer`. La CPU no espera al sensor; cuando hay
+/// flancos suficientes (o vence el timeout) se decodifica la trama entera.
 
 typedef enum {
     DHT11_STATE_IDLE,
     DHT11_STATE_START_PULLDOWN,
-    DHT11_STATE_START_PULLUP,
-    DHT11_STATE_WAIT_RESPONSE_LOW,
-    DHT11_STATE_WAIT_RESPONSE_HIGH,
-    DHT11_STATE_READ_BITS,          // CAMBIO CLAVE: Un solo estado para leer todos los bits
-    DHT11_STATE_COMPLETE,
-    DHT11_STATE_ERROR
+    DHT11_STATE_CAPTURE             // El DMA recoge los flancos de la trama
 } DHT11_State_t;
 
-/// @brief Estructura para manejar el DHT11
-/// @note Esta estructura contiene el estado actual, el temporizador y los datos leídos
-///       Se inicializa en la función `DHT11_Init()`.
-/// @note El estado se maneja mediante una máquina de estados simplificada.
-///       La lectura de bits se hace en un solo estado para mayor fiabilidad.
+/// @brief Estado del driver del DHT11
+/// @note Se inicializa en la función `DHT11_Init()`.
 static TIM_HandleTypeDef* dht_timer;
 static DHT11_State_t current_state = DHT11_STATE_IDLE;
 
 static uint32_t last_event_time_ms = 0;
-static uint16_t last_event_time_us = 0;
+static uint32_t edge_buffer[EDGE_BUFFER_SIZE];
 
-static float last_temperature = 0.0f;
-static float last_humidity = 0.0f;
+static int16_t last_temperature = 0;    // décimas de grado
+static int16_t last_humidity = 0;       // décimas de %
 static bool data_ready_flag = false;
 
 // --- Funciones auxiliares de Pin ---
-/// Estas funciones configuran el pin del DHT11 como salida o entrada
-/// y establecen el pull-up necesario.
+/// Estas funciones configuran el pin del DHT11 como salida, entrada o entrada de captura
+/// del timer, y establecen el pull-up necesario.
 /// Estas funciones son llamadas por la máquina de estados para cambiar el modo del pin
 /// según sea necesario.
 static void DHT11_Set_Pin_Output(void) {
@@ -59,8 +57,27 @@ static void DHT11_Set_Pin_Input(void) {
     HAL_GPIO_Init(DHT11_PORT, &GPIO_InitStruct);
 }
 
+// Open-drain: el canal está en captura y nunca conduce la línea
+static void DHT11_Set_Pin_Capture(void) {
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    GPIO_InitStruct.Pin = DHT11_PIN;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_OD;
+    GPIO_InitStruct.Pull = GPIO_PULLUP;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = DHT11_PIN_AF;
+    HAL_GPIO_Init(DHT11_PORT, &GPIO_InitStruct);
+}
+
+// Flancos que el DMA ya ha copiado en edge_buffer
+static uint32_t captured_edges(void) {
+    return EDGE_BUFFER_SIZE - __HAL_DMA_GET_COUNTER(dht_timer->hdma[TIM_DMA_ID_CC1]);
+}
+
 // Función para reiniciar el estado en caso de error o finalización
 static void reset_to_idle(void) {
+    if (current_state == DHT11_STATE_CAPTURE) {
+        HAL_TIM_IC_Stop_DMA(dht_timer, DHT11_TIM_CHANNEL);
+    }
     current_state = DHT11_STATE_IDLE;
     // Dejar el pin en modo input con pull-up es más seguro que output-high
     // para no interferir si otro dispositivo comparte la línea (aunque aquí no sea el caso).
@@ -70,7 +87,6 @@ static void reset_to_idle(void) {
 // --- Funciones Públicas ---
 void DHT11_Init(TIM_HandleTypeDef *htim) {
     dht_timer = htim;
-    HAL_TIM_Base_Start(dht_timer);
     reset_to_idle();
 }
 
@@ -89,7 +105,17 @@ bool DHT11_StartReading(void) {
 
 bool DHT11_IsDataReady(void) { return data_ready_flag; }
 
-bool DHT11_GetNewData(float* temperature, float* humidity) {
+bool DHT11_IsBusy(void) { return current_state != DHT11_STATE_IDLE; }
+
+uint32_t DHT11_NextPollMs(void) {
+    if (current_state == DHT11_STATE_START_PULLDOWN) {
+        uint32_t elapsed = HAL_GetTick() - last_event_time_ms;
+        return (elapsed < START_PULLDOWN_MS) ? START_PULLDOWN_MS - elapsed : 1;
+    }
+    return (current_state == DHT11_STATE_CAPTURE) ? 1 : 0;
+}
+
+bool DHT11_GetNewData(int16_t* temperature, int16_t* humidity) {
     if (data_ready_flag) {
         *temperature = last_temperature;
         *humidity = last_humidity;
@@ -99,106 +125,100 @@ bool DHT11_GetNewData(float* temperature, float* humidity) {
     return false;
 }
 
-// *** CAMBIO CLAVE: Función de lectura de bits bloqueante ***
-// Esta función se llama una sola vez y lee los 40 bits de golpe.
-// Es mucho más fiable por ser bloqueante, pero suficientemente rápida (<5ms).
-static bool read_data_bits(uint8_t* data_out) {
-    memset(data_out, 0, 5);
+static bool in_range(uint32_t value, uint32_t min, uint32_t max) {
+    return value >= min && value <= max;
+}
 
-    for (int i = 0; i < 40; i++) {
-        uint16_t start_time;
-        uint16_t duration;
+DHT11_DecodeStatus_t DHT11_DecodeEdges(const uint32_t *edges, uint32_t count, uint8_t data_out[5]) {
+    uint32_t i = 0;
 
-        // 1. Esperar a que el pin baje (inicio del pulso de sync de 50us)
-        start_time = __HAL_TIM_GET_COUNTER(dht_timer);
-        while (HAL_GPIO_ReadPin(DHT11_PORT, DHT11_PIN) == GPIO_PIN_SET) {
-            duration = __HAL_TIM_GET_COUNTER(dht_timer) - start_time;
-            if (duration > BIT_READ_TIMEOUT_US) return false; // Timeout
-        }
+    memset(data_out, 0, 5);
 
-        // 2. Esperar a que el pin suba (fin del pulso de sync, inicio del pulso de datos)
-        start_time = __HAL_TIM_GET_COUNTER(dht_timer);
-        while (HAL_GPIO_ReadPin(DHT11_PORT, DHT11_PIN) == GPIO_PIN_RESET) {
-            duration = __HAL_TIM_GET_COUNTER(dht_timer) - start_time;
-            if (duration > BIT_READ_TIMEOUT_US) return false; // Timeout
-        }
+    // 1. Buscar la respuesta: 80us en bajo seguidos de 80us en alto. Puede haber flancos
+    //    previos (p. ej. el de soltar la línea) si la captura empezó antes.
+    while (i + 2 < count &&
+           !(in_range(edges[i + 1] - edges[i], RESPONSE_MIN_US, RESPONSE_TIMEOUT_US) &&
+             in_range(edges[i + 2] - edges[i + 1], RESPONSE_MIN_US, RESPONSE_TIMEOUT_US))) {
+        i++;
+    }
+    if (i + 2 >= count) {
+        return DHT11_DECODE_NO_RESPONSE;
+    }
+    i += 2; // edges[i]: bajada que abre el primer bit
 
-        // 3. Medir la duración del pulso alto (el dato en sí)
-        start_time = __HAL_TIM_GET_COUNTER(dht_timer);
-        while (HAL_GPIO_ReadPin(DHT11_PORT, DHT11_PIN) == GPIO_PIN_SET) {
-            duration = __HAL_TIM_GET_COUNTER(dht_timer) - start_time;
-            if (duration > BIT_READ_TIMEOUT_US) return false; // Timeout
+    // 2. Cada bit: pulso bajo de ~50us y pulso alto cuya duración da el valor
+    if (count - i < 40 * 2 + 1) {
+        return DHT11_DECODE_SHORT_FRAME;
+    }
+    for (uint32_t bit = 0; bit < 40; bit++, i += 2) {
+        uint32_t low = edges[i + 1] - edges[i];
+        uint32_t high = edges[i + 2] - edges[i + 1];
+        if (!in_range(low, BIT_LOW_MIN_US, BIT_READ_TIMEOUT_US) || high > BIT_READ_TIMEOUT_US) {
+            return DHT11_DECODE_BAD_PULSE;
         }
-
-        // Clasificar el bit y guardarlo
-        data_out[i / 8] <<= 1;
-        if (duration > BIT_HIGH_PULSE_THRESHOLD_US) {
-            data_out[i / 8] |= 1;
+        data_out[bit / 8] <<= 1;
+        if (high > BIT_HIGH_PULSE_THRESHOLD_US) {
+            data_out[bit / 8] |= 1;
         }
     }
-    return true;
+
+    // 3. Verificación del Checksum
+    uint8_t sum = data_out[0] + data_out[1] + data_out[2] + data_out[3];
+    return (sum == data_out[4]) ? DHT11_DECODE_OK : DHT11_DECODE_CHECKSUM;
 }
 
 /// @brief Procesa la lectura del DHT11
 /// @param None
-/// @note Esta función procesa los datos del DHT11 y actualiza la temperatura en el sistema de control de habitación
-///       Si los datos están listos, actualiza la temperatura en el sistema de control de habitación.
-///       Si la lectura es exitosa, actualiza la temperatura en el sistema de control de la habitación.
+/// @note Esta función avanza la máquina de estados sin bloquear: suelta la línea tras el pulso
+///       de inicio, arranca la captura por DMA y, cuando la trama está completa, la decodifica.
+///       Si la lectura es exitosa, deja la temperatura y humedad listas para DHT11_GetNewData().
 void DHT11_Process(void) {
-    uint16_t current_time_us = __HAL_TIM_GET_COUNTER(dht_timer);
-    uint16_t elapsed_us = current_time_us - last_event_time_us;
-
     switch (current_state) {
         case DHT11_STATE_IDLE:
             break;
 
         case DHT11_STATE_START_PULLDOWN:
             if (HAL_GetTick() - last_event_time_ms >= START_PULLDOWN_MS) {
-                DHT11_Set_Pin_Input(); // Soltar el pin
-                last_event_time_us = __HAL_TIM_GET_COUNTER(dht_timer);
-                current_state = DHT11_STATE_WAIT_RESPONSE_LOW;
+                DHT11_Set_Pin_Capture(); // Soltar el pin y entregarlo al timer
+                if (HAL_TIM_IC_Start_DMA(dht_timer, DHT11_TIM_CHANNEL, edge_buffer, EDGE_BUFFER_SIZE) != HAL_OK) {
+                    reset_to_idle();
+                    break;
+                }
+                last_event_time_ms = HAL_GetTick();
+                current_state = DHT11_STATE_CAPTURE;
             }
             break;
 
-        case DHT11_STATE_WAIT_RESPONSE_LOW:
-            if (HAL_GPIO_ReadPin(DHT11_PORT, DHT11_PIN) == GPIO_PIN_RESET) {
-                last_event_time_us = __HAL_TIM_GET_COUNTER(dht_timer);
-                current_state = DHT11_STATE_WAIT_RESPONSE_HIGH;
-            } else if (elapsed_us > RESPONSE_TIMEOUT_US) {
-                reset_to_idle();
+        case DHT11_STATE_CAPTURE:
+        {
+            uint32_t edges = captured_edges();
+            bool timeout = (HAL_GetTick() - last_event_time_ms) > FRAME_TIMEOUT_MS;
+            if (edges < DHT11_FRAME_EDGES && !timeout) {
+                break;
             }
-            break;
 
-        case DHT11_STATE_WAIT_RESPONSE_HIGH:
-            if (HAL_GPIO_ReadPin(DHT11_PORT, DHT11_PIN) == GPIO_PIN_SET) {
-                // Respuesta del sensor recibida, ahora leemos todos los bits
-                current_state = DHT11_STATE_READ_BITS;
-            } else if (elapsed_us > RESPONSE_TIMEOUT_US) {
-                reset_to_idle();
-            }
-            break;
-
-        case DHT11_STATE_READ_BITS:
-        {
             uint8_t data_bytes[5];
-            if (read_data_bits(data_bytes)) {
-                // Verificación del Checksum
-                uint8_t sum = data_bytes[0] + data_bytes[1] + data_bytes[2] + data_bytes[3];
-                if (sum == data_bytes[4]) {
-                    // Datos válidos
-                    last_humidity    = (float)data_bytes[0] + ((float)data_bytes[1] * 0.1f);
-                    last_temperature = (float)data_bytes[2] + ((float)data_bytes[3] * 0.1f);
-                    data_ready_flag = true;
+            DHT11_DecodeStatus_t status = DHT11_DecodeEdges(edge_buffer, edges, data_bytes);
+            if (status == DHT11_DECODE_SHORT_FRAME && !timeout && edges < EDGE_BUFFER_SIZE) {
+                break; // Hubo flancos de más al principio; esperar al resto de la trama
+            }
+            if (status == DHT11_DECODE_OK) {
+                // Datos válidos: parte entera y décimas a décimas, en enteros. El bit 7 del
+                // decimal de temperatura marca los valores bajo cero
+                last_humidity    = (int16_t)(data_bytes[0] * 10 + data_bytes[1]);
+                last_temperature = (int16_t)(data_bytes[2] * 10 + (data_bytes[3] & 0x7F));
+                if (data_bytes[3] & 0x80) {
+                    last_temperature = (int16_t)-last_temperature;
                 }
+                data_ready_flag = true;
             }
             // Haya funcionado o no, la lectura ha terminado. Volvemos a idle.
             reset_to_idle();
         }
             break;
 
-        // Los estados COMPLETE y ERROR ya no son necesarios, se manejan dentro de READ_BITS
         default:
             reset_to_idle();
             break;
     }
-}
\ No newline at end of file
+}
@@ -21,15 +21,7 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-#include "led.h"
-#include "keypad.h"
-#include "ring_buffer.h"
-#include "dht11.h"
-#include "room_control.h"
-#include <stdio.h>
-#include <string.h>
-#include "ssd1306.h"
-#include "ssd1306_fonts.h"
+#include "app.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -46,33 +38,21 @@
 
 /* Private variables ---------------------------------------------------------*/
 I2C_HandleTypeDef hi2c1;
+DMA_HandleTypeDef hdma_i2c1_tx;
+
 TIM_HandleTypeDef htim3;
-TIM_HandleTypeDef htim6; // Declaración para TIM6, necesaria para el DHT11
-DMA_HandleTypeDef hdma_tim3_ch2;
+TIM_HandleTypeDef htim6;
+DMA_HandleTypeDef hdma_tim3_up;
+
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
 
 /* USER CODE BEGIN PV */
-uint8_t button_pressed = 0;
-
-led_handle_t heartbeat_led = {
-    .port = LD2_GPIO_Port,
-    .pin = LD2_Pin
-};
-
-uint8_t usart_2_rxbyte = 0;
-/// @brief Manejador del teclado
-/// @note Este manejador contiene la configuración de los pines del teclado y se inicializa
-///       en la función `keypad_init()`.
-keypad_handle_t keypad = {
-    .row_ports = {KEYPAD_R1_GPIO_Port, KEYPAD_R2_GPIO_Port, KEYPAD_R3_GPIO_Port, KEYPAD_R4_GPIO_Port},
-    .row_pins  = {KEYPAD_R1_Pin, KEYPAD_R2_Pin, KEYPAD_R3_Pin, KEYPAD_R4_Pin},
-    .col_ports = {KEYPAD_C1_GPIO_Port, KEYPAD_C2_GPIO_Port, KEYPAD_C3_GPIO_Port, KEYPAD_C4_GPIO_Port},
-    .col_pins  = {KEYPAD_C1_Pin, KEYPAD_C2_Pin, KEYPAD_C3_Pin, KEYPAD_C4_Pin}
-};
-
-volatile uint16_t keypad_interrupt_pin = 0;
-
-room_control_t room_system;
+// TIM2_CH1 (PA5): captura de los flancos del DHT11. PA5 es también LD2 en el .ioc,
+// así que CubeMX no puede generar el canal de captura: se inicializa aquí a mano.
+TIM_HandleTypeDef htim2;
+DMA_HandleTypeDef hdma_tim2_ch1;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -85,34 +65,11 @@ static void MX_TIM3_Init(void);
 static void MX_TIM6_Init(void);
 
 /* USER CODE BEGIN PFP */
+static void MX_TIM2_Init(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
-{
-  if (GPIO_Pin == B1_Pin) {
-    button_pressed = 1;
-  } else {
-    keypad_interrupt_pin = GPIO_Pin;
-  }
-}
-
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
-{
-  if (huart->Instance == USART2) {
-    HAL_UART_Receive_IT(&huart2, &usart_2_rxbyte, 1);
-  }
-}
-
-void heartbeat(void)
-{
-  static uint32_t last_toggle = 0;
-  if (HAL_GetTick() - last_toggle >= 500) {
-    led_toggle(&heartbeat_led);
-    last_toggle = HAL_GetTick();
-  }
-}
 /* USER CODE END 0 */
 
 /**
@@ -134,63 +91,16 @@ int main(void)
   MX_TIM6_Init();
 
   /* USER CODE BEGIN 2 */
-  led_init(&heartbeat_led);
-  ssd1306_Init();
-  keypad_init(&keypad);
-  room_control_init(&room_system);
-  DHT11_Init(&htim6);
-
-  char* startup_msg = "ROOM CONTROL ENABLE\r\n";
-  HAL_UART_Transmit(&huart2, (uint8_t*)startup_msg, strlen(startup_msg), 100);
+  MX_TIM2_Init();
+  // Aplicación: estado global, callbacks y bucle principal en app.c
+  app_init();
   /* USER CODE END 2 */
 
   /* Infinite loop */
-  
-  uint32_t last_dht_read_time = 0;
-  const uint32_t DHT_READ_INTERVAL_MS = 2000;
-
+  /* USER CODE BEGIN WHILE */
   while (1)
   {
-    /// @brief Bucle principal del programa
-    ///       Este bucle se ejecuta continuamente y maneja la lógica del sistema de control de habitación,
-    ///       incluyendo la actualización del estado del sistema, la lectura del DHT11, el escaneo del teclado
-    ///       y la actualización del display OLED.
-    heartbeat();
-    room_control_update(&room_system);
-
-    // --- Lógica del DHT11 ---
-    /// @brief Lógica del DHT11
-    /// @note Esta función inicia la lectura del DHT11 y procesa los datos cada cierto intervalo de tiempo
-    ///       el cual es DHT_READ_INTERVAL_MS.
-    if (HAL_GetTick() - last_dht_read_time >= DHT_READ_INTERVAL_MS) {
-        if (DHT11_StartReading()) {
-            last_dht_read_time = HAL_GetTick();
-        }
-    }
-    // Procesar la lectura del DHT11
-    /// @brief Procesa la lectura del DHT11
-    /// @note Esta función procesa los datos del DHT11 y actualiza la temperatura en el sistema de control de habitación
-    ///       Si los datos están listos, actualiza la temperatura en el sistema de control de habitación.
-    ///       Si la lectura es exitosa, actualiza la temperatura en el sistema de control de habitación.
-    DHT11_Process();
-    if (DHT11_IsDataReady()) {
-        float temp, hum;
-        if (DHT11_GetNewData(&temp, &hum)) {
-            room_control_set_temperature(&room_system, temp);
-        }
-    }
-
-    // --- Lógica del Keypad ---
-    /// @brief Lógica del teclado
-    /// @note Esta función escanea el teclado y procesa las teclas presionadas
-
-    if (keypad_interrupt_pin != 0) {
-      char key = keypad_scan(&keypad, keypad_interrupt_pin);
-      if (key != '\0') {
-         room_control_process_key(&room_system, key);
-      }
-      keypad_interrupt_pin = 0;
-    }
+    app_loop_step();
     /* USER CODE END WHILE */
     /* USER CODE BEGIN 3 */
   }
@@ -306,9 +216,9 @@ static void MX_TIM6_Init(void)
 {
   TIM_MasterConfigTypeDef sMasterConfig = {0};
   htim6.Instance = TIM6;
-  htim6.Init.Prescaler = 80 - 1;
+  htim6.Init.Prescaler = 8000 - 1;
   htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
-  htim6.Init.Period = 65535;
+  htim6.Init.Period = 10 - 1;
   htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
   if (HAL_TIM_Base_Init(&htim6) != HAL_OK)
   {
@@ -350,11 +260,21 @@ static void MX_DMA_Init(void)
 {
   /* DMA controller clock enable */
   __HAL_RCC_DMA1_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
 
   /* DMA interrupt init */
-  // << CAMBIO: Se habilita la interrupción para el Canal 4 del DMA, que corresponde a TIM3_CH2.
-  HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 0, 0);
-  HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+  /* DMA1_Channel3_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+  /* DMA1_Channel6_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel6_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel6_IRQn);
+  /* DMA1_Channel7_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
+  /* DMA2_Channel7_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA2_Channel7_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Channel7_IRQn);
 }
 
 /**
@@ -421,6 +341,40 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+/**
+  * @brief TIM2 Initialization Function
+  */
+static void MX_TIM2_Init(void)
+{
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+  TIM_IC_InitTypeDef sConfigIC = {0};
+  htim2.Instance = TIM2;
+  htim2.Init.Prescaler = 80 - 1; // 1MHz: 1 tick = 1us
+  htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim2.Init.Period = 0xFFFFFFFF;
+  htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_IC_Init(&htim2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  // Captura en ambos flancos: el DHT11 codifica cada bit en la duración del pulso alto
+  sConfigIC.ICPolarity = TIM_INPUTCHANNELPOLARITY_BOTHEDGE;
+  sConfigIC.ICSelection = TIM_ICSELECTION_DIRECTTI;
+  sConfigIC.ICPrescaler = TIM_ICPSC_DIV1;
+  sConfigIC.ICFilter = 0;
+  if (HAL_TIM_IC_ConfigChannel(&htim2, &sConfigIC, TIM_CHANNEL_1) != HAL_OK)
+  {
+    Error_Handler();
+  }
+}
+
 /* USER CODE END 4 */
 
 /**
@@ -1,38 +1,158 @@
 #include "room_control.h"
 #include "ssd1306.h"
 #include "ssd1306_fonts.h"
+#include "uart_tx.h"
+#include "fan_ramp.h"
+#include "fmt.h"
 #include <string.h>
-#include <stdio.h>
 
 // Extern handles for hardware
-extern TIM_HandleTypeDef htim3;
-extern UART_HandleTypeDef huart2;
+extern uart_tx_t uart2_tx;
+extern fan_ramp_t fan_ramp;
 
-// Hardware mapping
-#define FAN_PWM_TIMER           htim3
-#define FAN_PWM_CHANNEL         TIM_CHANNEL_2
+// Hardware mapping (el PWM del ventilador, TIM3 CH2, lo maneja fan_ramp)
 #define DOOR_LOCK_GPIO_Port     DOOR_STATUS_GPIO_Port
 #define DOOR_LOCK_Pin           DOOR_STATUS_Pin
 
 // System constants
 static const char DEFAULT_PASSWORD[] = "0000";
 
-// Temperature thresholds for automatic fan control
-static const float TEMP_THRESHOLD_LOW = 25.0f;
-static const float TEMP_THRESHOLD_MED = 28.0f;
-static const float TEMP_THRESHOLD_HIGH = 31.0f;
+// Temperature thresholds for automatic fan control, en décimas de grado
+static const int16_t TEMP_THRESHOLD_LOW = 250;
+static const int16_t TEMP_THRESHOLD_MED = 280;
+static const int16_t TEMP_THRESHOLD_HIGH = 310;
+// Histéresis: una lectura a 0.5 °C o menos de la actual se ignora
+static const int16_t TEMP_HYSTERESIS = 5;
+// Escala del reloj de temperatura en el display, en décimas de grado
+static const int16_t DIAL_TEMP_MIN = 100;
+static const int16_t DIAL_TEMP_MAX = 400;
+
+// Setpoint del PID, en décimas de grado, y el rango que acepta SET_POINT
+static const int16_t SETPOINT_DEFAULT = 250;
+static const int16_t SETPOINT_MIN = 150;
+static const int16_t SETPOINT_MAX = 350;
+
+// PI del ventilador, una actualización por lectura del DHT11. Sintonía sobre la planta
+// térmica del simulador (Sim/Src/sim_thermal.c): lambda de 10 min sobre su constante de
+// tiempo de ~25 min con el ventilador a un 30%. Una décima de lectura son 2.4% de P: con
+// pasos mínimos del 4% el ruido del último dígito no mueve el PWM en cada muestra
+static const fan_pid_config_t FAN_PID_CONFIG = {
+    .kp = FAN_PID_Q16(24.0),        // % por °C
+    .ki = FAN_PID_Q16(0.016),       // % por °C y segundo: tiempo integral de 25 min
+    .kd = 0,
+    .sample_ms = TEMP_READ_INTERVAL_MS,
+    .min_step = 4,
+};
 
 // Timeouts in milliseconds
 static const uint32_t INPUT_TIMEOUT_MS = 20000;  // 20 seconds
 static const uint32_t ACCESS_DENIED_TIMEOUT_MS = 5000;  // 5 seconds
 
 // Private function prototypes
+static void room_control_dispatch(room_control_t *room, const room_event_t *event);
 static void room_control_change_state(room_control_t *room, room_state_t new_state);
 static void room_control_update_display(room_control_t *room);
+static void room_control_draw_gauge(uint8_t x, int32_t value, int32_t min, int32_t max, char *label);
 static void room_control_update_door(room_control_t *room);
 static void room_control_update_fan_pwm(room_control_t *room);
-static fan_level_t room_control_calculate_fan_level(float temperature);
+static void room_control_set_fan_duty(room_control_t *room, uint8_t duty);
+static fan_level_t room_control_calculate_fan_level(int16_t temperature);
 static void room_control_clear_input(room_control_t *room);
+static void room_control_refresh_display(room_control_t *room);
+static void room_control_on_timer(void *ctx, uint32_t arg);
+
+// --- Máquina de estados ---
+// Cada celda [estado][entrada] lista hasta ROOM_FSM_ALTS transiciones; se toma la primera
+// cuya guarda se cumple (sin guarda: siempre). Al tomarla se entra al estado siguiente
+// (acciones de entrada de room_entry_actions) y luego se ejecuta su acción. Una celda
+// vacía ignora el evento. El despacho es un acceso a la tabla más, como mucho, tres guardas.
+typedef bool (*room_guard_fn_t)(const room_control_t *room, const room_event_t *event);
+typedef void (*room_action_fn_t)(room_control_t *room, const room_event_t *event);
+
+typedef struct {
+    room_guard_fn_t guard;      // NULL: siempre
+    room_action_fn_t action;    // NULL: ninguna
+    room_state_t next;          // ROOM_STAY: sin cambio de estado
+    bool used;                  // false: fin de la celda
+} room_transition_t;
+
+#define ROOM_STAY ROOM_STATE_COUNT
+#define ROOM_ROW(guard, action, next) { (guard), (action), (next), true }
+
+static bool room_guard_password_ok(const room_control_t *room, const room_event_t *event);
+static bool room_guard_password_complete(const room_control_t *room, const room_event_t *event);
+static bool room_guard_input_timed_out(const room_control_t *room, const room_event_t *event);
+static bool room_guard_denied_elapsed(const room_control_t *room, const room_event_t *event);
+static bool room_guard_in_emergency(const room_control_t *room, const room_event_t *event);
+static bool room_guard_input_timed_out_in_emergency(const room_control_t *room, const room_event_t *event);
+static bool room_guard_denied_elapsed_in_emergency(const room_control_t *room, const room_event_t *event);
+static void room_action_append_digit(room_control_t *room, const room_event_t *event);
+static void room_action_touch_input(room_control_t *room, const room_event_t *event);
+static void room_action_temperature(room_control_t *room, const room_event_t *event);
+
+static void room_enter_locked(room_control_t *room);
+static void room_enter_unlocked(room_control_t *room);
+static void room_enter_input_password(room_control_t *room);
+static void room_enter_access_denied(room_control_t *room);
+static void room_enter_emergency(room_control_t *room);
+
+// En todos los estados: la temperatura se aplica y el acorde de emergencia bloquea
+#define ROOM_ROWS_ANY_STATE \
+    [ROOM_INPUT_TEMPERATURE] = { ROOM_ROW(NULL, room_action_temperature, ROOM_STAY) }, \
+    [ROOM_INPUT_EMERGENCY]   = { ROOM_ROW(NULL, NULL, ROOM_STATE_EMERGENCY) }
+
+static const room_transition_t room_transitions[ROOM_STATE_COUNT][ROOM_INPUT_COUNT][ROOM_FSM_ALTS] = {
+    [ROOM_STATE_LOCKED] = {
+        // Cualquier dígito empieza el ingreso de clave y cuenta como su primera tecla
+        [ROOM_INPUT_DIGIT] = { ROOM_ROW(NULL, room_action_append_digit, ROOM_STATE_INPUT_PASSWORD) },
+        ROOM_ROWS_ANY_STATE,
+    },
+    [ROOM_STATE_INPUT_PASSWORD] = {
+        // La última tecla valida la clave; las anteriores se acumulan. Si el ingreso empezó
+        // en EMERGENCY, cancelar, el timeout y el acceso denegado vuelven a EMERGENCY
+        [ROOM_INPUT_DIGIT] = {
+            ROOM_ROW(room_guard_password_ok, NULL, ROOM_STATE_UNLOCKED),
+            ROOM_ROW(room_guard_password_complete, NULL, ROOM_STATE_ACCESS_DENIED),
+            ROOM_ROW(NULL, room_action_append_digit, ROOM_STAY),
+        },
+        [ROOM_INPUT_STAR]    = { ROOM_ROW(NULL, room_action_touch_input, ROOM_STAY) },
+        [ROOM_INPUT_HASH]    = {                                                // cancelar
+            ROOM_ROW(room_guard_in_emergency, NULL, ROOM_STATE_EMERGENCY),
+            ROOM_ROW(NULL, NULL, ROOM_STATE_LOCKED),
+        },
+        [ROOM_INPUT_KEY]     = { ROOM_ROW(NULL, room_action_touch_input, ROOM_STAY) },
+        [ROOM_INPUT_TIMEOUT] = {
+            ROOM_ROW(room_guard_input_timed_out_in_emergency, NULL, ROOM_STATE_EMERGENCY),
+            ROOM_ROW(room_guard_input_timed_out, NULL, ROOM_STATE_LOCKED),
+        },
+        ROOM_ROWS_ANY_STATE,
+    },
+    [ROOM_STATE_UNLOCKED] = {
+        [ROOM_INPUT_STAR] = { ROOM_ROW(NULL, NULL, ROOM_STATE_LOCKED) },
+        ROOM_ROWS_ANY_STATE,
+    },
+    [ROOM_STATE_ACCESS_DENIED] = {
+        [ROOM_INPUT_TIMEOUT] = {
+            ROOM_ROW(room_guard_denied_elapsed_in_emergency, NULL, ROOM_STATE_EMERGENCY),
+            ROOM_ROW(room_guard_denied_elapsed, NULL, ROOM_STATE_LOCKED),
+        },
+        ROOM_ROWS_ANY_STATE,
+    },
+    [ROOM_STATE_EMERGENCY] = {
+        // Solo la clave correcta vuelve a abrir; repetir el acorde no hace nada
+        [ROOM_INPUT_DIGIT]       = { ROOM_ROW(NULL, room_action_append_digit, ROOM_STATE_INPUT_PASSWORD) },
+        [ROOM_INPUT_TEMPERATURE] = { ROOM_ROW(NULL, room_action_temperature, ROOM_STAY) },
+    },
+};
+
+// Acciones de entrada de cada estado, las ejecuta room_control_change_state()
+static void (*const room_entry_actions[ROOM_STATE_COUNT])(room_control_t *room) = {
+    [ROOM_STATE_LOCKED] = room_enter_locked,
+    [ROOM_STATE_UNLOCKED] = room_enter_unlocked,
+    [ROOM_STATE_INPUT_PASSWORD] = room_enter_input_password,
+    [ROOM_STATE_ACCESS_DENIED] = room_enter_access_denied,
+    [ROOM_STATE_EMERGENCY] = room_enter_emergency,
+};
 
 void room_control_init(room_control_t *room) {
     // Initialize room control structure
@@ -40,167 +160,183 @@ void room_control_init(room_control_t *room) {
     strcpy(room->password, DEFAULT_PASSWORD);
     room->current_state = ROOM_STATE_LOCKED;
     room->state_enter_time = HAL_GetTick();
+    sched_timer_init(&room->state_timer, room_control_on_timer, room);
     
     // Initialize door control
     room->door_locked = true;
     
     // Initialize temperature and fan
-    room->current_temperature = 22.0f;  // Default room temperature
-    room->current_fan_level = FAN_LEVEL_OFF;
+    room->current_temperature = 220;  // Default room temperature, 22.0 °C
+    room->fan_duty = FAN_LEVEL_OFF;
     room->manual_fan_override = false;
+    room->fan_mode = FAN_MODE_PID;
+    fan_pid_init(&room->fan_pid, &FAN_PID_CONFIG, SETPOINT_DEFAULT);
     
     // Display
     room->display_update_needed = true;
     
     // Initialize hardware
     HAL_GPIO_WritePin(DOOR_LOCK_GPIO_Port, DOOR_LOCK_Pin, GPIO_PIN_RESET); // RESET = Bloqueado
-    HAL_TIM_PWM_Start(&FAN_PWM_TIMER, FAN_PWM_CHANNEL);
+    // La salida PWM ya la arrancó fan_ramp_init(); las rampas la reescriben por DMA
     room_control_update_fan_pwm(room); // Establecer PWM inicial a 0%
 }
-// --- Actualiza el estado del sistema y maneja la lógica de entrada de contraseña ---
+// --- Atiende un evento y actualiza el estado del sistema ---
 /// @param room Puntero al sistema de control de habitación
-/// @note Esta función se llama periódicamente para actualizar el estado del sistema
-void room_control_update(room_control_t *room) {
-    uint32_t current_time = HAL_GetTick();
-    
-    // State machine logic
-    switch (room->current_state) {
-        case ROOM_STATE_LOCKED:
-            // No se necesita acción continua aquí. Las transiciones son por eventos (teclas).
-            break;
-            
-        case ROOM_STATE_INPUT_PASSWORD:
-            // Timeout para la entrada de contraseña. Si el usuario no hace nada, se bloquea.
-            if (current_time - room->last_input_time > INPUT_TIMEOUT_MS) {
-                room_control_change_state(room, ROOM_STATE_LOCKED);
-            }
-            break;
-            
-        case ROOM_STATE_UNLOCKED:
-            // La transición a LOCKED se maneja por evento de tecla ('*').
-            // Se podría añadir un auto-bloqueo por tiempo aquí si se deseara.
-            break;
-            
-        case ROOM_STATE_ACCESS_DENIED:
-            // Muestra "ACCESO DENEGADO" y vuelve a LOCKED después de un tiempo.
-            if (current_time - room->state_enter_time > ACCESS_DENIED_TIMEOUT_MS) {
-                room_control_change_state(room, ROOM_STATE_LOCKED);
-            }
-            break;
-            
-        case ROOM_STATE_EMERGENCY:
-            // Lógica de emergencia (opcional).
-            break;
-    }
-    
-    // Update physical subsystems if needed
-    // room_control_update_door(room); // Se llama solo al cambiar de estado para eficiencia
-    // room_control_update_fan_pwm(room); // Se llama cuando cambia el nivel del ventilador
-    
-    if (room->display_update_needed) {
-        room_control_update_display(room);
-        room->display_update_needed = false;
-    }
+/// @param event Evento recibido (tecla, lectura de temperatura, timeout, display libre o emergencia)
+/// @note Ya no se consulta en cada pasada del bucle: app.c la llama solo cuando hay un evento.
+void room_control_handle_event(room_control_t *room, const room_event_t *event) {
+    room_control_dispatch(room, event);
+    room_control_refresh_display(room);
 }
-// --- Procesa una tecla del teclado y actualiza el estado del sistema ---
-/// @param room Puntero al sistema de control de habitación
-/// @param key El carácter de la tecla presionada
-/// @note Esta función maneja la lógica de entrada de contraseña y transiciones de estado
-void room_control_process_key(room_control_t *room, char key) {
-    room->last_input_time = HAL_GetTick();
 
-    switch (room->current_state) {
-        case ROOM_STATE_LOCKED:
-            // Para entrar al modo de ingreso de clave, se presiona cualquier dígito.
-            if (key >= '0' && key <= '9') {
-                room_control_change_state(room, ROOM_STATE_INPUT_PASSWORD);
-                // Procesa la primera tecla inmediatamente
-                room_control_process_key(room, key);
-            }
-            break;
-            
-        case ROOM_STATE_INPUT_PASSWORD:
-            if (key >= '0' && key <= '9' && room->input_index < PASSWORD_LENGTH) {
-                room->input_buffer[room->input_index++] = key;
-                room->display_update_needed = true;
-
-                // Validar automáticamente al alcanzar la longitud de la contraseña
-                if (room->input_index == PASSWORD_LENGTH) {
-                    room->input_buffer[room->input_index] = '\0';
-                    if (strcmp(room->input_buffer, room->password) == 0) {
-                        room_control_change_state(room, ROOM_STATE_UNLOCKED);
-                    } else {
-                        room_control_change_state(room, ROOM_STATE_ACCESS_DENIED);
-                    }
-                }
-            } else if (key == '#') { // Cancelar y volver a bloquear
-                room_control_change_state(room, ROOM_STATE_LOCKED);
-            }
-            break;
-            
-        case ROOM_STATE_UNLOCKED:
-            if (key == '*') { // Bloquear el sistema
-                room_control_change_state(room, ROOM_STATE_LOCKED);
-            }
-            // Aquí se podrían añadir más comandos para el modo desbloqueado
-            break;
+/// @brief Columna de la tabla de transiciones que corresponde a un evento
+room_input_t room_control_event_input(const room_event_t *event) {
+    switch (event->type) {
+        case ROOM_EVENT_KEY:
+            if (event->key >= '0' && event->key <= '9') return ROOM_INPUT_DIGIT;
+            if (event->key == '*') return ROOM_INPUT_STAR;
+            if (event->key == '#') return ROOM_INPUT_HASH;
+            return ROOM_INPUT_KEY;
+        case ROOM_EVENT_TEMPERATURE:    return ROOM_INPUT_TEMPERATURE;
+        case ROOM_EVENT_TIMEOUT:        return ROOM_INPUT_TIMEOUT;
+        case ROOM_EVENT_EMERGENCY:      return ROOM_INPUT_EMERGENCY;
+        case ROOM_EVENT_DISPLAY_READY:
+        default:                        return ROOM_INPUT_DISPLAY_READY;
+    }
+}
 
-        default:
-            break;
+/// @brief Uso de una transición de la tabla
+/// @return false si esa celda no tiene la alternativa alt
+bool room_control_get_transition_stats(room_control_t *room, room_state_t state, room_input_t input, uint8_t alt,
+                                       room_transition_stats_t *stats) {
+    if (state >= ROOM_STATE_COUNT || input >= ROOM_INPUT_COUNT || alt >= ROOM_FSM_ALTS ||
+        !room_transitions[state][input][alt].used) {
+        return false;
     }
+    *stats = room->transition_stats[state][input][alt];
+    return true;
 }
 // --- CORRECCIÓN CRÍTICA: Establece la temperatura actual y actualiza el ventilador ---
 /// @brief Establece la temperatura actual y actualiza el nivel del ventilador
 /// @param room Puntero al sistema de control de habitación
-/// @param temperature La temperatura a establecer
-
-void room_control_set_temperature(room_control_t *room, float temperature) {
+/// @param temperature La temperatura a establecer, en décimas de grado
+/// @note El PID ve cada lectura, al ritmo del sensor; la histéresis solo filtra lo que se
+///       muestra y lo que usa la tabla de niveles
+void room_control_set_temperature(room_control_t *room, int16_t temperature) {
     // Usar histéresis para evitar cambios constantes si la temperatura fluctúa poco
-    if (temperature > room->current_temperature + 0.5f || temperature < room->current_temperature - 0.5f) {
+    if (temperature > room->current_temperature + TEMP_HYSTERESIS ||
+        temperature < room->current_temperature - TEMP_HYSTERESIS) {
         room->current_temperature = temperature;
         
-        if (!room->manual_fan_override) {
-            fan_level_t new_level = room_control_calculate_fan_level(temperature);
-            if (new_level != room->current_fan_level) {
-                room->current_fan_level = new_level;
-                room_control_update_fan_pwm(room);
-            }
+        if (!room->manual_fan_override && room->fan_mode == FAN_MODE_STEP) {
+            room_control_set_fan_duty(room, room_control_calculate_fan_level(temperature));
         }
         // Solo actualizar el display si el sistema está desbloqueado
         if (room->current_state == ROOM_STATE_UNLOCKED) {
             room->display_update_needed = true;
         }
     }
+    if (!room->manual_fan_override && room->fan_mode == FAN_MODE_PID) {
+        room_control_set_fan_duty(room, fan_pid_update(&room->fan_pid, temperature));
+    }
 }
 // --- CORRECCIÓN CRÍTICA: Fuerza un nivel de ventilador específico ---
 /// @brief Fuerza un nivel de ventilador específico, ignorando la temperatura
 /// @param room Puntero al sistema de control de habitación
 /// @param level El nivel de ventilador a establecer
-void room_control_force_fan_level(room_control_t *room, fan_level_t level) {
+/// @return true si se aplicó; solo se permite con el sistema desbloqueado
+bool room_control_force_fan_level(room_control_t *room, fan_level_t level) {
     if (room->current_state == ROOM_STATE_UNLOCKED) {
         room->manual_fan_override = true;
-        if (level != room->current_fan_level) {
-            room->current_fan_level = level;
-            // *** CORRECCIÓN CRÍTICA ***
-            room_control_update_fan_pwm(room); // Se corrigió la llamada a la función
-            room->display_update_needed = true;
+        if (level != room->fan_duty) {
+            room_control_set_fan_duty(room, (uint8_t)level);
+            room_control_refresh_display(room);
         }
+        return true;
     }
+    return false;
 }
 
-void room_control_change_password(room_control_t *room, const char *new_password) {
+/// @brief Elige el control automático del ventilador y deja sin efecto un FORCE_FAN
+/// @param room Puntero al sistema de control de habitación
+/// @param mode FAN_MODE_PID o FAN_MODE_STEP
+/// @note El PID arranca desde el duty actual (sin salto); la tabla se aplica en el momento
+void room_control_set_fan_mode(room_control_t *room, fan_mode_t mode) {
+    room->fan_mode = mode;
+    room->manual_fan_override = false;
+    if (mode == FAN_MODE_PID) {
+        fan_pid_reset(&room->fan_pid, room->fan_duty);
+    } else {
+        room_control_set_fan_duty(room, room_control_calculate_fan_level(room->current_temperature));
+    }
+    if (room->current_state == ROOM_STATE_UNLOCKED) {
+        room->display_update_needed = true;
+    }
+}
+
+/// @brief Cambia la temperatura objetivo del PID
+/// @param setpoint En décimas de grado, entre SETPOINT_MIN y SETPOINT_MAX
+/// @return false si está fuera de rango
+bool room_control_set_setpoint(room_control_t *room, int16_t setpoint) {
+    if (setpoint < SETPOINT_MIN || setpoint > SETPOINT_MAX) {
+        return false;
+    }
+    fan_pid_set_setpoint(&room->fan_pid, setpoint);
+    return true;
+}
+
+/// @brief Cambia la contraseña de acceso
+/// @return true si la nueva contraseña tiene PASSWORD_LENGTH caracteres y se guardó
+bool room_control_change_password(room_control_t *room, const char *new_password) {
     if (strlen(new_password) == PASSWORD_LENGTH) {
         strcpy(room->password, new_password);
+        return true;
     }
+    return false;
 }
 
 // --- Getters ---
 room_state_t room_control_get_state(room_control_t *room) { return room->current_state; }
 bool room_control_is_door_locked(room_control_t *room) { return room->door_locked; }
-fan_level_t room_control_get_fan_level(room_control_t *room) { return room->current_fan_level; }
-float room_control_get_temperature(room_control_t *room) { return room->current_temperature; }
+uint8_t room_control_get_fan_duty(room_control_t *room) { return room->fan_duty; }
+fan_mode_t room_control_get_fan_mode(room_control_t *room) { return room->fan_mode; }
+/// @brief Setpoint del PID en décimas de grado
+int16_t room_control_get_setpoint(room_control_t *room) { return room->fan_pid.setpoint; }
+/// @brief Temperatura en décimas de grado, para formatearla con %t sin printf de floats
+int16_t room_control_get_temperature_tenths(room_control_t *room) { return room->current_temperature; }
+/// @brief Humedad relativa de la última lectura, en décimas de %
+int16_t room_control_get_humidity_tenths(room_control_t *room) { return room->current_humidity; }
 
 // --- Private functions ---
+/// @brief Intérprete de la tabla: toma la primera transición de la celda cuya guarda se cumple
+/// @param room Puntero al sistema de control de habitación
+/// @param event Evento recibido
+static void room_control_dispatch(room_control_t *room, const room_event_t *event) {
+    const uint32_t start = DWT->CYCCNT;
+    const room_state_t state = room->current_state;
+    const room_input_t input = room_control_event_input(event);
+    const room_transition_t *cell = room_transitions[state][input];
+
+    for (uint8_t alt = 0; alt < ROOM_FSM_ALTS && cell[alt].used; alt++) {
+        if (cell[alt].guard == NULL || cell[alt].guard(room, event)) {
+            if (cell[alt].next != ROOM_STAY) {
+                room_control_change_state(room, cell[alt].next);
+            }
+            if (cell[alt].action != NULL) {
+                cell[alt].action(room, event);
+            }
+            room_transition_stats_t *stats = &room->transition_stats[state][input][alt];
+            const uint32_t cycles = DWT->CYCCNT - start;
+            stats->count++;
+            stats->cycles_total += cycles;
+            if (cycles > stats->cycles_max) {
+                stats->cycles_max = cycles;
+            }
+            return;
+        }
+    }
+}
+
 /// @brief Cambia el estado del sistema y actualiza el display
 /// @param room Puntero al sistema de control de habitación
 /// @param new_state El nuevo estado al que se cambiará
@@ -210,39 +346,126 @@ static void room_control_change_state(room_control_t *room, room_state_t new_sta
     room->current_state = new_state;
     room->state_enter_time = HAL_GetTick();
     room->display_update_needed = true;
-    
-    // Acciones al entrar a un nuevo estado
-    switch (new_state) {
-        case ROOM_STATE_LOCKED:
-            room->door_locked = true;
-            room_control_clear_input(room);
-            room->manual_fan_override = false; // El control del ventilador vuelve a ser automático
-            // Recalcular nivel del ventilador por si la temperatura cambió mientras estaba desbloqueado
-            room->current_fan_level = room_control_calculate_fan_level(room->current_temperature);
-            room_control_update_fan_pwm(room);
-            break;
-            
-        case ROOM_STATE_UNLOCKED:
-            room->door_locked = false;
-            break;
-            
-        case ROOM_STATE_INPUT_PASSWORD:
-            room_control_clear_input(room);
-            room->last_input_time = HAL_GetTick(); // Iniciar temporizador de timeout
-            break;
-            
-        case ROOM_STATE_ACCESS_DENIED:
-            room_control_clear_input(room);
-            // Aquí se podría enviar una alerta por UART al ESP-01
-            // HAL_UART_Transmit(&huart2, (uint8_t*)"ALERT:FAIL_LOGIN\r\n", 18, 100);
-            break;
-            
-        default:
-            break;
-    }
-    
+    sched_timer_stop(&room->state_timer);
+    room_entry_actions[new_state](room);
     room_control_update_door(room); // Actualizar estado físico de la puerta
 }
+
+// --- Acciones de entrada ---
+static void room_enter_locked(room_control_t *room) {
+    room->door_locked = true;
+    room_control_clear_input(room);
+    // El control del ventilador vuelve a ser automático: la tabla se recalcula por si la
+    // temperatura cambió mientras estaba desbloqueado, el PID sigue desde el duty actual
+    room_control_set_fan_mode(room, room->fan_mode);
+}
+
+static void room_enter_unlocked(room_control_t *room) {
+    // Solo se llega con room_guard_password_ok: la clave correcta levanta la emergencia
+    room->emergency_latched = false;
+    room->door_locked = false;
+}
+
+static void room_enter_input_password(room_control_t *room) {
+    room_control_clear_input(room);
+    room->last_input_time = HAL_GetTick(); // Iniciar temporizador de timeout
+    sched_timer_start(&room->state_timer, INPUT_TIMEOUT_MS + 1, 0);
+}
+
+static void room_enter_access_denied(room_control_t *room) {
+    room_control_clear_input(room);
+    // Alerta por UART: se encola y la envía el DMA, sin frenar el teclado
+    uart_tx_puts(&uart2_tx, "ALERT:FAIL_LOGIN\r\n");
+    sched_timer_start(&room->state_timer, ACCESS_DENIED_TIMEOUT_MS + 1, 0);
+}
+
+static void room_enter_emergency(room_control_t *room) {
+    // Alerta por UART al activarse (no al volver de un ingreso de clave fallido) y luego
+    // lo mismo que LOCKED
+    if (!room->emergency_latched) {
+        room->emergency_latched = true;
+        uart_tx_puts(&uart2_tx, "ALERT:EMERGENCY\r\n");
+    }
+    room_enter_locked(room);
+}
+
+// --- Guardas ---
+/// @brief La tecla completa la clave y es la correcta
+static bool room_guard_password_ok(const room_control_t *room, const room_event_t *event) {
+    return room->input_index == PASSWORD_LENGTH - 1 &&
+           memcmp(room->input_buffer, room->password, PASSWORD_LENGTH - 1) == 0 &&
+           event->key == room->password[PASSWORD_LENGTH - 1];
+}
+
+/// @brief La tecla completa la clave (si llega aquí, incorrecta)
+static bool room_guard_password_complete(const room_control_t *room, const room_event_t *event) {
+    (void)event;
+    return room->input_index == PASSWORD_LENGTH - 1;
+}
+
+/// @brief Sin teclas durante INPUT_TIMEOUT_MS; se comprueba por si el temporizador quedó atrasado
+static bool room_guard_input_timed_out(const room_control_t *room, const room_event_t *event) {
+    (void)event;
+    return HAL_GetTick() - room->last_input_time > INPUT_TIMEOUT_MS;
+}
+
+/// @brief "ACCESO DENEGADO" ya se mostró ACCESS_DENIED_TIMEOUT_MS
+static bool room_guard_denied_elapsed(const room_control_t *room, const room_event_t *event) {
+    (void)event;
+    return HAL_GetTick() - room->state_enter_time > ACCESS_DENIED_TIMEOUT_MS;
+}
+
+/// @brief El ingreso de clave empezó en EMERGENCY y la clave correcta aún no llegó
+static bool room_guard_in_emergency(const room_control_t *room, const room_event_t *event) {
+    (void)event;
+    return room->emergency_latched;
+}
+
+static bool room_guard_input_timed_out_in_emergency(const room_control_t *room, const room_event_t *event) {
+    return room_guard_in_emergency(room, event) && room_guard_input_timed_out(room, event);
+}
+
+static bool room_guard_denied_elapsed_in_emergency(const room_control_t *room, const room_event_t *event) {
+    return room_guard_in_emergency(room, event) && room_guard_denied_elapsed(room, event);
+}
+
+// --- Acciones de transición ---
+/// @brief Agrega un dígito a la clave; cada tecla reinicia el timeout de entrada
+static void room_action_append_digit(room_control_t *room, const room_event_t *event) {
+    room->input_buffer[room->input_index++] = event->key;
+    room->display_update_needed = true;
+    room_action_touch_input(room, event);
+}
+
+/// @brief Tecla durante el ingreso de clave: reinicia el timeout (se cumple al superar INPUT_TIMEOUT_MS)
+static void room_action_touch_input(room_control_t *room, const room_event_t *event) {
+    (void)event;
+    room->last_input_time = HAL_GetTick();
+    sched_timer_start(&room->state_timer, INPUT_TIMEOUT_MS + 1, 0);
+}
+
+static void room_action_temperature(room_control_t *room, const room_event_t *event) {
+    room->current_humidity = event->humidity;
+    room_control_set_temperature(room, event->temperature);
+}
+
+/// @brief Timeout del estado actual: llega como un evento más
+static void room_control_on_timer(void *ctx, uint32_t arg) {
+    (void)arg;
+    const room_event_t event = { .type = ROOM_EVENT_TIMEOUT };
+    room_control_handle_event((room_control_t *)ctx, &event);
+}
+
+/// @brief Redibuja si hay cambios pendientes y el bus I2C está libre
+/// @note  El envío al OLED se hace por DMA sin bloquear; si estaba ocupado, se reintenta con
+///        el evento ROOM_EVENT_DISPLAY_READY que llega al terminar la transferencia.
+static void room_control_refresh_display(room_control_t *room) {
+    if (room->display_update_needed && !ssd1306_IsBusy()) {
+        room_control_update_display(room);
+        room->display_update_needed = false;
+    }
+}
+
 // --- Actualiza el display OLED con el estado actual del sistema ---
 /// @param room Puntero al sistema de control de habitación
 /// @note Esta función se llama al cambiar de estado o cuando se necesita actualizar el display
@@ -273,19 +496,19 @@ static void room_control_update_display(room_control_t *room) {
             break;
 
         case ROOM_STATE_UNLOCKED:
-            ssd1306_SetCursor(5, 5);
+            ssd1306_SetCursor(8, 0);
             ssd1306_WriteString("ACCESO PERMITIDO", Font_7x10, White);
 
-            // *** MEJORA: Mostrar temperatura con un decimal ***
-            snprintf(display_buffer, sizeof(display_buffer), "Temp: %.1f C", room->current_temperature);
-            ssd1306_SetCursor(5, 22);
-            ssd1306_WriteString(display_buffer, Font_7x10, White);
-           
-            const char* fan_mode = room->manual_fan_override ? "MAN" : "AUTO";
-            // *** MEJORA: Mostrar nivel del ventilador como porcentaje ***
-            snprintf(display_buffer, sizeof(display_buffer), "Fan(%s): %d%%", fan_mode, (int)room->current_fan_level);
-            ssd1306_SetCursor(5, 38);
-            ssd1306_WriteString(display_buffer, Font_7x10, White);
+            // Reloj de la temperatura (10 a 40 °C) con la lectura, con un decimal, debajo
+            const int16_t temperature = room_control_get_temperature_tenths(room);
+            fmt_format(display_buffer, sizeof(display_buffer), "%t C", temperature);
+            room_control_draw_gauge(32, temperature, DIAL_TEMP_MIN, DIAL_TEMP_MAX, display_buffer);
+
+            // Reloj del PWM del ventilador con el modo y el porcentaje debajo
+            const char* fan_mode = room->manual_fan_override ? "MAN" :
+                                   (room->fan_mode == FAN_MODE_PID) ? "PID" : "AUTO";
+            fmt_format(display_buffer, sizeof(display_buffer), "%s %d%%", fan_mode, (int)room->fan_duty);
+            room_control_draw_gauge(96, room->fan_duty, 0, 100, display_buffer);
             break;
 
         case ROOM_STATE_ACCESS_DENIED:
@@ -295,11 +518,29 @@ static void room_control_update_display(room_control_t *room) {
             ssd1306_WriteString("DENEGADO", Font_7x10, White);
             break;
 
+        case ROOM_STATE_EMERGENCY:
+            ssd1306_SetCursor(15, 10);
+            ssd1306_WriteString("EMERGENCIA", Font_7x10, White);
+            ssd1306_SetCursor(15, 30);
+            ssd1306_WriteString("BLOQUEADO", Font_7x10, White);
+            break;
+
         default:
             break;
     }
 
-    ssd1306_UpdateScreen(); 
+    ssd1306_UpdateScreenAsync();
+}
+
+/// @brief Dibuja un reloj de 270° en la mitad de la pantalla centrada en x, con su texto debajo
+/// @param x Centro del reloj y del texto
+/// @param value Valor de la aguja, limitado a [min;max]
+/// @param label Texto bajo el reloj, como mucho 9 caracteres de Font_7x10
+static void room_control_draw_gauge(uint8_t x, int32_t value, int32_t min, int32_t max, char *label) {
+    ssd1306_DrawDial(x, 32, 18, value, min, max, White);
+    const uint8_t width = (uint8_t)(strlen(label) * Font_7x10.width);
+    ssd1306_SetCursor((width / 2U < x) ? (uint8_t)(x - width / 2U) : 0, 52);
+    ssd1306_WriteString(label, Font_7x10, White);
 }
 // --- CORRECCIÓN CRÍTICA: Actualiza el estado de la puerta ---
 /// @brief Actualiza el estado físico de la puerta según el estado actual   
@@ -317,17 +558,29 @@ static void room_control_update_door(room_control_t *room) {
 /// @brief Actualiza el PWM del ventilador basado en el nivel actual
 /// @param room Puntero al sistema de control de habitación
 /// @note Esta función se llama cada vez que cambia el nivel del ventilador
-///       o al iniciar el sistema. Asegura que el PWM del ventilador
+///       o al iniciar el sistema. El cambio no es un salto: fan_ramp lleva el PWM
+///       al nuevo nivel en una rampa que escribe el DMA, lo que limita el pico de
+///       corriente del motor sin ocupar la CPU.
 static void room_control_update_fan_pwm(room_control_t *room) {
-    // El periodo de TIM3 se configuró a 100, así que el nivel de fan (0-100) mapea directamente.
-    uint32_t pwm_pulse = (uint32_t)room->current_fan_level;
-    __HAL_TIM_SET_COMPARE(&FAN_PWM_TIMER, FAN_PWM_CHANNEL, pwm_pulse);
+    // El periodo de TIM3 se configuró a 100, así que el duty (0-100) mapea directamente.
+    fan_ramp_to(&fan_ramp, (uint16_t)room->fan_duty);
+}
+
+/// @brief Lleva el ventilador a un duty nuevo; si no cambia no se toca el PWM
+static void room_control_set_fan_duty(room_control_t *room, uint8_t duty) {
+    if (duty != room->fan_duty) {
+        room->fan_duty = duty;
+        room_control_update_fan_pwm(room);
+        if (room->current_state == ROOM_STATE_UNLOCKED) {
+            room->display_update_needed = true;
+        }
+    }
 }
 
 /// @brief Calcula el nivel del ventilador basado en la temperatura
-/// @param temperature La temperatura actual
+/// @param temperature La temperatura actual, en décimas de grado
 /// @return El nivel del ventilador correspondiente
-static fan_level_t room_control_calculate_fan_level(float temperature) {
+static fan_level_t room_control_calculate_fan_level(int16_t temperature) {
     if (temperature < TEMP_THRESHOLD_LOW)       return FAN_LEVEL_OFF;
     else if (temperature < TEMP_THRESHOLD_MED)  return FAN_LEVEL_LOW;
     else if (temperature < TEMP_THRESHOLD_HIGH) return FAN_LEVEL_MED;
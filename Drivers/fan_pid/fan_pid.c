@@ -0,0 +1,98 @@
+#include "fan_pid.h"
+
+#define FAN_PID_FULL ((int64_t)100 << 16)  // 100 % in Q16
+
+static int32_t fan_pid_scale(int32_t gain, uint32_t num, uint32_t den)
+{
+    return (int32_t)(((int64_t)gain * num + den / 2U) / den);
+}
+
+static int64_t fan_pid_clamp(int64_t value)
+{
+    return (value < 0) ? 0 : (value > FAN_PID_FULL) ? FAN_PID_FULL : value;
+}
+
+/**
+ * @brief Initializes the controller with the output at 0 %.
+ *        The gains are turned into per-sample, per-tenth factors once here,
+ *        so an update is a few integer multiplies.
+ *
+ * @param pid Pointer to the controller.
+ * @param config Gains in natural units (see fan_pid_config_t), sample period and output step.
+ * @param setpoint Target temperature, in tenths of a degree.
+ */
+void fan_pid_init(fan_pid_t *pid, const fan_pid_config_t *config, int16_t setpoint)
+{
+    const uint32_t sample_ms = (config->sample_ms == 0) ? 1U : config->sample_ms;
+    pid->kp = fan_pid_scale(config->kp, 1U, 10U);
+    pid->ki = fan_pid_scale(config->ki, sample_ms, 10000U);
+    pid->kd = fan_pid_scale(config->kd, 100U, sample_ms);
+    pid->min_step = config->min_step;
+    pid->setpoint = setpoint;
+    pid->updates = 0;
+    pid->saturated = 0;
+    fan_pid_reset(pid, 0);
+}
+
+/**
+ * @brief Changes the target temperature. The integrator is kept: the output
+ *        moves from where it is, with no bump from the derivative.
+ */
+void fan_pid_set_setpoint(fan_pid_t *pid, int16_t setpoint)
+{
+    pid->setpoint = setpoint;
+}
+
+/**
+ * @brief Bumpless start from a given duty, e.g. the one a manual or step
+ *        mode left on the fan: the integrator takes it over and the first
+ *        update has no derivative.
+ *
+ * @param pid Pointer to the controller.
+ * @param output Duty the fan has now, in %.
+ */
+void fan_pid_reset(fan_pid_t *pid, uint8_t output)
+{
+    if (output > 100U) {
+        output = 100U;
+    }
+    pid->integral = (int32_t)output << 16;
+    pid->output = output;
+    pid->primed = false;
+}
+
+/**
+ * @brief One control step, for every sensor reading.
+ *
+ * @param pid Pointer to the controller.
+ * @param temperature Reading, in tenths of a degree.
+ * @return Duty for the fan, 0..100 %.
+ */
+uint8_t fan_pid_update(fan_pid_t *pid, int16_t temperature)
+{
+    const int32_t error = (int32_t)temperature - pid->setpoint;
+    const int32_t rise = pid->primed ? (int32_t)temperature - pid->last_temperature : 0;
+    pid->last_temperature = temperature;
+    pid->primed = true;
+    pid->updates++;
+
+    const int64_t pd = (int64_t)pid->kp * error + (int64_t)pid->kd * rise;
+    const int64_t integral = pid->integral + (int64_t)pid->ki * error;
+
+    // Conditional integration: no integral that would drive a saturated output further out
+    const int64_t unclamped = pd + integral;
+    if (!((unclamped > FAN_PID_FULL && error > 0) || (unclamped < 0 && error < 0))) {
+        pid->integral = (int32_t)fan_pid_clamp(integral);
+    }
+    const int64_t output = pd + pid->integral;
+    if (output < 0 || output > FAN_PID_FULL) {
+        pid->saturated++;
+    }
+    const uint8_t duty = (uint8_t)((fan_pid_clamp(output) + (1 << 15)) >> 16);
+
+    const uint8_t step = (duty > pid->output) ? duty - pid->output : pid->output - duty;
+    if (step >= pid->min_step || duty == 0U || duty == 100U) {
+        pid->output = duty;
+    }
+    return pid->output;
+}
@@ -0,0 +1,58 @@
+#ifndef FAN_PID_H
+#define FAN_PID_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Fixed-point PID for a cooling fan: temperature in, duty 0..100 % out.
+ * fan_pid_update() runs once per sensor reading; a reading above the
+ * setpoint is a positive error and asks for more air.
+ *
+ * Temperatures are in tenths of a degree, as the DHT11 driver delivers them.
+ * Terms and integrator are Q16 percent of duty, so the integral keeps the
+ * fractions of a percent that a slow plant adds up sample after sample.
+ * The derivative acts on the measurement, not the error: a setpoint change
+ * gives no kick. With kd = 0 it is a PI controller.
+ *
+ * Anti-windup is conditional integration: while the output is saturated
+ * the error that would push it further is not integrated, and the
+ * integrator itself stays within 0..100 %. The controller therefore leaves
+ * saturation as soon as the error changes sign.
+ *
+ * min_step keeps the output still for changes smaller than that many
+ * percent (the ends 0 and 100 % are always reached), so sensor noise does
+ * not turn into a ramp of the fan every sample.
+ */
+
+/* Gain constant from a literal, evaluated by the compiler: no float code at run time */
+#define FAN_PID_Q16(x) ((int32_t)((x) * 65536.0 + 0.5))
+
+typedef struct {
+    int32_t kp;             // Q16 % of duty per degree of error
+    int32_t ki;             // Q16 % of duty per degree of error and second
+    int32_t kd;             // Q16 % of duty per degree per second of rise, 0: PI
+    uint32_t sample_ms;     // time between two fan_pid_update() calls
+    uint8_t min_step;       // smallest output change, in %
+} fan_pid_config_t;
+
+typedef struct {
+    int32_t kp;             // per tenth of a degree
+    int32_t ki;             // per tenth of a degree and sample
+    int32_t kd;             // per tenth of a degree of change between samples
+    uint8_t min_step;
+    int16_t setpoint;       // tenths of a degree
+    int32_t integral;       // Q16 %, 0..100 %
+    int16_t last_temperature;
+    bool primed;            // last_temperature holds a reading
+    uint8_t output;         // duty last returned, %
+    uint32_t updates;
+    uint32_t saturated;     // updates with the unclamped output outside 0..100 %
+} fan_pid_t;
+
+void fan_pid_init(fan_pid_t *pid, const fan_pid_config_t *config, int16_t setpoint);
+void fan_pid_set_setpoint(fan_pid_t *pid, int16_t setpoint);
+void fan_pid_reset(fan_pid_t *pid, uint8_t output);
+uint8_t fan_pid_update(fan_pid_t *pid, int16_t temperature);
+
+#endif // FAN_PID_H
@@ -0,0 +1,171 @@
+#include "fan_ramp.h"
+
+/**
+ * @brief Distance covered after step i of n, rounded to the nearest count.
+ */
+static uint32_t fan_ramp_done(uint32_t distance, uint32_t i, uint32_t n, fan_ramp_shape_t shape)
+{
+    if (shape == FAN_RAMP_SCURVE) {
+        // i^2 (3n - 2i) / n^3 reaches 2^18 for n = 64: the product needs 64 bits
+        const uint64_t den = (uint64_t)n * n * n;
+        return (uint32_t)(((uint64_t)distance * (i * i * (3U * n - 2U * i)) + den / 2U) / den);
+    }
+    return (distance * i + n / 2U) / n;
+}
+
+/**
+ * @brief Fills wave with the compare value of each PWM period of a ramp.
+ *        Integer only, the same on the target and on the host. The values are
+ *        monotonic and the last one is exactly `to`; `from` itself is not
+ *        included, it is what the output already has.
+ *
+ * @param wave Destination, at least `steps` values.
+ * @param steps Number of PWM periods, clamped to 1..FAN_RAMP_MAX_STEPS.
+ * @param from Compare value before the ramp.
+ * @param to Compare value at the end of the ramp.
+ * @param shape FAN_RAMP_LINEAR or FAN_RAMP_SCURVE.
+ * @return Number of values written.
+ */
+uint16_t fan_ramp_generate(uint16_t *wave, uint16_t steps, uint16_t from, uint16_t to, fan_ramp_shape_t shape)
+{
+    if (steps == 0) {
+        steps = 1;
+    } else if (steps > FAN_RAMP_MAX_STEPS) {
+        steps = FAN_RAMP_MAX_STEPS;
+    }
+    const uint32_t distance = (to > from) ? (uint32_t)(to - from) : (uint32_t)(from - to);
+
+    for (uint16_t i = 1; i <= steps; i++) {
+        // The same distance up and down: both directions round alike
+        const uint32_t done = fan_ramp_done(distance, i, steps, shape);
+        wave[i - 1] = (uint16_t)((to > from) ? from + done : from - done);
+    }
+    return steps;
+}
+
+/**
+ * @brief Burst base of a channel's compare register: TIM_DMABASE_CCR1..CCR4 are consecutive.
+ */
+static uint32_t fan_ramp_burst_base(uint32_t channel)
+{
+    return TIM_DMABASE_CCR1 + channel / 4U;
+}
+
+/**
+ * @brief Starts a transfer towards the latest target if none is running.
+ *        Safe from both the main loop and the DMA interrupt: the busy flag
+ *        makes sure only one of them owns wave and current.
+ */
+static void fan_ramp_kick(fan_ramp_t *ramp)
+{
+    while (!atomic_exchange(&ramp->busy, true)) {
+        const uint16_t target = atomic_load(&ramp->target);
+        if (target != ramp->current) {
+            const uint16_t n = fan_ramp_generate(ramp->wave, ramp->steps, ramp->current, target, ramp->shape);
+            ramp->current = target;
+            ramp->started = HAL_GetTick();
+            // One half-word to CCRx per update event, n update events
+            if (!ramp->no_dma &&
+                HAL_TIM_DMABurst_MultiWriteStart(ramp->htim, fan_ramp_burst_base(ramp->channel), TIM_DMA_UPDATE,
+                                                 (const uint32_t *)ramp->wave, TIM_DMABURSTLENGTH_1TRANSFER,
+                                                 n) == HAL_OK) {
+                ramp->ramps++;
+                return;
+            }
+            // No DMA channel: jump straight to the target, as without a ramp
+            __HAL_TIM_SET_COMPARE(ramp->htim, ramp->channel, target);
+        }
+        atomic_store(&ramp->busy, false);
+        // A target stored after the load would wait for the next change: look again
+        if (atomic_load(&ramp->target) == ramp->current) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Initializes the ramp engine with the output at 0 and starts the PWM.
+ *
+ * @param ramp Pointer to the ramp engine.
+ * @param htim PWM timer, the DMA channel of its update request linked in hdma[TIM_DMA_ID_UPDATE].
+ * @param channel Timer channel (TIM_CHANNEL_x).
+ * @param shape FAN_RAMP_LINEAR or FAN_RAMP_SCURVE.
+ * @param steps PWM periods per ramp, at most FAN_RAMP_MAX_STEPS.
+ */
+void fan_ramp_init(fan_ramp_t *ramp, TIM_HandleTypeDef *htim, uint32_t channel, fan_ramp_shape_t shape,
+                   uint16_t steps)
+{
+    ramp->htim = htim;
+    ramp->channel = channel;
+    ramp->shape = shape;
+    ramp->steps = (steps > FAN_RAMP_MAX_STEPS) ? FAN_RAMP_MAX_STEPS : steps;
+    atomic_init(&ramp->busy, false);
+    atomic_init(&ramp->target, 0);
+    ramp->current = 0;
+    ramp->started = 0;
+    ramp->no_dma = false;
+    ramp->ramps = 0;
+    ramp->timeouts = 0;
+    __HAL_TIM_SET_COMPARE(htim, channel, 0);
+    HAL_TIM_PWM_Start(htim, channel);
+}
+
+/**
+ * @brief Ramps the output to a new compare value. Never blocks; if a ramp is
+ *        running, the new one starts from its end. Main loop only.
+ *
+ * @param ramp Pointer to the ramp engine.
+ * @param compare New compare value, ARR + 1 for 100 %.
+ */
+void fan_ramp_to(fan_ramp_t *ramp, uint16_t compare)
+{
+    atomic_store(&ramp->target, compare);
+    fan_ramp_kick(ramp);
+}
+
+/**
+ * @brief DMA transfer complete, call from HAL_TIM_PeriodElapsedCallback().
+ *        The HAL leaves the burst state busy until the request is stopped.
+ */
+void fan_ramp_complete(fan_ramp_t *ramp)
+{
+    HAL_TIM_DMABurst_WriteStop(ramp->htim, TIM_DMA_UPDATE);
+    atomic_store(&ramp->busy, false);
+    fan_ramp_kick(ramp);
+}
+
+/**
+ * @brief Watchdog of the transfer in progress, call from the main loop now
+ *        and then. A ramp running for FAN_RAMP_TIMEOUT_MS never got its
+ *        update requests: the request is stopped, the output set to the
+ *        target and the ramps that follow jump straight to theirs.
+ */
+void fan_ramp_poll(fan_ramp_t *ramp)
+{
+    const uint32_t primask = __get_PRIMASK();
+
+    // Masked, the transfer-complete interrupt cannot end the ramp between the check and the stop
+    __disable_irq();
+    const bool expired = atomic_load(&ramp->busy) && HAL_GetTick() - ramp->started >= FAN_RAMP_TIMEOUT_MS;
+    if (expired) {
+        HAL_TIM_DMABurst_WriteStop(ramp->htim, TIM_DMA_UPDATE);
+        __HAL_TIM_SET_COMPARE(ramp->htim, ramp->channel, ramp->current);
+        ramp->no_dma = true;
+        ramp->timeouts++;
+        atomic_store(&ramp->busy, false);
+    }
+    if (!primask) {
+        __enable_irq();
+    }
+    if (expired) {
+        fan_ramp_kick(ramp);
+    }
+}
+
+/**
+ * @brief Returns true while a ramp is playing.
+ */
+bool fan_ramp_is_busy(fan_ramp_t *ramp)
+{
+    return atomic_load(&ramp->busy);
+}
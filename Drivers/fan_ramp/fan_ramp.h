@@ -0,0 +1,62 @@
+#ifndef FAN_RAMP_H
+#define FAN_RAMP_H
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/*
+ * Soft start for a PWM output. A level change is not a jump of the compare
+ * register: fan_ramp_generate() precomputes the compare values of every PWM
+ * period between the old and the new level (a straight line or an S-curve)
+ * and the timer's update DMA request writes one per period into the compare
+ * register through the DMA burst register (TIMx_DMAR), so the ramp plays
+ * out without the CPU. The update request comes every period whatever the
+ * compare value, so 100 % (ARR + 1) is as good a step as any other. A change
+ * requested while a ramp is running starts from where that ramp ends,
+ * chained from the DMA transfer-complete callback (fan_ramp_complete()).
+ *
+ * The timer must use output-compare preload (HAL_TIM_PWM_ConfigChannel()
+ * sets it) so each value takes effect at the next update, and the DMA
+ * channel of its update request (hdma[TIM_DMA_ID_UPDATE]) must be in normal
+ * mode with half-word accesses.
+ *
+ * A ramp whose transfer does not complete within FAN_RAMP_TIMEOUT_MS, e.g.
+ * a DMA channel not wired to the update request, is cut short by
+ * fan_ramp_poll(): the compare register gets the target directly and later
+ * changes jump too, as without a ramp.
+ */
+
+#define FAN_RAMP_MAX_STEPS 64   // longest ramp, in PWM periods
+#define FAN_RAMP_TIMEOUT_MS 1000U   // above FAN_RAMP_MAX_STEPS PWM periods of the slowest timer used
+
+typedef enum {
+    FAN_RAMP_LINEAR,            // constant slope
+    FAN_RAMP_SCURVE             // smoothstep 3x^2 - 2x^3: gentle start and end
+} fan_ramp_shape_t;
+
+typedef struct {
+    TIM_HandleTypeDef *htim;
+    uint32_t channel;
+    fan_ramp_shape_t shape;
+    uint16_t steps;                 // PWM periods per ramp
+    uint16_t wave[FAN_RAMP_MAX_STEPS];
+    atomic_bool busy;               // a DMA transfer is playing wave
+    _Atomic uint16_t target;        // last compare value asked for
+    uint16_t current;               // compare value once the transfer in progress ends
+    uint32_t started;               // HAL_GetTick() at the start of the transfer in progress
+    bool no_dma;                    // a transfer timed out: set the compare register directly
+    uint32_t ramps;                 // transfers started
+    uint32_t timeouts;              // transfers cut short by fan_ramp_poll()
+} fan_ramp_t;
+
+uint16_t fan_ramp_generate(uint16_t *wave, uint16_t steps, uint16_t from, uint16_t to, fan_ramp_shape_t shape);
+void fan_ramp_init(fan_ramp_t *ramp, TIM_HandleTypeDef *htim, uint32_t channel, fan_ramp_shape_t shape,
+                   uint16_t steps);
+void fan_ramp_to(fan_ramp_t *ramp, uint16_t compare);
+void fan_ramp_complete(fan_ramp_t *ramp);
+void fan_ramp_poll(fan_ramp_t *ramp);
+bool fan_ramp_is_busy(fan_ramp_t *ramp);
+
+#endif // FAN_RAMP_H
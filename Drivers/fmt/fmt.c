@@ -0,0 +1,179 @@
+#include "fmt.h"
+#include <stdbool.h>
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} fmt_out_t;
+
+static void fmt_putc(fmt_out_t *out, char c)
+{
+    if (out->len + 1 < out->size) {
+        out->buf[out->len] = c;
+    }
+    out->len++;
+}
+
+static void fmt_pad(fmt_out_t *out, char c, int count)
+{
+    while (count-- > 0) {
+        fmt_putc(out, c);
+    }
+}
+
+/**
+ * @brief Writes a field: optional sign, then the digits/text, padded to width.
+ *        Zero padding goes between the sign and the digits, like printf.
+ */
+static void fmt_field(fmt_out_t *out, char sign, const char *text, int len, int width, bool left, bool zero)
+{
+    const int pad = width - len - (sign ? 1 : 0);
+
+    if (!left && !zero) {
+        fmt_pad(out, ' ', pad);
+    }
+    if (sign) {
+        fmt_putc(out, sign);
+    }
+    if (!left && zero) {
+        fmt_pad(out, '0', pad);
+    }
+    for (int i = 0; i < len; i++) {
+        fmt_putc(out, text[i]);
+    }
+    if (left) {
+        fmt_pad(out, ' ', pad);
+    }
+}
+
+/**
+ * @brief Converts value to digits in base 10 or 16, written backwards from end.
+ * @return Pointer to the first digit.
+ */
+static char *fmt_digits(char *end, unsigned long value, unsigned base, bool upper)
+{
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+
+    do {
+        *--end = digits[value % base];
+        value /= base;
+    } while (value != 0);
+    return end;
+}
+
+/**
+ * @brief Formats into buf, see fmt.h for the supported conversions.
+ *
+ * @param buf Destination, may be NULL when size is 0.
+ * @param size Size of buf in bytes, including the terminating NUL.
+ * @param format Format string.
+ * @param args Arguments for the conversions.
+ * @return Length of the complete output, excluding the NUL.
+ */
+size_t fmt_vformat(char *buf, size_t size, const char *format, va_list args)
+{
+    fmt_out_t out = { .buf = buf, .size = size, .len = 0 };
+    char num[24];   // enough for a 64-bit value in decimal plus the tenths point
+    char *const end = num + sizeof(num);
+
+    for (const char *p = format; *p != '\0'; p++) {
+        if (*p != '%') {
+            fmt_putc(&out, *p);
+            continue;
+        }
+
+        bool left = false, zero = false, is_long = false;
+        int width = 0;
+
+        for (p++; *p == '-' || *p == '0'; p++) {
+            if (*p == '-') {
+                left = true;
+            } else {
+                zero = true;
+            }
+        }
+        for (; *p >= '0' && *p <= '9'; p++) {
+            width = width * 10 + (*p - '0');
+        }
+        if (*p == 'l') {
+            is_long = true;
+            p++;
+        }
+
+        char sign = '\0';
+        char *text = end;
+        switch (*p) {
+            case 'd':
+            case 'i':
+            case 't': {
+                const long value = is_long ? va_arg(args, long) : va_arg(args, int);
+                unsigned long magnitude = (unsigned long)value;
+                if (value < 0) {
+                    sign = '-';
+                    magnitude = 0UL - magnitude;
+                }
+                if (*p == 't') {
+                    *--text = (char)('0' + magnitude % 10);
+                    *--text = '.';
+                    magnitude /= 10;
+                }
+                text = fmt_digits(text, magnitude, 10, false);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X': {
+                const unsigned long value = is_long ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+                text = fmt_digits(text, value, *p == 'u' ? 10 : 16, *p == 'X');
+                break;
+            }
+            case 's': {
+                const char *s = va_arg(args, const char *);
+                int len = 0;
+                if (s == NULL) {
+                    s = "(null)";
+                }
+                while (s[len] != '\0') {
+                    len++;
+                }
+                fmt_field(&out, '\0', s, len, width, left, false);
+                continue;
+            }
+            case 'c':
+                *--text = (char)va_arg(args, int);
+                zero = false;
+                break;
+            case '%':
+                fmt_putc(&out, '%');
+                continue;
+            default:
+                // Unsupported conversion: copy it literally and stop at the end of the string
+                fmt_putc(&out, '%');
+                if (*p == '\0') {
+                    p--;
+                } else {
+                    fmt_putc(&out, *p);
+                }
+                continue;
+        }
+        fmt_field(&out, sign, text, (int)(end - text), width, left, zero);
+    }
+
+    if (size > 0) {
+        out.buf[out.len < size ? out.len : size - 1] = '\0';
+    }
+    return out.len;
+}
+
+/**
+ * @brief Formats into buf, see fmt_vformat().
+ */
+size_t fmt_format(char *buf, size_t size, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const size_t len = fmt_vformat(buf, size, format, args);
+    va_end(args);
+    return len;
+}
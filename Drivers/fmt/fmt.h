@@ -0,0 +1,24 @@
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Small integer-only formatter, a replacement for snprintf() that does not
+ * pull newlib's printf (and its float support) into flash.
+ *
+ * Conversions: %d %i %u %x %X %s %c %% and %t, a fixed-point value in tenths
+ * passed as an int (215 -> "21.5", -5 -> "-0.5"). Flags '-' (left align) and
+ * '0' (zero pad), a field width and the 'l' length modifier are accepted.
+ * Precision and the other conversions are not supported.
+ *
+ * Like snprintf(), the output is always NUL-terminated when size > 0 and the
+ * return value is the length the full output would have had.
+ */
+
+size_t fmt_vformat(char *buf, size_t size, const char *format, va_list args);
+size_t fmt_format(char *buf, size_t size, const char *format, ...);
+
+#endif // FMT_H
@@ -7,63 +7,243 @@ static const char keypad_map[KEYPAD_ROWS][KEYPAD_COLS] = {
   {'*', '0', '#', 'D'}
 };
 
-static uint32_t last_press_time = 0;
+#define KEYPAD_LONG_PRESS_TICKS (KEYPAD_LONG_PRESS_MS / KEYPAD_TICK_MS)
+#define KEYPAD_EVENT_SIZE       4   // bytes per queued event: type, key, keys
 
-static void small_delay(void) {
-    for (volatile int i = 0; i < 1000; i++);
-}
+// Whole records only: a record never wraps and is never cut by a full queue
+_Static_assert(RING_BUFFER_IS_POW2(KEYPAD_QUEUE_SIZE), "KEYPAD_QUEUE_SIZE must be a power of two");
+_Static_assert(KEYPAD_QUEUE_SIZE % KEYPAD_EVENT_SIZE == 0, "KEYPAD_QUEUE_SIZE must hold whole events");
 
-void keypad_init(keypad_handle_t* keypad) {
+/**
+ * @brief Drives every row low (idle: any key pulls its column down) or high.
+ */
+static void keypad_drive_rows(keypad_handle_t* keypad, GPIO_PinState state) {
     for (int i = 0; i < KEYPAD_ROWS; i++) {
-        HAL_GPIO_WritePin(keypad->row_ports[i], keypad->row_pins[i], GPIO_PIN_RESET);
+        HAL_GPIO_WritePin(keypad->row_ports[i], keypad->row_pins[i], state);
+    }
+}
+
+/**
+ * @brief Queues an event, or counts it as dropped if the whole record does not fit.
+ */
+static void keypad_push(keypad_handle_t* keypad, keypad_event_type_t type, char key) {
+    const uint8_t event[KEYPAD_EVENT_SIZE] = { (uint8_t)type, (uint8_t)key, (uint8_t)keypad->pressed,
+                                               (uint8_t)(keypad->pressed >> 8) };
+    if (KEYPAD_QUEUE_SIZE - ring_buffer_spsc_count(&keypad->events) < KEYPAD_EVENT_SIZE) {
+        keypad->dropped++;
+        return;
     }
+    ring_buffer_spsc_write_bulk(&keypad->events, event, KEYPAD_EVENT_SIZE);
 }
 
-char keypad_scan(keypad_handle_t* keypad, uint16_t col_pin) {
-    char key_pressed = '\0';
-    
-    if (HAL_GetTick() - last_press_time < 100) {
-        return '\0';
-    }
-    
-    small_delay();
-    
-    int col_index = -1;
-    for (int i = 0; i < KEYPAD_COLS; i++) {
-        if (keypad->col_pins[i] == col_pin) {
-            col_index = i;
-            break;
+static char keypad_key(uint8_t index) {
+    return keypad_map[index / KEYPAD_COLS][index % KEYPAD_COLS];
+}
+
+/**
+ * @brief Keys of a scan that may be ghosts: every rectangle whose corners all
+ *        read pressed, i.e. two rows sharing two or more columns.
+ */
+static uint16_t keypad_ghost_mask(uint16_t scan) {
+    const uint16_t cols = (uint16_t)((1U << KEYPAD_COLS) - 1U);
+    uint16_t mask = 0;
+    for (uint8_t r1 = 0; r1 < KEYPAD_ROWS; r1++) {
+        for (uint8_t r2 = (uint8_t)(r1 + 1U); r2 < KEYPAD_ROWS; r2++) {
+            const uint16_t common = (uint16_t)((scan >> (r1 * KEYPAD_COLS)) & (scan >> (r2 * KEYPAD_COLS)) & cols);
+            if (common & (common - 1U)) {
+                mask |= (uint16_t)((common << (r1 * KEYPAD_COLS)) | (common << (r2 * KEYPAD_COLS)));
+            }
         }
     }
-    
-    if (col_index == -1) {
-        return '\0';
+    return mask;
+}
+
+/**
+ * @brief End of a full scan: steps the integrators with its bitmap and turns
+ *        the change of the debounced bitmap into events.
+ *
+ * @return true if every integrator is at zero and nothing is ambiguous.
+ */
+static bool keypad_scan_done(keypad_handle_t* keypad) {
+    const uint16_t scan = keypad->scan;
+    const uint16_t ghost = keypad_ghost_mask(scan);
+    if (ghost != 0) {
+        keypad->ghost_scans++;
+        if (keypad->ghost == 0) {
+            keypad_push(keypad, KEYPAD_EVENT_GHOST, '\0');
+        }
     }
-    
-    for (int i = 0; i < KEYPAD_ROWS; i++) {
-        HAL_GPIO_WritePin(keypad->row_ports[i], keypad->row_pins[i], GPIO_PIN_SET);
-    }
-    
-    for (int row = 0; row < KEYPAD_ROWS; row++) {
-        HAL_GPIO_WritePin(keypad->row_ports[row], keypad->row_pins[row], GPIO_PIN_RESET);
-        
-        small_delay();
-        
-        if (HAL_GPIO_ReadPin(keypad->col_ports[col_index], keypad->col_pins[col_index]) == GPIO_PIN_RESET) {
-            key_pressed = keypad_map[row][col_index];
-            
-            while (HAL_GPIO_ReadPin(keypad->col_ports[col_index], keypad->col_pins[col_index]) == GPIO_PIN_RESET) {
-                small_delay();
+    keypad->ghost = ghost;
+
+    uint16_t debounced = keypad->pressed;
+    bool settled = true;
+    for (uint8_t index = 0; index < KEYPAD_KEYS; index++) {
+        const uint16_t bit = (uint16_t)(1U << index);
+        if (ghost & bit) {
+            // Ambiguous: neither a press nor a release until the pattern clears
+        } else if (scan & bit) {
+            if (keypad->integrator[index] < KEYPAD_DEBOUNCE_SCANS &&
+                ++keypad->integrator[index] == KEYPAD_DEBOUNCE_SCANS) {
+                debounced |= bit;
             }
-            
-            last_press_time = HAL_GetTick();
-            break;
+        } else if (keypad->integrator[index] > 0 && --keypad->integrator[index] == 0) {
+            debounced &= (uint16_t)~bit;
+        }
+        settled = settled && keypad->integrator[index] == 0;
+    }
+
+    // Releases first, then presses: each event carries the bitmap right after it,
+    // so a chord completes on exactly one press
+    const uint16_t changed = debounced ^ keypad->pressed;
+    for (uint8_t index = 0; index < KEYPAD_KEYS; index++) {
+        const uint16_t bit = (uint16_t)(1U << index);
+        if ((changed & bit) && !(debounced & bit)) {
+            keypad->pressed &= (uint16_t)~bit;
+            keypad_push(keypad, KEYPAD_EVENT_RELEASE, keypad_key(index));
+        }
+    }
+    for (uint8_t index = 0; index < KEYPAD_KEYS; index++) {
+        const uint16_t bit = (uint16_t)(1U << index);
+        if ((changed & bit) && (debounced & bit)) {
+            keypad->pressed |= bit;
+            keypad->held_ticks[index] = 0;
+            keypad_push(keypad, KEYPAD_EVENT_PRESS, keypad_key(index));
         }
-        
-        HAL_GPIO_WritePin(keypad->row_ports[row], keypad->row_pins[row], GPIO_PIN_SET);
-    }
-    
-    keypad_init(keypad);
-    
-    return key_pressed;
-}
\ No newline at end of file
+    }
+    return settled && ghost == 0;
+}
+
+/**
+ * @brief Initializes the keypad: rows low, waiting for a column EXTI.
+ *
+ * @param keypad Pointer to the keypad handle, ports and pins filled in.
+ * @param htim Timer whose update interrupt calls keypad_tick() every KEYPAD_TICK_MS.
+ */
+void keypad_init(keypad_handle_t* keypad, TIM_HandleTypeDef *htim) {
+    keypad->htim = htim;
+    atomic_init(&keypad->scanning, false);
+    keypad->row = 0;
+    keypad->scan = 0;
+    keypad->ghost = 0;
+    for (int i = 0; i < KEYPAD_KEYS; i++) {
+        keypad->integrator[i] = 0;
+        keypad->held_ticks[i] = 0;
+    }
+    keypad->pressed = 0;
+    ring_buffer_spsc_init(&keypad->events, keypad->events_storage, KEYPAD_QUEUE_SIZE);
+    keypad->dropped = 0;
+    keypad->ghost_scans = 0;
+    keypad_drive_rows(keypad, GPIO_PIN_RESET);
+}
+
+/**
+ * @brief Starts scanning if it is not running. Call from the column EXTI callback;
+ *        the EXTIs that the scan itself causes are ignored here.
+ */
+void keypad_wake(keypad_handle_t* keypad) {
+    if (atomic_exchange(&keypad->scanning, true)) {
+        return;
+    }
+    keypad_drive_rows(keypad, GPIO_PIN_SET);
+    keypad->row = 0;
+    keypad->scan = 0;
+    HAL_GPIO_WritePin(keypad->row_ports[0], keypad->row_pins[0], GPIO_PIN_RESET);
+    HAL_TIM_Base_Start_IT(keypad->htim);
+}
+
+/**
+ * @brief One scanner step, from the timer update interrupt: reads the row driven
+ *        low since the last tick into the scan bitmap and selects the next row.
+ *        The fourth tick completes the scan and runs the debounce.
+ *
+ * @return true if events were queued (the main loop should drain them).
+ */
+bool keypad_tick(keypad_handle_t* keypad) {
+    if (!atomic_load(&keypad->scanning)) {
+        return false;
+    }
+    const uint16_t before = ring_buffer_spsc_count(&keypad->events);
+    const uint8_t row = keypad->row;
+
+    for (uint8_t col = 0; col < KEYPAD_COLS; col++) {
+        if (HAL_GPIO_ReadPin(keypad->col_ports[col], keypad->col_pins[col]) == GPIO_PIN_RESET) {
+            keypad->scan |= (uint16_t)(1U << (row * KEYPAD_COLS + col));
+        }
+    }
+
+    // Held time counts every tick, not only when a scan completes
+    for (uint8_t index = 0; index < KEYPAD_KEYS; index++) {
+        if ((keypad->pressed & (1U << index)) && keypad->held_ticks[index] < KEYPAD_LONG_PRESS_TICKS) {
+            if (++keypad->held_ticks[index] == KEYPAD_LONG_PRESS_TICKS) {
+                keypad_push(keypad, KEYPAD_EVENT_LONG_PRESS, keypad_key(index));
+            }
+        }
+    }
+
+    HAL_GPIO_WritePin(keypad->row_ports[row], keypad->row_pins[row], GPIO_PIN_SET);
+    keypad->row = (uint8_t)((row + 1U) % KEYPAD_ROWS);
+
+    bool settled = false;
+    if (keypad->row == 0) {
+        settled = keypad_scan_done(keypad);
+        keypad->scan = 0;
+    }
+    if (settled) {
+        // Whole matrix idle: back to waiting for a column EXTI. An EXTI raised while
+        // the rows go low still finds scanning set and is dropped, so a key pressed
+        // in the meantime is picked up from the columns here
+        HAL_TIM_Base_Stop_IT(keypad->htim);
+        keypad_drive_rows(keypad, GPIO_PIN_RESET);
+        atomic_store(&keypad->scanning, false);
+        for (uint8_t col = 0; col < KEYPAD_COLS; col++) {
+            if (HAL_GPIO_ReadPin(keypad->col_ports[col], keypad->col_pins[col]) == GPIO_PIN_RESET) {
+                keypad_wake(keypad);
+                break;
+            }
+        }
+    } else {
+        HAL_GPIO_WritePin(keypad->row_ports[keypad->row], keypad->row_pins[keypad->row], GPIO_PIN_RESET);
+    }
+    return ring_buffer_spsc_count(&keypad->events) != before;
+}
+
+/**
+ * @brief Takes the oldest event from the queue. Main loop only.
+ *
+ * @return false if the queue is empty.
+ */
+bool keypad_get_event(keypad_handle_t* keypad, keypad_event_t *event) {
+    const uint8_t *bytes;
+    // Records start on multiples of KEYPAD_EVENT_SIZE, so a whole one is always contiguous
+    if (ring_buffer_spsc_peek_contiguous(&keypad->events, &bytes) < KEYPAD_EVENT_SIZE) {
+        return false;
+    }
+    event->type = (keypad_event_type_t)bytes[0];
+    event->key = (char)bytes[1];
+    event->keys = (uint16_t)(bytes[2] | (bytes[3] << 8));
+    ring_buffer_spsc_consume(&keypad->events, KEYPAD_EVENT_SIZE);
+    return true;
+}
+
+/**
+ * @brief Returns true while the scan timer runs (a key is down or still settling).
+ */
+bool keypad_is_scanning(keypad_handle_t* keypad) {
+    return atomic_load(&keypad->scanning);
+}
+
+/**
+ * @brief Bitmap of the given keys, to compare with keypad_event_t.keys.
+ *        Characters that are not on the keypad are ignored.
+ */
+uint16_t keypad_key_mask(const char *keys) {
+    uint16_t mask = 0;
+    for (; *keys != '\0'; keys++) {
+        for (uint8_t index = 0; index < KEYPAD_KEYS; index++) {
+            if (keypad_key(index) == *keys) {
+                mask |= (uint16_t)(1U << index);
+            }
+        }
+    }
+    return mask;
+}
@@ -2,19 +2,89 @@
 #define KEYPAD_DRIVER_H
 
 #include "main.h"
+#include "ring_buffer.h"
 #include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/*
+ * Non-blocking 4x4 keypad scanner. While idle, all rows are driven low and a
+ * key press pulls its column down, which raises the column EXTI; the EXTI
+ * callback calls keypad_wake(). That starts a periodic timer whose interrupt
+ * calls keypad_tick(): each tick reads the columns of the row driven low
+ * since the previous tick (so the lines have settled without delay loops) and
+ * moves on to the next row.
+ *
+ * Four ticks make a full scan: a 16-bit bitmap of the keys that read pressed,
+ * bit row * KEYPAD_COLS + col. Every key has an integrator, counted up on a
+ * scan that sees it pressed and down on one that does not; it is debounced
+ * pressed when it saturates and released when it drains, so contact bounce
+ * shorter than KEYPAD_DEBOUNCE_SCANS full scans is ignored. The debounced
+ * bitmap of each scan is diffed against the previous one and every changed
+ * bit becomes an event, so any number of keys can go down or up together.
+ *
+ * The matrix has no diodes: with three corners of a rectangle held, the
+ * fourth reads pressed as well. A scan where two rows share two or more
+ * columns is ambiguous for those keys; their integrators are held until the
+ * pattern clears and KEYPAD_EVENT_GHOST flags it. The other keys go on as
+ * usual.
+ *
+ * Events go into a single-producer/single-consumer queue that the main loop
+ * drains with keypad_get_event(). Each one carries the debounced bitmap right
+ * after it, so a chord is a press whose bitmap holds every key of the chord
+ * (see keypad_key_mask()). Once every integrator is back at zero the timer
+ * stops and the rows return to low, waiting for the next EXTI.
+ */
 
 #define KEYPAD_ROWS 4
 #define KEYPAD_COLS 4
+#define KEYPAD_KEYS (KEYPAD_ROWS * KEYPAD_COLS)
+
+#define KEYPAD_TICK_MS          1       // one row per tick: the whole matrix every 4 ms
+#define KEYPAD_DEBOUNCE_SCANS   5       // full scans to saturate an integrator: 20 ms
+#define KEYPAD_LONG_PRESS_MS    1000    // held this long: KEYPAD_EVENT_LONG_PRESS
+#define KEYPAD_QUEUE_SIZE       64      // bytes, power of two: 16 events
+
+typedef enum {
+    KEYPAD_EVENT_PRESS,
+    KEYPAD_EVENT_RELEASE,
+    KEYPAD_EVENT_LONG_PRESS,    // once per press, the release still follows
+    KEYPAD_EVENT_GHOST          // a scan became ambiguous, key is '\0'
+} keypad_event_type_t;
+
+typedef struct {
+    keypad_event_type_t type;
+    char key;
+    uint16_t keys;              // debounced bitmap once this event applied
+} keypad_event_t;
 
 typedef struct {
     GPIO_TypeDef* row_ports[KEYPAD_ROWS];
     uint16_t row_pins[KEYPAD_ROWS];
     GPIO_TypeDef* col_ports[KEYPAD_COLS];
     uint16_t col_pins[KEYPAD_COLS];
+
+    // Scanner state, owned by the timer interrupt while scanning
+    TIM_HandleTypeDef *htim;            // ticks every KEYPAD_TICK_MS with its update interrupt
+    atomic_bool scanning;
+    uint8_t row;                        // row driven low, read at the next tick
+    uint16_t scan;                      // raw bitmap of the scan in progress
+    uint16_t ghost;                     // keys held by an ambiguous scan
+    uint8_t integrator[KEYPAD_KEYS];    // index row * KEYPAD_COLS + col
+    uint16_t held_ticks[KEYPAD_KEYS];   // since the press was reported, saturates
+    uint16_t pressed;                   // debounced bitmap
+
+    ring_buffer_spsc_t events;          // whole four-byte records: type, key, keys
+    uint8_t events_storage[KEYPAD_QUEUE_SIZE];
+    uint32_t dropped;                   // events lost to a full queue
+    uint32_t ghost_scans;               // scans with ambiguous keys
 } keypad_handle_t;
 
-void keypad_init(keypad_handle_t* keypad);
-char keypad_scan(keypad_handle_t* keypad, uint16_t col_pin);
+void keypad_init(keypad_handle_t* keypad, TIM_HandleTypeDef *htim);
+void keypad_wake(keypad_handle_t* keypad);
+bool keypad_tick(keypad_handle_t* keypad);
+bool keypad_get_event(keypad_handle_t* keypad, keypad_event_t *event);
+bool keypad_is_scanning(keypad_handle_t* keypad);
+uint16_t keypad_key_mask(const char *keys);
 
-#endif // KEYPAD_DRIVER_H
\ No newline at end of file
+#endif // KEYPAD_DRIVER_H
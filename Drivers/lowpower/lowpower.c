@@ -0,0 +1,79 @@
+#include "lowpower.h"
+#include <string.h>
+
+static lowpower_stop_allowed_fn_t stop_allowed_fn;
+static lowpower_mode_t max_mode;
+static uint32_t tick_carry;         // LPTIM1 ticks slept but not yet a whole millisecond
+static lowpower_stats_t stats;
+
+/**
+ * @brief Prepares LPTIM1 and allows every mode up to STOP2.
+ *
+ * @param stop_allowed Veto for STOP2, NULL to never enter it.
+ */
+void lowpower_init(lowpower_stop_allowed_fn_t stop_allowed)
+{
+    stop_allowed_fn = stop_allowed;
+    max_mode = LOWPOWER_STOP2;
+    tick_carry = 0;
+    memset(&stats, 0, sizeof(stats));
+    lowpower_port_init();
+}
+
+/**
+ * @brief Limits the deepest mode lowpower_idle() may choose.
+ */
+void lowpower_set_max_mode(lowpower_mode_t mode)
+{
+    max_mode = mode;
+}
+
+/**
+ * @brief Sleeps until the next interrupt or for at most timeout_ms.
+ *        Scheduler idle hook: called with interrupts masked and nothing queued;
+ *        an interrupt that becomes pending still ends the sleep.
+ *
+ * @param timeout_ms Time to the next scheduler timer, UINT32_MAX if none.
+ */
+void lowpower_idle(uint32_t timeout_ms)
+{
+    if (max_mode == LOWPOWER_SLEEP || timeout_ms < LOWPOWER_MIN_TICKLESS_MS) {
+        stats.sleeps++;
+        __WFI();
+        return;
+    }
+
+    const uint32_t ms = (timeout_ms < LOWPOWER_MAX_SLEEP_MS) ? timeout_ms : LOWPOWER_MAX_SLEEP_MS;
+    lowpower_mode_t mode = LOWPOWER_SLEEP_TICKLESS;
+    if (max_mode == LOWPOWER_STOP2 && ms >= LOWPOWER_MIN_STOP2_MS &&
+        stop_allowed_fn != NULL && stop_allowed_fn()) {
+        mode = LOWPOWER_STOP2;
+    }
+
+    // The port stops the SysTick counter on an LPTIM1 tick edge and restarts it on
+    // one, so the ticks it returns are exactly the time SysTick missed. Crediting
+    // them, with the fractions of a millisecond carried over, keeps HAL_GetTick()
+    // from drifting.
+    const uint32_t ticks = lowpower_port_sleep(mode, ms) + tick_carry;
+    const uint32_t slept = ticks / LOWPOWER_TICKS_PER_MS;
+    tick_carry = ticks % LOWPOWER_TICKS_PER_MS;
+    uwTick += slept;
+
+    if (mode == LOWPOWER_STOP2) {
+        stats.stop2++;
+    } else {
+        stats.tickless++;
+    }
+    if (slept < ms) {
+        stats.early_wakes++;
+    }
+    stats.slept_ms += slept;
+    if (slept > stats.max_sleep_ms) {
+        stats.max_sleep_ms = slept;
+    }
+}
+
+void lowpower_get_stats(lowpower_stats_t *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,61 @@
+#ifndef LOWPOWER_H
+#define LOWPOWER_H
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Tickless idle for the scheduler (installed with sched_set_idle_hook()).
+ *
+ * With nothing queued, the scheduler hands over the time to its next timer.
+ * A short wait is a plain WFI with SysTick running. A longer one stops
+ * SysTick, arms the LPTIM1 wakeup for the deadline and sleeps through it in
+ * one go, either in Sleep mode (peripherals keep running) or in STOP2 when
+ * the application's stop_allowed() callback agrees that no peripheral is in
+ * use. Any interrupt (keypad EXTI, UART, DMA) ends the sleep early. On wakeup
+ * HAL_GetTick() is advanced by the time LPTIM1 counted, so the timer wheel
+ * and every timeout carry on as if SysTick had been running.
+ *
+ * Hardware side (the port): lowpower_stm32l4.c on the target,
+ * Sim/Src/sim_lowpower.c in the host simulator.
+ */
+
+#define LOWPOWER_MIN_TICKLESS_MS 3      // shorter waits are a WFI with SysTick running
+#define LOWPOWER_MIN_STOP2_MS    10     // STOP2 exit relocks the PLL: not worth it below this
+#define LOWPOWER_MAX_SLEEP_MS    2000   // LPTIM1 counts 16 bits at 32 kHz: 2047 ms
+#define LOWPOWER_WAKE_LATENCY_US 100    // wake-up to the interrupt handler, worst case: STOP2 exit,
+                                        // PLL relock and the LPTIM1 edge that restarts SysTick
+#define LOWPOWER_TICKS_PER_MS    32U    // LPTIM1 on LSI (32 kHz), no prescaler
+
+typedef enum {
+    LOWPOWER_SLEEP,             // WFI, SysTick wakes the core every millisecond
+    LOWPOWER_SLEEP_TICKLESS,    // WFI with SysTick stopped, LPTIM1 wakes at the deadline
+    LOWPOWER_STOP2              // STOP2: clocks off except LSI, LPTIM1 and EXTI wake
+} lowpower_mode_t;
+
+typedef struct {
+    uint32_t sleeps;            // plain WFI with SysTick running
+    uint32_t tickless;          // tickless Sleep mode entries
+    uint32_t stop2;             // STOP2 entries
+    uint32_t early_wakes;       // tickless or STOP2 ended by an interrupt before the deadline
+    uint32_t slept_ms;          // milliseconds credited to HAL_GetTick() after tickless sleeps
+    uint32_t max_sleep_ms;      // longest single tickless sleep
+} lowpower_stats_t;
+
+/// @brief Returns true if STOP2 may be entered now; called with interrupts masked.
+typedef bool (*lowpower_stop_allowed_fn_t)(void);
+
+void lowpower_init(lowpower_stop_allowed_fn_t stop_allowed);
+void lowpower_set_max_mode(lowpower_mode_t mode);
+void lowpower_idle(uint32_t timeout_ms);
+void lowpower_get_stats(lowpower_stats_t *stats);
+
+/* Port: wakeup timer and low-power entry. lowpower_port_sleep() stops SysTick
+   on an LPTIM1 tick edge, restarts it on another after the wakeup and returns
+   the ticks in between (LOWPOWER_TICKS_PER_MS per millisecond). */
+void lowpower_port_init(void);
+uint32_t lowpower_port_sleep(lowpower_mode_t mode, uint32_t ms);
+void lowpower_port_irq_handler(void);
+
+#endif // LOWPOWER_H
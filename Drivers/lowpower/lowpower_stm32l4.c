@@ -0,0 +1,121 @@
+#include "lowpower.h"
+
+/*
+ * STM32L476 port: LPTIM1 clocked from LSI counts continuously (32 ticks per
+ * millisecond) and wakes the core with a compare match through EXTI line 32,
+ * which also works in STOP2. The counter wraps every 2.048 s and matches CMP
+ * once per wrap; CMPMIE can only be written with the timer stopped, so the
+ * LPTIM1 interrupt is enabled in the NVIC only for the sleep. The core wakes from STOP2 on HSI16 (STOPWUCK),
+ * the source of the PLL, so only the PLL has to be switched back on.
+ *
+ * USART2 cannot receive in STOP2. While the core is stopped its RX pin (PA3)
+ * is armed as a falling-edge EXTI so the start bit of the first byte wakes it;
+ * that byte is lost, and the application keeps STOP2 off while the console is
+ * in use (see its stop_allowed callback).
+ */
+
+#define LPTIM_PERIOD 0x10000U
+
+static uint32_t lowpower_lptim_count(void)
+{
+    // The counter runs on its own clock: two equal reads in a row are a valid value
+    uint32_t a, b = LPTIM1->CNT;
+    do {
+        a = b;
+        b = LPTIM1->CNT;
+    } while (a != b);
+    return a;
+}
+
+/* Busy-waits for the next tick edge, at most one tick (31 us), and returns the new count */
+static uint32_t lowpower_lptim_edge(void)
+{
+    const uint32_t count = lowpower_lptim_count();
+    uint32_t next;
+    do {
+        next = lowpower_lptim_count();
+    } while (next == count);
+    return next;
+}
+
+static void lowpower_restore_clock(void)
+{
+    __HAL_RCC_PLL_ENABLE();
+    while (__HAL_RCC_GET_FLAG(RCC_FLAG_PLLRDY) == 0U) {
+    }
+    __HAL_RCC_SYSCLK_CONFIG(RCC_SYSCLKSOURCE_PLLCLK);
+    while (__HAL_RCC_GET_SYSCLK_SOURCE() != RCC_SYSCLKSOURCE_STATUS_PLLCLK) {
+    }
+}
+
+void lowpower_port_init(void)
+{
+    SET_BIT(RCC->CSR, RCC_CSR_LSION);
+    while (READ_BIT(RCC->CSR, RCC_CSR_LSIRDY) == 0U) {
+    }
+    MODIFY_REG(RCC->CCIPR, RCC_CCIPR_LPTIM1SEL, RCC_CCIPR_LPTIM1SEL_0);    // LSI
+    __HAL_RCC_LPTIM1_CLK_ENABLE();
+    SET_BIT(RCC->CFGR, RCC_CFGR_STOPWUCK);                                  // wake on HSI16
+
+    // IER and CFGR are written with the timer disabled, ARR with it enabled. The compare
+    // interrupt stays enabled here; the NVIC line is what lowpower_port_sleep() opens
+    LPTIM1->CR = 0;
+    LPTIM1->CFGR = 0;
+    LPTIM1->IER = LPTIM_IER_CMPMIE;
+    LPTIM1->CR = LPTIM_CR_ENABLE;
+    LPTIM1->ARR = LPTIM_PERIOD - 1U;
+    while ((LPTIM1->ISR & LPTIM_ISR_ARROK) == 0U) {
+    }
+    LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+    LPTIM1->CR = LPTIM_CR_ENABLE | LPTIM_CR_CNTSTRT;
+
+    SET_BIT(EXTI->IMR2, EXTI_IMR2_IM32);
+    HAL_NVIC_SetPriority(LPTIM1_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(EXTI3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(EXTI3_IRQn);
+}
+
+uint32_t lowpower_port_sleep(lowpower_mode_t mode, uint32_t ms)
+{
+    // SysTick stops in STOP2 anyway; held in Sleep too, its phase resumes where it was.
+    // It stops and restarts right after an LPTIM1 tick edge, so the ticks counted in
+    // between are exactly the time it was held, with no fraction of a tick lost
+    const uint32_t start = lowpower_lptim_edge();
+    CLEAR_BIT(SysTick->CTRL, SysTick_CTRL_ENABLE_Msk);
+
+    LPTIM1->CMP = (start + ms * LOWPOWER_TICKS_PER_MS) & (LPTIM_PERIOD - 1U);
+    while ((LPTIM1->ISR & LPTIM_ISR_CMPOK) == 0U) {
+    }
+    LPTIM1->ICR = LPTIM_ICR_CMPOKCF | LPTIM_ICR_CMPMCF;
+    HAL_NVIC_ClearPendingIRQ(LPTIM1_IRQn);
+    HAL_NVIC_EnableIRQ(LPTIM1_IRQn);
+
+    if (mode == LOWPOWER_STOP2) {
+        __HAL_GPIO_EXTI_CLEAR_IT(GPIO_PIN_3);
+        SET_BIT(EXTI->FTSR1, EXTI_FTSR1_FT3);
+        SET_BIT(EXTI->IMR1, EXTI_IMR1_IM3);
+        HAL_PWREx_EnterSTOP2Mode(PWR_STOPENTRY_WFI);
+        lowpower_restore_clock();
+        CLEAR_BIT(EXTI->IMR1, EXTI_IMR1_IM3);
+        CLEAR_BIT(EXTI->FTSR1, EXTI_FTSR1_FT3);
+    } else {
+        __WFI();
+    }
+    // Awake, the free-running counter must not interrupt at the next match of CMP
+    HAL_NVIC_DisableIRQ(LPTIM1_IRQn);
+    LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+    HAL_NVIC_ClearPendingIRQ(LPTIM1_IRQn);
+
+    const uint32_t end = lowpower_lptim_edge();
+    SET_BIT(SysTick->CTRL, SysTick_CTRL_ENABLE_Msk);
+    return (end - start) & (LPTIM_PERIOD - 1U);
+}
+
+/**
+ * @brief LPTIM1 and EXTI3 interrupts: only wake the core, lowpower_idle() does the rest.
+ */
+void lowpower_port_irq_handler(void)
+{
+    LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+    __HAL_GPIO_EXTI_CLEAR_IT(GPIO_PIN_3);
+}
@@ -1,16 +1,43 @@
 #include "ring_buffer.h"
+#include <string.h>
 
+/**
+ * @brief Moves an index of the ring buffer n positions forward, wrapping at capacity.
+ */
+static inline uint16_t ring_buffer_advance(const ring_buffer_t *rb, uint16_t index, uint16_t n)
+{
+#ifdef RING_BUFFER_POW2
+    return (uint16_t)((index + n) & (rb->capacity - 1U));
+#else
+    return (uint16_t)((index + n) % rb->capacity);
+#endif
+}
 
 /**
  * @brief Initializes a ring buffer and its variables to their initial values.
-*/
-void ring_buffer_init(ring_buffer_t *rb, uint8_t *buffer, uint16_t capacity) 
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param buffer Storage of capacity bytes.
+ * @param capacity Size of the storage; a power of two when built with RING_BUFFER_POW2.
+ * @return true on success, false if capacity is not valid (rb is left untouched).
+ */
+bool ring_buffer_init(ring_buffer_t *rb, uint8_t *buffer, uint16_t capacity)
 {
+#ifdef RING_BUFFER_POW2
+    if (!RING_BUFFER_IS_POW2(capacity)) {
+        return false;
+    }
+#else
+    if (capacity == 0) {
+        return false;
+    }
+#endif
     rb->buffer = buffer;
     rb->capacity = capacity;
     rb->head = 0;
     rb->tail = 0;
     rb->full = false;
+    return true;
 }
 
 /**
@@ -24,10 +51,10 @@ bool ring_buffer_write(ring_buffer_t *rb, uint8_t data)
 {
     if (rb->full) {
         // If the buffer is full, we overwrite the oldest data
-        rb->tail = (rb->tail + 1) % rb->capacity;
+        rb->tail = ring_buffer_advance(rb, rb->tail, 1);
     }
     rb->buffer[rb->head] = data;
-    rb->head = (rb->head + 1) % rb->capacity;
+    rb->head = ring_buffer_advance(rb, rb->head, 1);
     rb->full = (rb->head == rb->tail);
     return true;
 }
@@ -46,7 +73,7 @@ bool ring_buffer_read(ring_buffer_t *rb, uint8_t *data)
         return false;
     }
     *data = rb->buffer[rb->tail];
-    rb->tail = (rb->tail + 1) % rb->capacity;
+    rb->tail = ring_buffer_advance(rb, rb->tail, 1);
     rb->full = false; // After reading, the buffer can't be full
     return true;
 }
@@ -102,3 +129,308 @@ void ring_buffer_flush(ring_buffer_t *rb)
     rb->tail = 0;
     rb->full = false;
 }
+
+/**
+ * @brief Writes a block of data with at most two memcpy's, discarding old data
+ *        if it does not fit, like ring_buffer_write().
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param data The bytes to write.
+ * @param len Number of bytes. If larger than the capacity only the last
+ *            capacity bytes are kept.
+ * @return The number of bytes written (len).
+ */
+uint16_t ring_buffer_write_bulk(ring_buffer_t *rb, const uint8_t *data, uint16_t len)
+{
+    const uint16_t written = len;
+
+    if (len > rb->capacity) {
+        data += len - rb->capacity;
+        len = rb->capacity;
+    }
+    const uint16_t space = rb->capacity - ring_buffer_count(rb);
+    const uint16_t first = (len < rb->capacity - rb->head) ? len : rb->capacity - rb->head;
+
+    memcpy(&rb->buffer[rb->head], data, first);
+    memcpy(rb->buffer, data + first, len - first);
+    rb->head = ring_buffer_advance(rb, rb->head, len);
+    if (len >= space) {
+        // The oldest data was overwritten (or the block exactly filled the buffer)
+        rb->tail = rb->head;
+        rb->full = true;
+    }
+    return written;
+}
+
+/**
+ * @brief Reads up to len bytes of data with at most two memcpy's.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param data Pointer to where the read data will be stored.
+ * @param len Maximum number of bytes to read.
+ * @return The number of bytes read, 0 if the buffer is empty.
+ */
+uint16_t ring_buffer_read_bulk(ring_buffer_t *rb, uint8_t *data, uint16_t len)
+{
+    const uint16_t count = ring_buffer_count(rb);
+
+    if (len > count) {
+        len = count;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    const uint16_t first = (len < rb->capacity - rb->tail) ? len : rb->capacity - rb->tail;
+
+    memcpy(data, &rb->buffer[rb->tail], first);
+    memcpy(data + first, rb->buffer, len - first);
+    rb->tail = ring_buffer_advance(rb, rb->tail, len);
+    rb->full = false;
+    return len;
+}
+
+/**
+ * @brief Returns the oldest readable bytes in place, without copying them.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param data Set to the first readable byte inside the buffer storage.
+ * @return Number of contiguous readable bytes at *data, 0 if the buffer is empty.
+ *         Data past the end of the storage is returned by the next call, after
+ *         ring_buffer_consume().
+ */
+uint16_t ring_buffer_peek_contiguous(ring_buffer_t *rb, const uint8_t **data)
+{
+    *data = &rb->buffer[rb->tail];
+    if (ring_buffer_is_empty(rb)) {
+        return 0;
+    }
+    if (rb->tail < rb->head) {
+        return rb->head - rb->tail;
+    }
+    return rb->capacity - rb->tail;
+}
+
+/**
+ * @brief Discards the oldest bytes, typically after processing them in place
+ *        through ring_buffer_peek_contiguous().
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param len Number of bytes to discard; limited to the bytes in the buffer.
+ */
+void ring_buffer_consume(ring_buffer_t *rb, uint16_t len)
+{
+    const uint16_t count = ring_buffer_count(rb);
+
+    if (len > count) {
+        len = count;
+    }
+    if (len == 0) {
+        return;
+    }
+    rb->tail = ring_buffer_advance(rb, rb->tail, len);
+    rb->full = false;
+}
+
+/**
+ * @brief Returns the free space after the newest byte so that it can be
+ *        filled in place (e.g. by a DMA transfer) before ring_buffer_commit().
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param data Set to the first free byte inside the buffer storage.
+ * @return Number of contiguous free bytes at *data, 0 if the buffer is full.
+ */
+uint16_t ring_buffer_reserve(ring_buffer_t *rb, uint8_t **data)
+{
+    *data = &rb->buffer[rb->head];
+    if (rb->full) {
+        return 0;
+    }
+    if (rb->head < rb->tail) {
+        return rb->tail - rb->head;
+    }
+    return rb->capacity - rb->head;
+}
+
+/**
+ * @brief Makes bytes written through ring_buffer_reserve() readable.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param len Number of bytes written; limited to the free space, since commit
+ *            never overwrites unread data.
+ */
+void ring_buffer_commit(ring_buffer_t *rb, uint16_t len)
+{
+    const uint16_t space = rb->capacity - ring_buffer_count(rb);
+
+    if (len > space) {
+        len = space;
+    }
+    if (len == 0) {
+        return;
+    }
+    rb->head = ring_buffer_advance(rb, rb->head, len);
+    rb->full = (rb->head == rb->tail);
+}
+
+/**
+ * @brief Initializes a single-producer/single-consumer ring buffer.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param buffer Storage of capacity bytes.
+ * @param capacity Size of the storage, a power of two no larger than 32768.
+ * @return true on success, false if capacity is not a valid power of two.
+ */
+bool ring_buffer_spsc_init(ring_buffer_spsc_t *rb, uint8_t *buffer, uint16_t capacity)
+{
+    if (!RING_BUFFER_IS_POW2(capacity) || capacity > 32768U) {
+        return false;
+    }
+    rb->buffer = buffer;
+    rb->mask = capacity - 1U;
+    atomic_init(&rb->head, 0);
+    atomic_init(&rb->tail, 0);
+    return true;
+}
+
+/**
+ * @brief Writes a byte of data. Producer side only.
+ *
+ * Unlike ring_buffer_write() the oldest data is never overwritten, since that
+ * would move the consumer's index: a full buffer rejects the new byte.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param data The byte of data to write.
+ * @return true if the write was successful, false if the buffer is full.
+ */
+bool ring_buffer_spsc_write(ring_buffer_spsc_t *rb, uint8_t data)
+{
+    const uint16_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    const uint16_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+
+    if ((uint16_t)(head - tail) > rb->mask) {
+        return false;
+    }
+    rb->buffer[head & rb->mask] = data;
+    // Publish the byte before the index that makes it visible
+    atomic_store_explicit(&rb->head, (uint16_t)(head + 1U), memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Reads a byte of data. Consumer side only.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param data Pointer to where the read data will be stored.
+ * @return true if the read was successful, false if the buffer is empty.
+ */
+bool ring_buffer_spsc_read(ring_buffer_spsc_t *rb, uint8_t *data)
+{
+    const uint16_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    const uint16_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+
+    if (head == tail) {
+        return false;
+    }
+    *data = rb->buffer[tail & rb->mask];
+    // The slot is handed back to the producer only after it has been read
+    atomic_store_explicit(&rb->tail, (uint16_t)(tail + 1U), memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Returns the number of bytes in the buffer. Callable from either side;
+ *        the result is exact for the caller's own index and a lower (consumer)
+ *        or upper (producer) bound of the other side.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @return The number of bytes in the buffer.
+ */
+uint16_t ring_buffer_spsc_count(ring_buffer_spsc_t *rb)
+{
+    const uint16_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    const uint16_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+    return (uint16_t)(head - tail);
+}
+
+/**
+ * @brief Checks if the single-producer/single-consumer buffer is empty.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @return true if the buffer is empty, false otherwise.
+ */
+bool ring_buffer_spsc_is_empty(ring_buffer_spsc_t *rb)
+{
+    return ring_buffer_spsc_count(rb) == 0;
+}
+
+/**
+ * @brief Checks if the single-producer/single-consumer buffer is full.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @return true if the buffer is full, false otherwise.
+ */
+bool ring_buffer_spsc_is_full(ring_buffer_spsc_t *rb)
+{
+    return ring_buffer_spsc_count(rb) > rb->mask;
+}
+
+/**
+ * @brief Writes a block of data with at most two memcpy's. Producer side only.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param data The bytes to write.
+ * @param len Number of bytes.
+ * @return The number of bytes written; less than len if the buffer filled up.
+ */
+uint16_t ring_buffer_spsc_write_bulk(ring_buffer_spsc_t *rb, const uint8_t *data, uint16_t len)
+{
+    const uint16_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    const uint16_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+    const uint16_t space = (uint16_t)(rb->mask + 1U - (uint16_t)(head - tail));
+
+    if (len > space) {
+        len = space;
+    }
+    const uint16_t index = head & rb->mask;
+    const uint16_t first = (len < rb->mask + 1U - index) ? len : (uint16_t)(rb->mask + 1U - index);
+
+    memcpy(&rb->buffer[index], data, first);
+    memcpy(rb->buffer, data + first, len - first);
+    atomic_store_explicit(&rb->head, (uint16_t)(head + len), memory_order_release);
+    return len;
+}
+
+/**
+ * @brief Returns the oldest readable bytes in place. Consumer side only.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param data Set to the first readable byte inside the buffer storage.
+ * @return Number of contiguous readable bytes at *data, 0 if the buffer is empty.
+ */
+uint16_t ring_buffer_spsc_peek_contiguous(ring_buffer_spsc_t *rb, const uint8_t **data)
+{
+    const uint16_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    const uint16_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+    const uint16_t count = (uint16_t)(head - tail);
+    const uint16_t index = tail & rb->mask;
+
+    *data = &rb->buffer[index];
+    return (count < rb->mask + 1U - index) ? count : (uint16_t)(rb->mask + 1U - index);
+}
+
+/**
+ * @brief Hands the oldest len bytes back to the producer. Consumer side only.
+ *
+ * @param rb Pointer to the ring buffer.
+ * @param len Number of bytes; limited to the bytes in the buffer.
+ */
+void ring_buffer_spsc_consume(ring_buffer_spsc_t *rb, uint16_t len)
+{
+    const uint16_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    const uint16_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+
+    if (len > (uint16_t)(head - tail)) {
+        len = (uint16_t)(head - tail);
+    }
+    atomic_store_explicit(&rb->tail, (uint16_t)(tail + len), memory_order_release);
+}
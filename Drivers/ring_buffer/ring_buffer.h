@@ -3,6 +3,15 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+
+/*
+ * Build with RING_BUFFER_POW2 defined to wrap the ring_buffer_t indices with a
+ * mask instead of a modulo (a hardware divide on the Cortex-M4). Every
+ * ring_buffer_t capacity must then be a power of two: ring_buffer_init()
+ * rejects any other, and RING_BUFFER_IS_POW2() checks it at compile time.
+ */
+#define RING_BUFFER_IS_POW2(n) ((n) != 0 && ((n) & ((n) - 1)) == 0)
 
 typedef struct {
     uint8_t *buffer;
@@ -12,12 +21,48 @@ typedef struct {
     bool full;
 } ring_buffer_t;
 
-void ring_buffer_init(ring_buffer_t *rb, uint8_t *buffer, uint16_t capacity);
+bool ring_buffer_init(ring_buffer_t *rb, uint8_t *buffer, uint16_t capacity);
 bool ring_buffer_write(ring_buffer_t *rb, uint8_t data);
 bool ring_buffer_read(ring_buffer_t *rb, uint8_t *data);
 uint16_t ring_buffer_count(ring_buffer_t *rb);
 bool ring_buffer_is_empty(ring_buffer_t *rb);
 bool ring_buffer_is_full(ring_buffer_t *rb);
 void ring_buffer_flush(ring_buffer_t *rb);
+uint16_t ring_buffer_write_bulk(ring_buffer_t *rb, const uint8_t *data, uint16_t len);
+uint16_t ring_buffer_read_bulk(ring_buffer_t *rb, uint8_t *data, uint16_t len);
+
+/*
+ * Zero-copy access to the storage given to ring_buffer_init(): peek/consume
+ * expose the oldest readable bytes in place, reserve/commit the free space
+ * after the newest byte (these never overwrite). Each call returns one
+ * contiguous span; a region that wraps takes two rounds.
+ */
+uint16_t ring_buffer_peek_contiguous(ring_buffer_t *rb, const uint8_t **data);
+void ring_buffer_consume(ring_buffer_t *rb, uint16_t len);
+uint16_t ring_buffer_reserve(ring_buffer_t *rb, uint8_t **data);
+void ring_buffer_commit(ring_buffer_t *rb, uint16_t len);
+
+/*
+ * Single-producer/single-consumer variant, safe between an ISR and the main
+ * loop without disabling interrupts. head is only written by the producer and
+ * tail only by the consumer; both run freely and wrap at 2^16, so capacity
+ * must be a power of two (at most 32768) and there is no shared full flag.
+ */
+typedef struct {
+    uint8_t *buffer;
+    _Atomic uint16_t head;
+    _Atomic uint16_t tail;
+    uint16_t mask;
+} ring_buffer_spsc_t;
+
+bool ring_buffer_spsc_init(ring_buffer_spsc_t *rb, uint8_t *buffer, uint16_t capacity);
+bool ring_buffer_spsc_write(ring_buffer_spsc_t *rb, uint8_t data);
+bool ring_buffer_spsc_read(ring_buffer_spsc_t *rb, uint8_t *data);
+uint16_t ring_buffer_spsc_count(ring_buffer_spsc_t *rb);
+bool ring_buffer_spsc_is_empty(ring_buffer_spsc_t *rb);
+bool ring_buffer_spsc_is_full(ring_buffer_spsc_t *rb);
+uint16_t ring_buffer_spsc_write_bulk(ring_buffer_spsc_t *rb, const uint8_t *data, uint16_t len);
+uint16_t ring_buffer_spsc_peek_contiguous(ring_buffer_spsc_t *rb, const uint8_t **data);
+void ring_buffer_spsc_consume(ring_buffer_spsc_t *rb, uint16_t len);
 
 #endif // RING_BUFFER_H
@@ -0,0 +1,238 @@
+#include "scheduler.h"
+#include <string.h>
+
+typedef struct {
+    sched_fn_t fn;
+    void *ctx;
+    uint32_t arg;
+} sched_event_t;
+
+static sched_event_t queue[SCHED_QUEUE_SIZE];
+static volatile uint16_t queue_head;    // written by sched_post(), under the critical section
+static volatile uint16_t queue_tail;    // written by sched_run() only
+
+static sched_timer_t *wheel[SCHED_WHEEL_SLOTS];
+static uint32_t wheel_tick;             // last tick whose slot was visited
+
+static sched_idle_fn_t idle_hook;
+
+static sched_stats_t stats;
+
+static sched_timer_t **sched_slot(uint32_t tick)
+{
+    return &wheel[tick & (SCHED_WHEEL_SLOTS - 1)];
+}
+
+static void sched_link(sched_timer_t *timer)
+{
+    sched_timer_t **slot = sched_slot(timer->expiry);
+    timer->next = *slot;
+    *slot = timer;
+    timer->active = true;
+}
+
+static void sched_unlink(sched_timer_t *timer)
+{
+    for (sched_timer_t **p = sched_slot(timer->expiry); *p != NULL; p = &(*p)->next) {
+        if (*p == timer) {
+            *p = timer->next;
+            break;
+        }
+    }
+    timer->next = NULL;
+    timer->active = false;
+}
+
+/**
+ * @brief Fires the timers of one slot that are due at now. A callback may start
+ *        or stop any timer, so the slot is searched again after each one.
+ */
+static void sched_run_slot(uint32_t tick, uint32_t now)
+{
+    sched_timer_t **slot = sched_slot(tick);
+    sched_timer_t *timer;
+
+    do {
+        for (timer = *slot; timer != NULL; timer = timer->next) {
+            if ((int32_t)(now - timer->expiry) >= 0) {
+                break;
+            }
+        }
+        if (timer != NULL) {
+            sched_unlink(timer);
+            if (timer->period != 0) {
+                // Keep the cadence; after a long stall restart it from now
+                timer->expiry += timer->period;
+                if ((int32_t)(now - timer->expiry) >= 0) {
+                    timer->expiry = now + timer->period;
+                }
+                sched_link(timer);
+            }
+            stats.timer_runs++;
+            timer->fn(timer->ctx, 0);
+        }
+    } while (timer != NULL);
+}
+
+/**
+ * @brief Initializes the scheduler with an empty queue and no timers.
+ */
+void sched_init(void)
+{
+    queue_head = 0;
+    queue_tail = 0;
+    memset(wheel, 0, sizeof(wheel));
+    wheel_tick = HAL_GetTick();
+    idle_hook = NULL;
+    memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * @brief Queues fn(ctx, arg) to run from the main loop. Safe from any ISR.
+ *
+ * @return true if queued, false if the queue was full (the event is counted as dropped).
+ */
+bool sched_post(sched_fn_t fn, void *ctx, uint32_t arg)
+{
+    const uint32_t primask = __get_PRIMASK();
+    bool queued = false;
+
+    __disable_irq();
+    const uint16_t depth = (uint16_t)(queue_head - queue_tail);
+    if (depth < SCHED_QUEUE_SIZE) {
+        sched_event_t *event = &queue[queue_head & (SCHED_QUEUE_SIZE - 1)];
+        event->fn = fn;
+        event->ctx = ctx;
+        event->arg = arg;
+        queue_head++;
+        stats.posted++;
+        if (depth + 1 > stats.max_depth) {
+            stats.max_depth = (uint16_t)(depth + 1);
+        }
+        queued = true;
+    } else {
+        stats.dropped++;
+    }
+    if (!primask) {
+        __enable_irq();
+    }
+    return queued;
+}
+
+/**
+ * @brief Runs every queued event, then every timer that is due. Main loop only.
+ *        Events posted while it runs are handled in the same call.
+ */
+void sched_run(void)
+{
+    while (queue_tail != queue_head) {
+        const sched_event_t event = queue[queue_tail & (SCHED_QUEUE_SIZE - 1)];
+        queue_tail++;
+        stats.dispatched++;
+        event.fn(event.ctx, event.arg);
+    }
+
+    const uint32_t now = HAL_GetTick();
+    uint32_t elapsed = now - wheel_tick;
+    if (elapsed > SCHED_WHEEL_SLOTS) {
+        elapsed = SCHED_WHEEL_SLOTS;    // one revolution visits every slot
+    }
+    for (uint32_t tick = now - elapsed + 1; elapsed > 0; tick++, elapsed--) {
+        sched_run_slot(tick, now);
+    }
+    wheel_tick = now;
+}
+
+/**
+ * @brief Sleeps until the next interrupt unless an event is already waiting.
+ *        Interrupts are masked around the check so a post cannot slip in
+ *        between it and WFI; WFI still wakes on the pending interrupt.
+ *        With an idle hook installed, the hook sleeps instead, told how long
+ *        it may at most.
+ */
+void sched_idle(void)
+{
+    __disable_irq();
+    if (queue_tail == queue_head) {
+        if (idle_hook != NULL) {
+            idle_hook(sched_next_timeout_ms());
+        } else {
+            __WFI();
+        }
+    }
+    __enable_irq();
+}
+
+/**
+ * @brief Installs the function sched_idle() sleeps with, NULL for a plain WFI.
+ */
+void sched_set_idle_hook(sched_idle_fn_t hook)
+{
+    idle_hook = hook;
+}
+
+/**
+ * @brief Milliseconds until the earliest timer expires, 0 if one is due,
+ *        UINT32_MAX if no timer is active.
+ */
+uint32_t sched_next_timeout_ms(void)
+{
+    const uint32_t now = HAL_GetTick();
+    uint32_t best = UINT32_MAX;
+
+    for (uint32_t i = 0; i < SCHED_WHEEL_SLOTS; i++) {
+        for (const sched_timer_t *timer = wheel[i]; timer != NULL; timer = timer->next) {
+            const int32_t left = (int32_t)(timer->expiry - now);
+            const uint32_t ms = left > 0 ? (uint32_t)left : 0;
+            if (ms < best) {
+                best = ms;
+            }
+        }
+    }
+    return best;
+}
+
+void sched_get_stats(sched_stats_t *out)
+{
+    *out = stats;
+}
+
+/**
+ * @brief Prepares a stopped timer that calls fn(ctx, 0) when it fires.
+ */
+void sched_timer_init(sched_timer_t *timer, sched_fn_t fn, void *ctx)
+{
+    timer->next = NULL;
+    timer->fn = fn;
+    timer->ctx = ctx;
+    timer->expiry = 0;
+    timer->period = 0;
+    timer->active = false;
+}
+
+/**
+ * @brief (Re)starts a timer. Main loop only.
+ *
+ * @param timer Timer prepared with sched_timer_init().
+ * @param delay_ms Time to the first expiry; 0 is treated as 1 (next tick).
+ * @param period_ms Interval of the following expiries, 0 for a one-shot timer.
+ */
+void sched_timer_start(sched_timer_t *timer, uint32_t delay_ms, uint32_t period_ms)
+{
+    if (timer->active) {
+        sched_unlink(timer);
+    }
+    timer->expiry = HAL_GetTick() + (delay_ms != 0 ? delay_ms : 1);
+    timer->period = period_ms;
+    sched_link(timer);
+}
+
+/**
+ * @brief Stops a timer; nothing happens if it is not running. Main loop only.
+ */
+void sched_timer_stop(sched_timer_t *timer)
+{
+    if (timer->active) {
+        sched_unlink(timer);
+    }
+}
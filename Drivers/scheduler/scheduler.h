@@ -0,0 +1,63 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Cooperative run-to-completion scheduler for the main loop.
+ *
+ * Events: interrupt handlers call sched_post() to queue a deferred call
+ * (function, context, argument); sched_run() calls them in order from the
+ * main loop, one at a time and each to completion. The queue is a fixed
+ * array guarded by a short PRIMASK critical section, so any ISR may post.
+ *
+ * Timers: a hashed timer wheel of SCHED_WHEEL_SLOTS one-millisecond slots
+ * on HAL_GetTick(). A timer sits in the slot of its expiry tick; each run
+ * visits only the slots of the ticks elapsed since the previous run (at most
+ * one revolution), so the cost does not depend on how far away timers are.
+ * Timers are used from the main loop only, never from an ISR.
+ *
+ * Between runs sched_idle() sleeps with WFI until the next interrupt, or hands
+ * the time to the next timer to an idle hook (e.g. a tickless low-power mode).
+ */
+
+#define SCHED_QUEUE_SIZE  16    // power of two
+#define SCHED_WHEEL_SLOTS 32    // power of two
+
+typedef void (*sched_fn_t)(void *ctx, uint32_t arg);
+
+/// Sleeps for at most timeout_ms (UINT32_MAX: no timer); called with interrupts masked
+typedef void (*sched_idle_fn_t)(uint32_t timeout_ms);
+
+typedef struct sched_timer {
+    struct sched_timer *next;   // next timer in the same wheel slot
+    sched_fn_t fn;
+    void *ctx;
+    uint32_t expiry;            // HAL_GetTick() value at which it fires
+    uint32_t period;            // 0 for a one-shot timer
+    bool active;
+} sched_timer_t;
+
+typedef struct {
+    uint32_t posted;            // events accepted by sched_post()
+    uint32_t dropped;           // events rejected because the queue was full
+    uint32_t dispatched;        // events run by sched_run()
+    uint32_t timer_runs;        // timer callbacks run by sched_run()
+    uint16_t max_depth;         // most events waiting at once
+} sched_stats_t;
+
+void sched_init(void);
+bool sched_post(sched_fn_t fn, void *ctx, uint32_t arg);
+void sched_run(void);
+void sched_idle(void);
+void sched_set_idle_hook(sched_idle_fn_t hook);
+uint32_t sched_next_timeout_ms(void);
+void sched_get_stats(sched_stats_t *stats);
+
+void sched_timer_init(sched_timer_t *timer, sched_fn_t fn, void *ctx);
+void sched_timer_start(sched_timer_t *timer, uint32_t delay_ms, uint32_t period_ms);
+void sched_timer_stop(sched_timer_t *timer);
+
+#endif // SCHEDULER_H
@@ -1,8 +1,16 @@
 #include "ssd1306.h"
-#include <math.h>
 #include <stdlib.h>
 #include <string.h>  // For memcpy
 
+// Bus traffic counters
+static SSD1306_Stats_t SSD1306_Stats;
+
+/* Account one bus transaction carrying len payload bytes */
+static void ssd1306_CountTransfer(size_t len) {
+    SSD1306_Stats.transactions++;
+    SSD1306_Stats.bytes += len + SSD1306_TRANSFER_OVERHEAD;
+}
+
 #if defined(SSD1306_USE_I2C)
 
 void ssd1306_Reset(void) {
@@ -11,11 +19,19 @@ void ssd1306_Reset(void) {
 
 // Send a byte to the command register
 void ssd1306_WriteCommand(uint8_t byte) {
+    ssd1306_CountTransfer(1);
     HAL_I2C_Mem_Write(&SSD1306_I2C_PORT, SSD1306_I2C_ADDR, 0x00, 1, &byte, 1, HAL_MAX_DELAY);
 }
 
+// Send several bytes to the command register in one transaction
+void ssd1306_WriteCommands(uint8_t* buffer, size_t buff_size) {
+    ssd1306_CountTransfer(buff_size);
+    HAL_I2C_Mem_Write(&SSD1306_I2C_PORT, SSD1306_I2C_ADDR, 0x00, 1, buffer, buff_size, HAL_MAX_DELAY);
+}
+
 // Send data
 void ssd1306_WriteData(uint8_t* buffer, size_t buff_size) {
+    ssd1306_CountTransfer(buff_size);
     HAL_I2C_Mem_Write(&SSD1306_I2C_PORT, SSD1306_I2C_ADDR, 0x40, 1, buffer, buff_size, HAL_MAX_DELAY);
 }
 
@@ -34,14 +50,25 @@ void ssd1306_Reset(void) {
 
 // Send a byte to the command register
 void ssd1306_WriteCommand(uint8_t byte) {
+    ssd1306_CountTransfer(1);
     HAL_GPIO_WritePin(SSD1306_CS_Port, SSD1306_CS_Pin, GPIO_PIN_RESET); // select OLED
     HAL_GPIO_WritePin(SSD1306_DC_Port, SSD1306_DC_Pin, GPIO_PIN_RESET); // command
     HAL_SPI_Transmit(&SSD1306_SPI_PORT, (uint8_t *) &byte, 1, HAL_MAX_DELAY);
     HAL_GPIO_WritePin(SSD1306_CS_Port, SSD1306_CS_Pin, GPIO_PIN_SET); // un-select OLED
 }
 
+// Send several bytes to the command register
+void ssd1306_WriteCommands(uint8_t* buffer, size_t buff_size) {
+    ssd1306_CountTransfer(buff_size);
+    HAL_GPIO_WritePin(SSD1306_CS_Port, SSD1306_CS_Pin, GPIO_PIN_RESET); // select OLED
+    HAL_GPIO_WritePin(SSD1306_DC_Port, SSD1306_DC_Pin, GPIO_PIN_RESET); // command
+    HAL_SPI_Transmit(&SSD1306_SPI_PORT, buffer, buff_size, HAL_MAX_DELAY);
+    HAL_GPIO_WritePin(SSD1306_CS_Port, SSD1306_CS_Pin, GPIO_PIN_SET); // un-select OLED
+}
+
 // Send data
 void ssd1306_WriteData(uint8_t* buffer, size_t buff_size) {
+    ssd1306_CountTransfer(buff_size);
     HAL_GPIO_WritePin(SSD1306_CS_Port, SSD1306_CS_Pin, GPIO_PIN_RESET); // select OLED
     HAL_GPIO_WritePin(SSD1306_DC_Port, SSD1306_DC_Pin, GPIO_PIN_SET); // data
     HAL_SPI_Transmit(&SSD1306_SPI_PORT, buffer, buff_size, HAL_MAX_DELAY);
@@ -56,19 +83,79 @@ void ssd1306_WriteData(uint8_t* buffer, size_t buff_size) {
 // Screenbuffer
 static uint8_t SSD1306_Buffer[SSD1306_BUFFER_SIZE];
 
+// Copy of what is currently in the display RAM, valid once a full frame was sent
+static uint8_t SSD1306_Shadow[SSD1306_BUFFER_SIZE];
+static uint8_t SSD1306_ShadowValid = 0;
+
+// Dirty column window per page. A page is clean when min > max.
+static uint8_t SSD1306_DirtyMin[SSD1306_PAGES];
+static uint8_t SSD1306_DirtyMax[SSD1306_PAGES];
+
+// Windows of the flush in progress
+static SSD1306_Window_t SSD1306_Windows[SSD1306_PAGES];
+
+#if defined(SSD1306_USE_I2C)
+// State of the asynchronous flush, advanced from the I2C transfer complete interrupt
+static struct {
+    volatile uint8_t busy;
+    uint8_t count;
+    uint8_t window;
+    uint8_t data_phase;
+    uint8_t cmd[SSD1306_WINDOW_CMD_SIZE];
+} SSD1306_Async;
+
+static void ssd1306_AsyncAbort(void);
+#endif
+
+/* Offset of the first byte of a window in the screenbuffer */
+static uint32_t ssd1306_WindowOffset(const SSD1306_Window_t* window) {
+    return (uint32_t)SSD1306_WIDTH * window->page1 + window->x1;
+}
+
+/* Data bytes of a window. Windows spanning several pages are full width. */
+static uint32_t ssd1306_WindowLength(const SSD1306_Window_t* window) {
+    return (uint32_t)SSD1306_WIDTH * (window->page2 - window->page1) + (window->x2 - window->x1 + 1);
+}
+
 // Screen object
 static SSD1306_t SSD1306;
 
+/* Mark columns x1..x2 of pages page1..page2 as touched since the last flush */
+static void ssd1306_MarkDirty(uint8_t x1, uint8_t x2, uint8_t page1, uint8_t page2) {
+    for (uint8_t page = page1; page <= page2; page++) {
+        if (x1 < SSD1306_DirtyMin[page]) {
+            SSD1306_DirtyMin[page] = x1;
+        }
+        if (x2 > SSD1306_DirtyMax[page]) {
+            SSD1306_DirtyMax[page] = x2;
+        }
+    }
+}
+
+/* Forget all dirty windows */
+static void ssd1306_ClearDirty(void) {
+    memset(SSD1306_DirtyMin, 0xFF, sizeof(SSD1306_DirtyMin));
+    memset(SSD1306_DirtyMax, 0x00, sizeof(SSD1306_DirtyMax));
+}
+
 /* Fills the Screenbuffer with values from a given buffer of a fixed length */
 SSD1306_Error_t ssd1306_FillBuffer(uint8_t* buf, uint32_t len) {
     SSD1306_Error_t ret = SSD1306_ERR;
     if (len <= SSD1306_BUFFER_SIZE) {
         memcpy(SSD1306_Buffer,buf,len);
+        if (len > 0) {
+            ssd1306_MarkDirty(0, SSD1306_WIDTH - 1, 0, (len - 1) / SSD1306_WIDTH);
+        }
         ret = SSD1306_OK;
     }
     return ret;
 }
 
+/* Read-only view of the Screenbuffer, SSD1306_BUFFER_SIZE bytes page after page */
+const uint8_t* ssd1306_GetBuffer(void) {
+    return SSD1306_Buffer;
+}
+
 /* Initialize the oled screen */
 void ssd1306_Init(void) {
     // Reset OLED
@@ -161,6 +248,9 @@ void ssd1306_Init(void) {
     // Clear screen
     ssd1306_Fill(Black);
     
+    // Display RAM content is unknown after reset: flush the whole buffer
+    SSD1306_ShadowValid = 0;
+
     // Flush buffer to screen
     ssd1306_UpdateScreen();
     
@@ -174,24 +264,234 @@ void ssd1306_Init(void) {
 /* Fill the whole screen with the given color */
 void ssd1306_Fill(SSD1306_COLOR color) {
     memset(SSD1306_Buffer, (color == Black) ? 0x00 : 0xFF, sizeof(SSD1306_Buffer));
+    ssd1306_MarkDirty(0, SSD1306_WIDTH - 1, 0, SSD1306_PAGES - 1);
 }
 
-/* Write the screenbuffer with changed to the screen */
-void ssd1306_UpdateScreen(void) {
+/* Bus bytes needed to send a window of len data bytes */
+static uint32_t ssd1306_WindowCost(uint32_t len) {
+    return SSD1306_WINDOW_CMD_SIZE + len + 2 * SSD1306_TRANSFER_OVERHEAD;
+}
+
+/*
+ * Collect the windows that must be sent to the display.
+ * For each page only the column range touched since the last flush is kept,
+ * trimmed further to the bytes that really differ from the display RAM.
+ * When that costs more bus bytes than one horizontal-addressing burst over all
+ * the changed pages, a single full-width window is used instead.
+ * The changed bytes are copied to the shadow buffer, which is the source of
+ * the transfer, so the screenbuffer can be redrawn while it is in progress.
+ * full => send the whole screenbuffer as one burst
+ */
+static uint8_t ssd1306_PlanFlush(uint8_t full) {
+    uint8_t count = 0;
+    uint32_t cost = 0;
+
+    if (!SSD1306_ShadowValid) {
+        full = 1;
+    }
+
     // Write data to each page of RAM. Number of pages
     // depends on the screen height:
     //
     //  * 32px   ==  4 pages
     //  * 64px   ==  8 pages
     //  * 128px  ==  16 pages
-    for(uint8_t i = 0; i < SSD1306_HEIGHT/8; i++) {
-        ssd1306_WriteCommand(0xB0 + i); // Set the current RAM page address.
-        ssd1306_WriteCommand(0x00 + SSD1306_X_OFFSET_LOWER);
-        ssd1306_WriteCommand(0x10 + SSD1306_X_OFFSET_UPPER);
-        ssd1306_WriteData(&SSD1306_Buffer[SSD1306_WIDTH*i],SSD1306_WIDTH);
+    for(uint8_t i = 0; i < SSD1306_PAGES && !full; i++) {
+        uint8_t x1 = SSD1306_DirtyMin[i];
+        uint8_t x2 = SSD1306_DirtyMax[i];
+        if (x1 > x2) {
+            continue; // Page not touched
+        }
+
+        const uint8_t* page = &SSD1306_Buffer[SSD1306_WIDTH*i];
+        const uint8_t* shadow = &SSD1306_Shadow[SSD1306_WIDTH*i];
+        while (x1 <= x2 && page[x1] == shadow[x1]) {
+            x1++;
+        }
+        while (x2 > x1 && page[x2] == shadow[x2]) {
+            x2--;
+        }
+        if (x1 > x2) {
+            continue; // Redrawn with the same content
+        }
+
+        SSD1306_Windows[count].page1 = i;
+        SSD1306_Windows[count].page2 = i;
+        SSD1306_Windows[count].x1 = x1;
+        SSD1306_Windows[count].x2 = x2;
+        cost += ssd1306_WindowCost(x2 - x1 + 1);
+        count++;
+    }
+
+    if (full) {
+        SSD1306_Windows[0].page1 = 0;
+        SSD1306_Windows[0].page2 = SSD1306_PAGES - 1;
+        count = 1;
+    } else if (count > 1) {
+        uint8_t pages = SSD1306_Windows[count - 1].page2 - SSD1306_Windows[0].page1 + 1;
+        if (ssd1306_WindowCost((uint32_t)pages * SSD1306_WIDTH) <= cost) {
+            SSD1306_Windows[0].page2 = SSD1306_Windows[count - 1].page2;
+            count = 1;
+        }
+    }
+    if (count == 1 && SSD1306_Windows[0].page1 != SSD1306_Windows[0].page2) {
+        SSD1306_Windows[0].x1 = 0;
+        SSD1306_Windows[0].x2 = SSD1306_WIDTH - 1;
+    }
+
+    for (uint8_t w = 0; w < count; w++) {
+        uint32_t offset = ssd1306_WindowOffset(&SSD1306_Windows[w]);
+        memcpy(&SSD1306_Shadow[offset], &SSD1306_Buffer[offset], ssd1306_WindowLength(&SSD1306_Windows[w]));
+    }
+
+    SSD1306_ShadowValid = 1;
+    ssd1306_ClearDirty();
+    return count;
+}
+
+/* Fill the address window commands for a flush window */
+static void ssd1306_WindowCommands(const SSD1306_Window_t* window, uint8_t* cmd) {
+    cmd[0] = 0x21; // Set column address window
+    cmd[1] = SSD1306_X_OFFSET_COLUMN + window->x1;
+    cmd[2] = SSD1306_X_OFFSET_COLUMN + window->x2;
+    cmd[3] = 0x22; // Set page address window
+    cmd[4] = window->page1;
+    cmd[5] = window->page2;
+}
+
+/* Send the planned windows, blocking */
+static void ssd1306_FlushWindows(uint8_t count) {
+    for (uint8_t w = 0; w < count; w++) {
+        const SSD1306_Window_t* window = &SSD1306_Windows[w];
+        uint8_t cmd[SSD1306_WINDOW_CMD_SIZE];
+        ssd1306_WindowCommands(window, cmd);
+        ssd1306_WriteCommands(cmd, SSD1306_WINDOW_CMD_SIZE);
+        ssd1306_WriteData(&SSD1306_Shadow[ssd1306_WindowOffset(window)], ssd1306_WindowLength(window));
     }
 }
 
+/*
+ * Wait for an asynchronous flush to release the bus.
+ * Its transfers are chained from the I2C interrupts, so in an interrupt handler
+ * or with interrupts masked the wait would never end: give up instead. The
+ * changes stay marked and go out with the next flush.
+ */
+static uint8_t ssd1306_WaitIdle(void) {
+    while (ssd1306_IsBusy()) {
+        if (__get_IPSR() != 0 || __get_PRIMASK() != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Write the screenbuffer with changed to the screen */
+void ssd1306_UpdateScreen(void) {
+    if (!ssd1306_WaitIdle()) {
+        return;
+    }
+
+    ssd1306_FlushWindows(ssd1306_PlanFlush(0));
+}
+
+/* Write the whole screenbuffer to the screen as one data transaction */
+void ssd1306_UpdateScreenBurst(void) {
+    if (!ssd1306_WaitIdle()) {
+        return;
+    }
+
+    ssd1306_FlushWindows(ssd1306_PlanFlush(1));
+}
+
+#if defined(SSD1306_USE_I2C)
+
+/* Start the next transfer of the asynchronous flush, from thread or ISR context */
+static void ssd1306_AsyncNext(void) {
+    HAL_StatusTypeDef status;
+
+    if (SSD1306_Async.window >= SSD1306_Async.count) {
+        SSD1306_Async.busy = 0;
+        ssd1306_UpdateScreenCpltCallback();
+        return;
+    }
+
+    const SSD1306_Window_t* window = &SSD1306_Windows[SSD1306_Async.window];
+    if (!SSD1306_Async.data_phase) {
+        ssd1306_WindowCommands(window, SSD1306_Async.cmd);
+        SSD1306_Async.data_phase = 1;
+        ssd1306_CountTransfer(SSD1306_WINDOW_CMD_SIZE);
+        status = HAL_I2C_Mem_Write_DMA(&SSD1306_I2C_PORT, SSD1306_I2C_ADDR, 0x00, 1,
+                                       SSD1306_Async.cmd, SSD1306_WINDOW_CMD_SIZE);
+    } else {
+        SSD1306_Async.data_phase = 0;
+        SSD1306_Async.window++;
+        ssd1306_CountTransfer(ssd1306_WindowLength(window));
+        status = HAL_I2C_Mem_Write_DMA(&SSD1306_I2C_PORT, SSD1306_I2C_ADDR, 0x40, 1,
+                                       &SSD1306_Shadow[ssd1306_WindowOffset(window)],
+                                       ssd1306_WindowLength(window));
+    }
+
+    if (status != HAL_OK) {
+        ssd1306_AsyncAbort();
+    }
+}
+
+/* Give up the asynchronous flush. The display RAM content is unknown afterwards. */
+static void ssd1306_AsyncAbort(void) {
+    SSD1306_ShadowValid = 0;
+    SSD1306_Async.busy = 0;
+    ssd1306_UpdateScreenCpltCallback();
+}
+
+SSD1306_Error_t ssd1306_UpdateScreenAsync(void) {
+    if (SSD1306_Async.busy) {
+        return SSD1306_ERR;
+    }
+
+    SSD1306_Async.count = ssd1306_PlanFlush(0);
+    SSD1306_Async.window = 0;
+    SSD1306_Async.data_phase = 0;
+    SSD1306_Async.busy = 1;
+    ssd1306_AsyncNext();
+    return SSD1306_OK;
+}
+
+void ssd1306_I2C_TxCpltCallback(I2C_HandleTypeDef* hi2c) {
+    if (hi2c == &SSD1306_I2C_PORT && SSD1306_Async.busy) {
+        ssd1306_AsyncNext();
+    }
+}
+
+void ssd1306_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c) {
+    if (hi2c == &SSD1306_I2C_PORT && SSD1306_Async.busy) {
+        ssd1306_AsyncAbort();
+    }
+}
+
+uint8_t ssd1306_IsBusy(void) {
+    return SSD1306_Async.busy;
+}
+
+#elif defined(SSD1306_USE_SPI)
+
+/* SPI has no DMA path yet: flush synchronously and report completion right away */
+SSD1306_Error_t ssd1306_UpdateScreenAsync(void) {
+    ssd1306_UpdateScreen();
+    ssd1306_UpdateScreenCpltCallback();
+    return SSD1306_OK;
+}
+
+uint8_t ssd1306_IsBusy(void) {
+    return 0;
+}
+
+#endif
+
+__weak void ssd1306_UpdateScreenCpltCallback(void) {
+    /* NOTE: This function should not be modified, when the callback is needed,
+             ssd1306_UpdateScreenCpltCallback could be implemented in the user file */
+}
+
 /*
  * Draw one pixel in the screenbuffer
  * X => X Coordinate
@@ -204,6 +504,8 @@ void ssd1306_DrawPixel(uint8_t x, uint8_t y, SSD1306_COLOR color) {
         return;
     }
    
+    ssd1306_MarkDirty(x, x, y / 8, y / 8);
+
     // Draw in the right color
     if(color == White) {
         SSD1306_Buffer[x + (y / 8) * SSD1306_WIDTH] |= 1 << (y % 8);
@@ -212,14 +514,65 @@ void ssd1306_DrawPixel(uint8_t x, uint8_t y, SSD1306_COLOR color) {
     }
 }
 
+/* Apply a bit mask to columns x1..x2 of one page */
+static void ssd1306_FillPageSpan(uint8_t x1, uint8_t x2, uint8_t page, uint8_t mask, SSD1306_COLOR color) {
+    uint8_t* p = &SSD1306_Buffer[x1 + page * SSD1306_WIDTH];
+    uint8_t* end = p + (x2 - x1) + 1;
+
+    if (mask == 0xFF) {
+        memset(p, (color == White) ? 0xFF : 0x00, end - p);
+    } else if (color == White) {
+        for (; p < end; p++) {
+            *p |= mask;
+        }
+    } else {
+        for (; p < end; p++) {
+            *p &= ~mask;
+        }
+    }
+}
+
+/*
+ * Draw a horizontal line from (x1, y) to (x2, y), clipped to the screen.
+ * Sets the same bit in each column byte of one page.
+ */
+void ssd1306_DrawHorizontalLine(uint8_t x1, uint8_t x2, uint8_t y, SSD1306_COLOR color) {
+    if (x1 > x2) {
+        uint8_t t = x1; x1 = x2; x2 = t;
+    }
+    if (x1 >= SSD1306_WIDTH || y >= SSD1306_HEIGHT) {
+        return;
+    }
+    if (x2 >= SSD1306_WIDTH) {
+        x2 = SSD1306_WIDTH - 1;
+    }
+
+    ssd1306_FillPageSpan(x1, x2, y / 8, 1 << (y % 8), color);
+    ssd1306_MarkDirty(x1, x2, y / 8, y / 8);
+}
+
+/*
+ * Draw a vertical line from (x, y1) to (x, y2), clipped to the screen.
+ * Writes one masked byte per page the line crosses.
+ */
+void ssd1306_DrawVerticalLine(uint8_t x, uint8_t y1, uint8_t y2, SSD1306_COLOR color) {
+    ssd1306_FillRectangle(x, y1, x, y2, color);
+}
+
 /*
  * Draw 1 char to the screen buffer
  * ch       => char om weg te schrijven
  * Font     => Font waarmee we gaan schrijven
  * color    => Black or White
+ *
+ * Page-native glyphs (Font.paged) are copied page by page when the cursor is
+ * on a page boundary. Otherwise the glyph is turned into one bit column per
+ * pixel column, which is written with shifted byte masks into the pages the
+ * character spans.
  */
 char ssd1306_WriteChar(char ch, SSD1306_Font_t Font, SSD1306_COLOR color) {
-    uint32_t i, b, j;
+    uint32_t columns[16] = {0};
+    uint32_t i;
     
     // Check if character is valid
     if (ch < 32 || ch > 126)
@@ -234,18 +587,76 @@ char ssd1306_WriteChar(char ch, SSD1306_Font_t Font, SSD1306_COLOR color) {
         // Not enough space on current line
         return 0;
     }
+    if (char_width == 0) {
+        return ch;
+    }
     
-    // Use the font to write
-    for(i = 0; i < Font.height; i++) {
-        b = Font.data[(ch - 32) * Font.height + i];
-        for(j = 0; j < char_width; j++) {
-            if((b << j) & 0x8000)  {
-                ssd1306_DrawPixel(SSD1306.CurrentX + j, (SSD1306.CurrentY + i), (SSD1306_COLOR) color);
-            } else {
-                ssd1306_DrawPixel(SSD1306.CurrentX + j, (SSD1306.CurrentY + i), (SSD1306_COLOR)!color);
+    const uint8_t x = SSD1306.CurrentX;
+    const uint8_t y = SSD1306.CurrentY;
+    const uint8_t page1 = y / 8;
+    const uint8_t page2 = (y + Font.height - 1) / 8;
+    
+    if (Font.paged) {
+        // Page-native glyph: one run of Font.width column bytes per 8px page
+        const uint8_t pages = (Font.height + 7) / 8;
+        const uint8_t* glyph = &Font.paged[(ch - 32) * Font.width * pages];
+        
+        if (y % 8 == 0) {
+            // Glyph pages line up with screen pages: copy them
+            for (uint8_t k = 0; k < pages; k++) {
+                const uint8_t* src = &glyph[k * Font.width];
+                uint8_t* dst = &SSD1306_Buffer[x + (page1 + k) * SSD1306_WIDTH];
+                const uint8_t rows = Font.height - k * 8;
+                const uint8_t mask = (rows >= 8) ? 0xFF : (uint8_t)((1 << rows) - 1);
+                if (mask == 0xFF && color == White) {
+                    memcpy(dst, src, char_width);
+                } else {
+                    const uint8_t invert = (color == White) ? 0x00 : 0xFF;
+                    for (uint32_t j = 0; j < char_width; j++) {
+                        dst[j] = (dst[j] & ~mask) | ((src[j] ^ invert) & mask);
+                    }
+                }
+            }
+            ssd1306_MarkDirty(x, x + char_width - 1, page1, page2);
+            SSD1306.CurrentX += char_width;
+            return ch;
+        }
+        
+        for (uint32_t j = 0; j < char_width; j++) {
+            for (uint8_t k = 0; k < pages; k++) {
+                columns[j] |= (uint32_t)glyph[k * Font.width + j] << (8 * k);
             }
         }
+    } else {
+        // Transpose the row-major glyph: bit i of columns[j] is pixel (j, i)
+        const uint16_t* glyph = &Font.data[(ch - 32) * Font.height];
+        const uint16_t width_mask = (uint16_t)(0xFFFF << (16 - char_width));
+        for(i = 0; i < Font.height; i++) {
+            uint16_t b = glyph[i] & width_mask;
+            while (b) {
+                uint32_t j = __builtin_clz(b) - 16;
+                columns[j] |= 1UL << i;
+                b &= ~(0x8000 >> j);
+            }
+        }
+    }
+    
+    // Write the columns page by page; the background of the cell is drawn too
+    const uint32_t cell = (Font.height < 32) ? ((1UL << Font.height) - 1) : 0xFFFFFFFF;
+    for (uint8_t page = page1; page <= page2; page++) {
+        // Glyph row drawn at bit 0 of this page, negative on the first page
+        const int32_t row = (int32_t)page * 8 - y;
+        const uint32_t lshift = (row < 0) ? -row : 0;
+        const uint32_t rshift = (row > 0) ? row : 0;
+        const uint8_t mask = (uint8_t)((cell << lshift) >> rshift);
+        const uint32_t invert = (color == White) ? 0 : 0xFFFFFFFF;
+        uint8_t* dst = &SSD1306_Buffer[x + page * SSD1306_WIDTH];
+        for (uint32_t j = 0; j < char_width; j++) {
+            uint8_t value = (uint8_t)(((columns[j] ^ invert) << lshift) >> rshift) & mask;
+            dst[j] = (dst[j] & ~mask) | value;
+        }
     }
+    ssd1306_MarkDirty(x, x + char_width - 1, page1, page2);
     
     // The current space is now taken
     SSD1306.CurrentX += char_width;
@@ -315,9 +726,49 @@ void ssd1306_Polyline(const SSD1306_VERTEX *par_vertex, uint16_t par_size, SSD13
     return;
 }
 
-/* Convert Degrees to Radians */
-static float ssd1306_DegToRad(float par_deg) {
-    return par_deg * (3.14f / 180.0f);
+/*
+ * Quarter-wave sine table, sin(0..90 deg) in Q14 (16384 = 1.0).
+ * The entries are constant expressions (Taylor series up to x^13), so the
+ * compiler evaluates them and no float code or libm ends up in the image.
+ */
+#define SSD1306_TAYLOR_SIN(r) ((r) * (1.0 - (r)*(r)/6.0 * (1.0 - (r)*(r)/20.0 * (1.0 - (r)*(r)/42.0 * \
+                              (1.0 - (r)*(r)/72.0 * (1.0 - (r)*(r)/110.0 * (1.0 - (r)*(r)/156.0)))))))
+#define SSD1306_SIN_Q14(d)    ((int16_t)(SSD1306_TAYLOR_SIN((d) * (3.14159265358979 / 180.0)) * 16384.0 + 0.5))
+#define SSD1306_SIN_ROW(d)    SSD1306_SIN_Q14(d),     SSD1306_SIN_Q14(d + 1), SSD1306_SIN_Q14(d + 2), \
+                              SSD1306_SIN_Q14(d + 3), SSD1306_SIN_Q14(d + 4), SSD1306_SIN_Q14(d + 5), \
+                              SSD1306_SIN_Q14(d + 6), SSD1306_SIN_Q14(d + 7), SSD1306_SIN_Q14(d + 8), \
+                              SSD1306_SIN_Q14(d + 9)
+
+static const int16_t SSD1306_SinTable[91] = {
+    SSD1306_SIN_ROW(0),  SSD1306_SIN_ROW(10), SSD1306_SIN_ROW(20),
+    SSD1306_SIN_ROW(30), SSD1306_SIN_ROW(40), SSD1306_SIN_ROW(50),
+    SSD1306_SIN_ROW(60), SSD1306_SIN_ROW(70), SSD1306_SIN_ROW(80),
+    SSD1306_SIN_Q14(90)
+};
+
+/* sin of an angle in whole degrees, Q14 */
+static int32_t ssd1306_SinQ14(uint32_t deg) {
+    deg %= 360;
+    if (deg < 90) {
+        return SSD1306_SinTable[deg];
+    } else if (deg < 180) {
+        return SSD1306_SinTable[180 - deg];
+    } else if (deg < 270) {
+        return -SSD1306_SinTable[deg - 180];
+    }
+    return -SSD1306_SinTable[360 - deg];
+}
+
+/* Scale a Q14 value by radius, rounding to the nearest pixel */
+static int32_t ssd1306_ScaleQ14(int32_t q14, uint8_t radius) {
+    int32_t v = q14 * radius;
+    return (v >= 0) ? (v + 8192) >> 14 : -((-v + 8192) >> 14);
+}
+
+/* Point on the circle around (x, y) at deg, measured like ssd1306_DrawArc() */
+static void ssd1306_ArcPoint(uint8_t x, uint8_t y, uint8_t radius, uint32_t deg, uint8_t* xp, uint8_t* yp) {
+    *xp = x + ssd1306_ScaleQ14(ssd1306_SinQ14(deg), radius);
+    *yp = y + ssd1306_ScaleQ14(ssd1306_SinQ14(deg + 90), radius);
 }
 
 /* Normalize degree to [0;360] */
@@ -333,41 +784,56 @@ static uint16_t ssd1306_NormalizeTo0_360(uint16_t par_deg) {
 }
 
 /*
- * DrawArc. Draw angle is beginning from 4 quart of trigonometric circle (3pi/2)
- * start_angle in degree
- * sweep in degree
+ * Approximate the arc by chords of about 10 degrees. The ends of the first
+ * and last chord are returned through first/last (may be NULL).
+ * Returns 0 when there is nothing to draw.
  */
-void ssd1306_DrawArc(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep, SSD1306_COLOR color) {
+static uint8_t ssd1306_ArcChords(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep,
+                                 SSD1306_COLOR color, SSD1306_VERTEX* first, SSD1306_VERTEX* last) {
     static const uint8_t CIRCLE_APPROXIMATION_SEGMENTS = 36;
-    float approx_degree;
     uint32_t approx_segments;
     uint8_t xp1,xp2;
     uint8_t yp1,yp2;
     uint32_t count;
     uint32_t loc_sweep;
-    float rad;
     
     loc_sweep = ssd1306_NormalizeTo0_360(sweep);
     
     count = (ssd1306_NormalizeTo0_360(start_angle) * CIRCLE_APPROXIMATION_SEGMENTS) / 360;
     approx_segments = (loc_sweep * CIRCLE_APPROXIMATION_SEGMENTS) / 360;
-    approx_degree = loc_sweep / (float)approx_segments;
+    if (count >= approx_segments) {
+        return 0;
+    }
+
+    // Segment angles count * loc_sweep / approx_segments, rounded to whole degrees
+    ssd1306_ArcPoint(x, y, radius, (count * loc_sweep + approx_segments / 2) / approx_segments, &xp1, &yp1);
+    if (first) {
+        first->x = xp1;
+        first->y = yp1;
+    }
     while(count < approx_segments)
     {
-        rad = ssd1306_DegToRad(count*approx_degree);
-        xp1 = x + (int8_t)(sinf(rad)*radius);
-        yp1 = y + (int8_t)(cosf(rad)*radius);    
         count++;
-        if(count != approx_segments) {
-            rad = ssd1306_DegToRad(count*approx_degree);
-        } else {
-            rad = ssd1306_DegToRad(loc_sweep);
-        }
-        xp2 = x + (int8_t)(sinf(rad)*radius);
-        yp2 = y + (int8_t)(cosf(rad)*radius);    
+        ssd1306_ArcPoint(x, y, radius, (count * loc_sweep + approx_segments / 2) / approx_segments, &xp2, &yp2);
         ssd1306_Line(xp1,yp1,xp2,yp2,color);
+        xp1 = xp2;
+        yp1 = yp2;
+    }
+    if (last) {
+        last->x = xp2;
+        last->y = yp2;
     }
     
+    return 1;
+}
+
+/*
+ * DrawArc. Draw angle is beginning from 4 quart of trigonometric circle (3pi/2)
+ * start_angle in degree
+ * sweep in degree
+ */
+void ssd1306_DrawArc(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep, SSD1306_COLOR color) {
+    ssd1306_ArcChords(x, y, radius, start_angle, sweep, color, NULL, NULL);
     return;
 }
 
@@ -378,47 +844,58 @@ void ssd1306_DrawArc(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle,
  * sweep: finish angle in degree
  */
 void ssd1306_DrawArcWithRadiusLine(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep, SSD1306_COLOR color) {
-    const uint32_t CIRCLE_APPROXIMATION_SEGMENTS = 36;
-    float approx_degree;
-    uint32_t approx_segments;
-    uint8_t xp1;
-    uint8_t xp2 = 0;
-    uint8_t yp1;
-    uint8_t yp2 = 0;
-    uint32_t count;
-    uint32_t loc_sweep;
-    float rad;
-    
-    loc_sweep = ssd1306_NormalizeTo0_360(sweep);
-    
-    count = (ssd1306_NormalizeTo0_360(start_angle) * CIRCLE_APPROXIMATION_SEGMENTS) / 360;
-    approx_segments = (loc_sweep * CIRCLE_APPROXIMATION_SEGMENTS) / 360;
-    approx_degree = loc_sweep / (float)approx_segments;
-
-    rad = ssd1306_DegToRad(count*approx_degree);
-    uint8_t first_point_x = x + (int8_t)(sinf(rad)*radius);
-    uint8_t first_point_y = y + (int8_t)(cosf(rad)*radius);   
-    while (count < approx_segments) {
-        rad = ssd1306_DegToRad(count*approx_degree);
-        xp1 = x + (int8_t)(sinf(rad)*radius);
-        yp1 = y + (int8_t)(cosf(rad)*radius);    
-        count++;
-        if (count != approx_segments) {
-            rad = ssd1306_DegToRad(count*approx_degree);
-        } else {
-            rad = ssd1306_DegToRad(loc_sweep);
-        }
-        xp2 = x + (int8_t)(sinf(rad)*radius);
-        yp2 = y + (int8_t)(cosf(rad)*radius);    
-        ssd1306_Line(xp1,yp1,xp2,yp2,color);
+    SSD1306_VERTEX first, last;
+
+    if (!ssd1306_ArcChords(x, y, radius, start_angle, sweep, color, &first, &last)) {
+        return;
     }
     
     // Radius line
-    ssd1306_Line(x,y,first_point_x,first_point_y,color);
-    ssd1306_Line(x,y,xp2,yp2,color);
+    ssd1306_Line(x,y,first.x,first.y,color);
+    ssd1306_Line(x,y,last.x,last.y,color);
     return;
 }
 
+/*
+ * Draw a dial gauge: a 270 degree scale open at the bottom, with ticks at
+ * both ends and in the middle, and a needle pointing at value.
+ * value is clamped to [min;max]; min is at the lower left end of the scale.
+ */
+void ssd1306_DrawDial(uint8_t x, uint8_t y, uint8_t radius, int32_t value, int32_t min, int32_t max, SSD1306_COLOR color) {
+    static const uint16_t DIAL_MIN_ANGLE = 315;
+    static const uint16_t DIAL_SWEEP = 270;
+    uint8_t xp1, yp1, xp2, yp2;
+
+    if (radius < 4 || max <= min) {
+        return;
+    }
+    if (value < min) {
+        value = min;
+    } else if (value > max) {
+        value = max;
+    }
+
+    // Scale in 15 degree chords at exact angles
+    ssd1306_ArcPoint(x, y, radius, DIAL_MIN_ANGLE - DIAL_SWEEP, &xp1, &yp1);
+    for (uint32_t deg = DIAL_MIN_ANGLE - DIAL_SWEEP + 15; deg <= DIAL_MIN_ANGLE; deg += 15) {
+        ssd1306_ArcPoint(x, y, radius, deg, &xp2, &yp2);
+        ssd1306_Line(xp1, yp1, xp2, yp2, color);
+        xp1 = xp2;
+        yp1 = yp2;
+    }
+    for (uint32_t tick = 0; tick <= DIAL_SWEEP; tick += DIAL_SWEEP / 2) {
+        ssd1306_ArcPoint(x, y, radius, DIAL_MIN_ANGLE - tick, &xp1, &yp1);
+        ssd1306_ArcPoint(x, y, radius - 3, DIAL_MIN_ANGLE - tick, &xp2, &yp2);
+        ssd1306_Line(xp1, yp1, xp2, yp2, color);
+    }
+
+    // Needle, angle rounded to the nearest degree
+    const uint32_t angle = DIAL_MIN_ANGLE - ((value - min) * DIAL_SWEEP + (max - min) / 2) / (max - min);
+    ssd1306_ArcPoint(x, y, radius - 4, angle, &xp1, &yp1);
+    ssd1306_Line(x, y, xp1, yp1, color);
+    ssd1306_FillCircle(x, y, 1, color);
+}
+
 /* Draw circle by Bresenhem's algorithm */
 void ssd1306_DrawCircle(uint8_t par_x,uint8_t par_y,uint8_t par_r,SSD1306_COLOR par_color) {
     int32_t x = -par_r;
@@ -454,22 +931,38 @@ void ssd1306_DrawCircle(uint8_t par_x,uint8_t par_y,uint8_t par_r,SSD1306_COLOR
     return;
 }
 
-/* Draw filled circle. Pixel positions calculated using Bresenham's algorithm */
+/*
+ * Draw filled circle. Pixel positions calculated using Bresenham's algorithm;
+ * each row is drawn once as a horizontal span, the first time the outline reaches it.
+ */
 void ssd1306_FillCircle(uint8_t par_x,uint8_t par_y,uint8_t par_r,SSD1306_COLOR par_color) {
     int32_t x = -par_r;
     int32_t y = 0;
     int32_t err = 2 - 2 * par_r;
     int32_t e2;
+    int32_t last_y = -1;
 
     if (par_x >= SSD1306_WIDTH || par_y >= SSD1306_HEIGHT) {
         return;
     }
 
     do {
-        for (uint8_t _y = (par_y + y); _y >= (par_y - y); _y--) {
-            for (uint8_t _x = (par_x - x); _x >= (par_x + x); _x--) {
-                ssd1306_DrawPixel(_x, _y, par_color);
+        if (y != last_y) {
+            int32_t x1 = par_x + x;
+            int32_t x2 = par_x - x;
+            if (x1 < 0) {
+                x1 = 0;
+            }
+            if (x2 > SSD1306_WIDTH - 1) {
+                x2 = SSD1306_WIDTH - 1;
+            }
+            if (par_y + y < SSD1306_HEIGHT) {
+                ssd1306_DrawHorizontalLine(x1, x2, par_y + y, par_color);
+            }
+            if (y != 0 && par_y - y >= 0) {
+                ssd1306_DrawHorizontalLine(x1, x2, par_y - y, par_color);
             }
+            last_y = y;
         }
 
         e2 = err;
@@ -492,29 +985,71 @@ void ssd1306_FillCircle(uint8_t par_x,uint8_t par_y,uint8_t par_r,SSD1306_COLOR
 
 /* Draw a rectangle */
 void ssd1306_DrawRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color) {
-    ssd1306_Line(x1,y1,x2,y1,color);
-    ssd1306_Line(x2,y1,x2,y2,color);
-    ssd1306_Line(x2,y2,x1,y2,color);
-    ssd1306_Line(x1,y2,x1,y1,color);
+    ssd1306_DrawHorizontalLine(x1, x2, y1, color);
+    ssd1306_DrawHorizontalLine(x1, x2, y2, color);
+    ssd1306_DrawVerticalLine(x1, y1, y2, color);
+    ssd1306_DrawVerticalLine(x2, y1, y2, color);
 
     return;
 }
 
-/* Draw a filled rectangle */
+/* Draw a filled rectangle, one masked span per 8px page */
 void ssd1306_FillRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color) {
     uint8_t x_start = ((x1<=x2) ? x1 : x2);
     uint8_t x_end   = ((x1<=x2) ? x2 : x1);
     uint8_t y_start = ((y1<=y2) ? y1 : y2);
     uint8_t y_end   = ((y1<=y2) ? y2 : y1);
 
-    for (uint8_t y= y_start; (y<= y_end)&&(y<SSD1306_HEIGHT); y++) {
-        for (uint8_t x= x_start; (x<= x_end)&&(x<SSD1306_WIDTH); x++) {
-            ssd1306_DrawPixel(x, y, color);
+    if (x_start >= SSD1306_WIDTH || y_start >= SSD1306_HEIGHT) {
+        return;
+    }
+    if (x_end >= SSD1306_WIDTH) {
+        x_end = SSD1306_WIDTH - 1;
+    }
+    if (y_end >= SSD1306_HEIGHT) {
+        y_end = SSD1306_HEIGHT - 1;
+    }
+
+    const uint8_t page1 = y_start / 8;
+    const uint8_t page2 = y_end / 8;
+    for (uint8_t page = page1; page <= page2; page++) {
+        uint8_t mask = 0xFF;
+        if (page == page1) {
+            mask &= 0xFF << (y_start % 8);
+        }
+        if (page == page2) {
+            mask &= 0xFF >> (7 - (y_end % 8));
         }
+        ssd1306_FillPageSpan(x_start, x_end, page, mask, color);
     }
+    ssd1306_MarkDirty(x_start, x_end, page1, page2);
     return;
 }
 
+/*
+ * Draw a horizontal bar gauge: a one pixel frame filled to percent (0..100)
+ * of its inner width. The rest of the inside is cleared.
+ */
+void ssd1306_DrawProgressBar(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t percent, SSD1306_COLOR color) {
+    if (w < 3 || h < 3) {
+        return;
+    }
+    if (percent > 100) {
+        percent = 100;
+    }
+
+    const uint8_t inner = w - 2;
+    const uint8_t fill = (uint8_t)((inner * percent + 50) / 100);
+
+    ssd1306_DrawRectangle(x, y, x + w - 1, y + h - 1, color);
+    if (fill > 0) {
+        ssd1306_FillRectangle(x + 1, y + 1, x + fill, y + h - 2, color);
+    }
+    if (fill < inner) {
+        ssd1306_FillRectangle(x + 1 + fill, y + 1, x + w - 2, y + h - 2, (SSD1306_COLOR)!color);
+    }
+}
+
 SSD1306_Error_t ssd1306_InvertRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2) {
   if ((x2 >= SSD1306_WIDTH) || (y2 >= SSD1306_HEIGHT)) {
     return SSD1306_ERR;
@@ -523,6 +1058,7 @@ SSD1306_Error_t ssd1306_InvertRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint
     return SSD1306_ERR;
   }
   uint32_t i;
+  ssd1306_MarkDirty(x1, x2, y1 / 8, y2 / 8);
   if ((y1 / 8) != (y2 / 8)) {
     /* if rectangle doesn't lie on one 8px row */
     for (uint32_t x = x1; x <= x2; x++) {
@@ -591,3 +1127,12 @@ void ssd1306_SetDisplayOn(const uint8_t on) {
 uint8_t ssd1306_GetDisplayOn() {
     return SSD1306.DisplayOn;
 }
+
+void ssd1306_GetStats(SSD1306_Stats_t* stats) {
+    *stats = SSD1306_Stats;
+}
+
+void ssd1306_ResetStats(void) {
+    SSD1306_Stats.transactions = 0;
+    SSD1306_Stats.bytes = 0;
+}
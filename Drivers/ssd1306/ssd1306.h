@@ -54,9 +54,11 @@ _BEGIN_STD_C
 #ifdef SSD1306_X_OFFSET
 #define SSD1306_X_OFFSET_LOWER (SSD1306_X_OFFSET & 0x0F)
 #define SSD1306_X_OFFSET_UPPER ((SSD1306_X_OFFSET >> 4) & 0x07)
+#define SSD1306_X_OFFSET_COLUMN (SSD1306_X_OFFSET)
 #else
 #define SSD1306_X_OFFSET_LOWER 0
 #define SSD1306_X_OFFSET_UPPER 0
+#define SSD1306_X_OFFSET_COLUMN 0
 #endif
 
 /* vvv I2C config vvv */
@@ -122,6 +124,9 @@ extern SPI_HandleTypeDef SSD1306_SPI_PORT;
 #define SSD1306_BUFFER_SIZE   SSD1306_WIDTH * SSD1306_HEIGHT / 8
 #endif
 
+// Number of 8px RAM pages
+#define SSD1306_PAGES           (SSD1306_HEIGHT / 8)
+
 // Enumeration for screen colors
 typedef enum {
     Black = 0x00, // Black color, no pixel
@@ -146,31 +151,84 @@ typedef struct {
     uint8_t y;
 } SSD1306_VERTEX;
 
+// Column/page window sent by a flush. Windows spanning several pages are full width.
+typedef struct {
+    uint8_t page1;
+    uint8_t page2;
+    uint8_t x1;
+    uint8_t x2;
+} SSD1306_Window_t;
+
+// Bytes of the column/page address commands sent before each window
+#define SSD1306_WINDOW_CMD_SIZE 6
+
+// Bus bytes added to every transaction besides the payload
+#if defined(SSD1306_USE_I2C)
+#define SSD1306_TRANSFER_OVERHEAD 2 // Slave address + control byte
+#else
+#define SSD1306_TRANSFER_OVERHEAD 0
+#endif
+
+// Bus traffic since the last ssd1306_ResetStats()
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;         /**< Payload plus SSD1306_TRANSFER_OVERHEAD per transaction */
+} SSD1306_Stats_t;
+
 /** Font */
 typedef struct {
 	const uint8_t width;                /**< Font width in pixels */
 	const uint8_t height;               /**< Font height in pixels */
-	const uint16_t *const data;         /**< Pointer to font data array */
+	const uint16_t *const data;         /**< Pointer to font data array (row-major, NULL if only paged) */
     const uint8_t *const char_width;    /**< Proportional character width in pixels (NULL for monospaced) */
+    const uint8_t *const paged;         /**< Page-native glyphs: per glyph, `width` vertical bytes per 8px page (NULL if not generated) */
 } SSD1306_Font_t;
 
 // Procedure definitions
 void ssd1306_Init(void);
 void ssd1306_Fill(SSD1306_COLOR color);
 void ssd1306_UpdateScreen(void);
+void ssd1306_UpdateScreenBurst(void);
 void ssd1306_DrawPixel(uint8_t x, uint8_t y, SSD1306_COLOR color);
 char ssd1306_WriteChar(char ch, SSD1306_Font_t Font, SSD1306_COLOR color);
 char ssd1306_WriteString(char* str, SSD1306_Font_t Font, SSD1306_COLOR color);
 void ssd1306_SetCursor(uint8_t x, uint8_t y);
 void ssd1306_Line(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color);
+void ssd1306_DrawHorizontalLine(uint8_t x1, uint8_t x2, uint8_t y, SSD1306_COLOR color);
+void ssd1306_DrawVerticalLine(uint8_t x, uint8_t y1, uint8_t y2, SSD1306_COLOR color);
 void ssd1306_DrawArc(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep, SSD1306_COLOR color);
 void ssd1306_DrawArcWithRadiusLine(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep, SSD1306_COLOR color);
+
+/**
+ * @brief Draw a 270 degree dial gauge with a needle (e.g. fan PWM, temperature)
+ *
+ * @param x X Coordinate of the center
+ * @param y Y Coordinate of the center
+ * @param radius Radius of the scale, at least 4
+ * @param value Value shown by the needle, clamped to [min;max]
+ * @param min Value at the lower left end of the scale
+ * @param max Value at the lower right end of the scale
+ * @param color Color of scale and needle
+ */
+void ssd1306_DrawDial(uint8_t x, uint8_t y, uint8_t radius, int32_t value, int32_t min, int32_t max, SSD1306_COLOR color);
 void ssd1306_DrawCircle(uint8_t par_x, uint8_t par_y, uint8_t par_r, SSD1306_COLOR color);
 void ssd1306_FillCircle(uint8_t par_x,uint8_t par_y,uint8_t par_r,SSD1306_COLOR par_color);
 void ssd1306_Polyline(const SSD1306_VERTEX *par_vertex, uint16_t par_size, SSD1306_COLOR color);
 void ssd1306_DrawRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color);
 void ssd1306_FillRectangle(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, SSD1306_COLOR color);
 
+/**
+ * @brief Draw a framed horizontal bar filled to a percentage (e.g. fan PWM)
+ *
+ * @param x X Coordinate of top left corner
+ * @param y Y Coordinate of top left corner
+ * @param w Width including the frame, at least 3
+ * @param h Height including the frame, at least 3
+ * @param percent Filled part of the inner width, 0..100
+ * @param color Color of frame and bar
+ */
+void ssd1306_DrawProgressBar(uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t percent, SSD1306_COLOR color);
+
 /**
  * @brief Invert color of pixels in rectangle (include border)
  * 
@@ -205,11 +263,62 @@ void ssd1306_SetDisplayOn(const uint8_t on);
  */
 uint8_t ssd1306_GetDisplayOn();
 
+/**
+ * @brief Reads the bus traffic counters.
+ * @param[out] stats transactions and bytes sent since the last reset.
+ */
+void ssd1306_GetStats(SSD1306_Stats_t* stats);
+
+/**
+ * @brief Clears the bus traffic counters.
+ */
+void ssd1306_ResetStats(void);
+
+/**
+ * @brief Starts a non-blocking flush of the changed screenbuffer windows.
+ * @note  With I2C the windows are streamed by DMA and chained from the transfer
+ *        complete interrupt, which must be forwarded with ssd1306_I2C_TxCpltCallback().
+ *        The screenbuffer may be redrawn while the transfer is in progress.
+ *        ssd1306_UpdateScreen() and ssd1306_UpdateScreenBurst() wait for it to end,
+ *        except in an interrupt handler or with interrupts masked, where the wait
+ *        could never end: there they return at once and the changes go out with
+ *        the next flush.
+ * @return SSD1306_OK if the flush was started, SSD1306_ERR if one is still in progress.
+ */
+SSD1306_Error_t ssd1306_UpdateScreenAsync(void);
+
+/**
+ * @brief Reads the state of the asynchronous flush.
+ * @return  0: idle.
+ *          1: transfer in progress.
+ */
+uint8_t ssd1306_IsBusy(void);
+
+/**
+ * @brief Called when an asynchronous flush completed or was aborted on a bus error.
+ * @note  Usually runs in interrupt context. Weak, override it in the user file.
+ */
+void ssd1306_UpdateScreenCpltCallback(void);
+
+#if defined(SSD1306_USE_I2C)
+/**
+ * @brief Forward HAL_I2C_MemTxCpltCallback() here to chain the asynchronous flush.
+ */
+void ssd1306_I2C_TxCpltCallback(I2C_HandleTypeDef* hi2c);
+
+/**
+ * @brief Forward HAL_I2C_ErrorCallback() here to abort the asynchronous flush.
+ */
+void ssd1306_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c);
+#endif
+
 // Low-level procedures
 void ssd1306_Reset(void);
 void ssd1306_WriteCommand(uint8_t byte);
+void ssd1306_WriteCommands(uint8_t* buffer, size_t buff_size);
 void ssd1306_WriteData(uint8_t* buffer, size_t buff_size);
 SSD1306_Error_t ssd1306_FillBuffer(uint8_t* buf, uint32_t len);
+const uint8_t* ssd1306_GetBuffer(void);
 
 _END_STD_C
 
@@ -1,7 +1,20 @@
 
 #include "ssd1306_fonts.h"
 
-#ifdef SSD1306_INCLUDE_FONT_7x10
+/*
+ * With SSD1306_USE_PAGED_FONTS the glyphs come from the page-native tables
+ * generated at build time by tools/ssd1306_fontgen.py and the row-major
+ * tables below are left out of the image.
+ */
+#ifdef SSD1306_USE_PAGED_FONTS
+#define SSD1306_FONT_ROWS(name)     NULL
+#define SSD1306_FONT_PAGED(name)    name##_paged
+#else
+#define SSD1306_FONT_ROWS(name)     name
+#define SSD1306_FONT_PAGED(name)    NULL
+#endif
+
+#if defined(SSD1306_INCLUDE_FONT_7x10) && !defined(SSD1306_USE_PAGED_FONTS)
 static const uint16_t Font7x10 [] = {
 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,  // sp
 0x1000, 0x1000, 0x1000, 0x1000, 0x1000, 0x1000, 0x0000, 0x1000, 0x0000, 0x0000,  // !
@@ -101,7 +114,7 @@ static const uint16_t Font7x10 [] = {
 };
 #endif
 
-#ifdef SSD1306_INCLUDE_FONT_11x18
+#if defined(SSD1306_INCLUDE_FONT_11x18) && !defined(SSD1306_USE_PAGED_FONTS)
 static const uint16_t Font11x18 [] = {
 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,   // sp
 0x0000, 0x0C00, 0x0C00, 0x0C00, 0x0C00, 0x0C00, 0x0C00, 0x0C00, 0x0C00, 0x0C00, 0x0C00, 0x0C00, 0x0000, 0x0C00, 0x0C00, 0x0000, 0x0000, 0x0000,   // !
@@ -200,7 +213,7 @@ static const uint16_t Font11x18 [] = {
 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x3880, 0x7F80, 0x4700, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,   // ~
 };
 #endif
-#ifdef SSD1306_INCLUDE_FONT_16x26
+#if defined(SSD1306_INCLUDE_FONT_16x26) && !defined(SSD1306_USE_PAGED_FONTS)
 static const uint16_t Font16x26 [] = {
 0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000, // Ascii = [ ]
 0x03E0,0x03E0,0x03E0,0x03E0,0x03E0,0x03E0,0x03E0,0x03E0,0x03C0,0x03C0,0x01C0,0x01C0,0x01C0,0x01C0,0x01C0,0x0000,0x0000,0x0000,0x03E0,0x03E0,0x03E0,0x0000,0x0000,0x0000,0x0000,0x0000, // Ascii = [!]
@@ -299,7 +312,7 @@ static const uint16_t Font16x26 [] = {
 0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x3F07,0x7FC7,0x73E7,0xF1FF,0xF07E,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000, // Ascii = [~]
 };
 #endif
-#ifdef SSD1306_INCLUDE_FONT_6x8
+#if defined(SSD1306_INCLUDE_FONT_6x8) && !defined(SSD1306_USE_PAGED_FONTS)
 static const uint16_t Font6x8 [] = {
 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,  // sp
 0x2000, 0x2000, 0x2000, 0x2000, 0x2000, 0x0000, 0x2000, 0x0000,  // !
@@ -400,7 +413,7 @@ static const uint16_t Font6x8 [] = {
 #endif
 
 /* see ./examples/custom-fonts/ */
-#ifdef SSD1306_INCLUDE_FONT_16x24
+#if defined(SSD1306_INCLUDE_FONT_16x24) && !defined(SSD1306_USE_PAGED_FONTS)
 static const uint16_t Font16x24 [] = {
 /* -- <- these are comments and symbol separators */
 /* -- */
@@ -601,7 +614,7 @@ static const uint16_t Font16x24 [] = {
 };
 #endif
 
-#ifdef SSD1306_INCLUDE_FONT_16x15
+#if defined(SSD1306_INCLUDE_FONT_16x15) && !defined(SSD1306_USE_PAGED_FONTS)
 static const uint16_t Font16x15 [] = {
 /**   **/
 0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,
@@ -794,7 +807,9 @@ static const uint16_t Font16x15 [] = {
 /** ~ **/
 0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,0x0C20,0x1320,0x11C0,0x0000,0x0000,0x0000,0x0000,0x0000,0x0000,
 };
+#endif
 
+#ifdef SSD1306_INCLUDE_FONT_16x15
 static const uint8_t char_width[] = {
   6,  /**   **/
   5,  /** ! **/
@@ -894,22 +909,43 @@ static const uint8_t char_width[] = {
 };
 #endif
 
+#ifdef SSD1306_USE_PAGED_FONTS
+#ifdef SSD1306_INCLUDE_FONT_6x8
+extern const uint8_t Font6x8_paged[];
+#endif
+#ifdef SSD1306_INCLUDE_FONT_7x10
+extern const uint8_t Font7x10_paged[];
+#endif
+#ifdef SSD1306_INCLUDE_FONT_11x18
+extern const uint8_t Font11x18_paged[];
+#endif
+#ifdef SSD1306_INCLUDE_FONT_16x26
+extern const uint8_t Font16x26_paged[];
+#endif
+#ifdef SSD1306_INCLUDE_FONT_16x24
+extern const uint8_t Font16x24_paged[];
+#endif
+#ifdef SSD1306_INCLUDE_FONT_16x15
+extern const uint8_t Font16x15_paged[];
+#endif
+#endif
+
 #ifdef SSD1306_INCLUDE_FONT_6x8
-const SSD1306_Font_t Font_6x8 = {6, 8, Font6x8, NULL};
+const SSD1306_Font_t Font_6x8 = {6, 8, SSD1306_FONT_ROWS(Font6x8), NULL, SSD1306_FONT_PAGED(Font6x8)};
 #endif
 #ifdef SSD1306_INCLUDE_FONT_7x10
-const SSD1306_Font_t Font_7x10 = {7, 10, Font7x10, NULL};
+const SSD1306_Font_t Font_7x10 = {7, 10, SSD1306_FONT_ROWS(Font7x10), NULL, SSD1306_FONT_PAGED(Font7x10)};
 #endif
 #ifdef SSD1306_INCLUDE_FONT_11x18
-const SSD1306_Font_t Font_11x18 = {11, 18, Font11x18, NULL};
+const SSD1306_Font_t Font_11x18 = {11, 18, SSD1306_FONT_ROWS(Font11x18), NULL, SSD1306_FONT_PAGED(Font11x18)};
 #endif
 #ifdef SSD1306_INCLUDE_FONT_16x26
-const SSD1306_Font_t Font_16x26 = {16, 26, Font16x26, NULL};
+const SSD1306_Font_t Font_16x26 = {16, 26, SSD1306_FONT_ROWS(Font16x26), NULL, SSD1306_FONT_PAGED(Font16x26)};
 #endif
 
 /* see ./examples/custom-fonts/ */
 #ifdef SSD1306_INCLUDE_FONT_16x24
-const SSD1306_Font_t Font_16x24 = {16, 24, Font16x24, NULL};
+const SSD1306_Font_t Font_16x24 = {16, 24, SSD1306_FONT_ROWS(Font16x24), NULL, SSD1306_FONT_PAGED(Font16x24)};
 #endif
 
 #ifdef SSD1306_INCLUDE_FONT_16x15
@@ -917,5 +953,5 @@ const SSD1306_Font_t Font_16x24 = {16, 24, Font16x24, NULL};
  * @copyright Google https://github.com/googlefonts/roboto
  * @license This font is licensed under the Apache License, Version 2.0.
 */
-const SSD1306_Font_t Font_16x15 = {16, 15, Font16x15, char_width};
+const SSD1306_Font_t Font_16x15 = {16, 15, SSD1306_FONT_ROWS(Font16x15), char_width, SSD1306_FONT_PAGED(Font16x15)};
 #endif
@@ -252,6 +252,82 @@ void ssd1306_TestFPS() {
     ssd1306_UpdateScreen();
 }
 
+/*
+ * Compare the bus load of the legacy per-page flush (three page/column
+ * commands and one data transaction per page) with the single-burst
+ * horizontal-addressing flush and with the dirty-window flush.
+ */
+void ssd1306_TestBusLoad() {
+    static uint8_t frame[SSD1306_BUFFER_SIZE];
+    uint8_t full_window[] = {0x21, SSD1306_X_OFFSET_COLUMN, SSD1306_X_OFFSET_COLUMN + SSD1306_WIDTH - 1,
+                             0x22, 0, SSD1306_PAGES - 1};
+    SSD1306_Stats_t paged, burst, dirty;
+    uint32_t paged_ms, burst_ms, dirty_ms;
+    uint32_t start;
+    const int frames = 20;
+    char buff[32];
+
+    for (uint32_t i = 0; i < sizeof(frame); i++) {
+        frame[i] = (uint8_t)(i * 7);
+    }
+
+    // Per-page loop, as ssd1306_UpdateScreen() used to do it
+    ssd1306_WriteCommands(full_window, sizeof(full_window));
+    ssd1306_ResetStats();
+    start = HAL_GetTick();
+    for (int f = 0; f < frames; f++) {
+        for (uint8_t i = 0; i < SSD1306_PAGES; i++) {
+            ssd1306_WriteCommand(0xB0 + i);
+            ssd1306_WriteCommand(0x00 + SSD1306_X_OFFSET_LOWER);
+            ssd1306_WriteCommand(0x10 + SSD1306_X_OFFSET_UPPER);
+            ssd1306_WriteData(&frame[SSD1306_WIDTH*i], SSD1306_WIDTH);
+        }
+    }
+    paged_ms = HAL_GetTick() - start;
+    ssd1306_GetStats(&paged);
+
+    // Whole buffer in one data transaction
+    ssd1306_FillBuffer(frame, sizeof(frame));
+    ssd1306_ResetStats();
+    start = HAL_GetTick();
+    for (int f = 0; f < frames; f++) {
+        ssd1306_UpdateScreenBurst();
+    }
+    burst_ms = HAL_GetTick() - start;
+    ssd1306_GetStats(&burst);
+
+    // One changed character per frame
+    ssd1306_ResetStats();
+    start = HAL_GetTick();
+    for (int f = 0; f < frames; f++) {
+        ssd1306_SetCursor(2, 2);
+        ssd1306_WriteChar('0' + (f % 10), Font_7x10, White);
+        ssd1306_UpdateScreen();
+    }
+    dirty_ms = HAL_GetTick() - start;
+    ssd1306_GetStats(&dirty);
+
+    ssd1306_Fill(Black);
+    ssd1306_SetCursor(0, 0);
+    ssd1306_WriteString("per frame: tx/bytes", Font_6x8, White);
+    snprintf(buff, sizeof(buff), "page  %2lu/%4lu %3lums",
+             (unsigned long)(paged.transactions / frames), (unsigned long)(paged.bytes / frames),
+             (unsigned long)(paged_ms / frames));
+    ssd1306_SetCursor(0, 16);
+    ssd1306_WriteString(buff, Font_6x8, White);
+    snprintf(buff, sizeof(buff), "burst %2lu/%4lu %3lums",
+             (unsigned long)(burst.transactions / frames), (unsigned long)(burst.bytes / frames),
+             (unsigned long)(burst_ms / frames));
+    ssd1306_SetCursor(0, 28);
+    ssd1306_WriteString(buff, Font_6x8, White);
+    snprintf(buff, sizeof(buff), "dirty %2lu/%4lu %3lums",
+             (unsigned long)(dirty.transactions / frames), (unsigned long)(dirty.bytes / frames),
+             (unsigned long)(dirty_ms / frames));
+    ssd1306_SetCursor(0, 40);
+    ssd1306_WriteString(buff, Font_6x8, White);
+    ssd1306_UpdateScreen();
+}
+
 void ssd1306_TestLine() {
 
   ssd1306_Line(1,1,SSD1306_WIDTH - 1,SSD1306_HEIGHT - 1,White);
@@ -324,6 +400,13 @@ void ssd1306_TestArc() {
   return;
 }
 
+void ssd1306_TestDial() {
+  ssd1306_DrawDial(31, 34, 28, 70, 0, 100, White);
+  ssd1306_DrawDial(95, 34, 28, 245, 150, 350, White);
+  ssd1306_UpdateScreen();
+  return;
+}
+
 void ssd1306_TestPolyline() {
   SSD1306_VERTEX loc_vertex[] =
   {
@@ -361,6 +444,8 @@ void ssd1306_TestAll() {
 
     ssd1306_TestFPS();
     HAL_Delay(3000);
+    ssd1306_TestBusLoad();
+    HAL_Delay(3000);
     ssd1306_TestBorder();
     ssd1306_TestFonts1();
     HAL_Delay(3000);
@@ -385,6 +470,9 @@ void ssd1306_TestAll() {
     ssd1306_TestArc();
     HAL_Delay(3000);
     ssd1306_Fill(Black);
+    ssd1306_TestDial();
+    HAL_Delay(3000);
+    ssd1306_Fill(Black);
     ssd1306_TestCircle();
     HAL_Delay(3000);
     ssd1306_TestDrawBitmap();
@@ -9,6 +9,7 @@ void ssd1306_TestBorder(void);
 void ssd1306_TestFonts1(void);
 void ssd1306_TestFonts2(void);
 void ssd1306_TestFPS(void);
+void ssd1306_TestBusLoad(void);
 void ssd1306_TestAll(void);
 void ssd1306_TestLine(void);
 void ssd1306_TestRectangle(void);
@@ -16,6 +17,7 @@ void ssd1306_TestRectangleFill(void);
 void ssd1306_TestRectangleInvert(void);
 void ssd1306_TestCircle(void);
 void ssd1306_TestArc(void);
+void ssd1306_TestDial(void);
 void ssd1306_TestPolyline(void);
 void ssd1306_TestDrawBitmap(void);
 
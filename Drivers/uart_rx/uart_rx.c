@@ -0,0 +1,135 @@
+#include "uart_rx.h"
+#include <string.h>
+
+/**
+ * @brief Starts the circular DMA reception with IDLE-line detection.
+ *
+ * @param rx Pointer to the receive pipeline.
+ * @param huart UART whose hdmarx channel is configured in circular mode.
+ * @return true if the reception was started.
+ */
+bool uart_rx_init(uart_rx_t *rx, UART_HandleTypeDef *huart)
+{
+    rx->huart = huart;
+    rx->dma_pos = 0;
+    rx->line_len = 0;
+    rx->line_overflow = false;
+    rx->line_broken = false;
+    rx->events = 0;
+    rx->dropped = 0;
+    rx->errors = 0;
+    rx->errors_seen = 0;
+    rx->lines = 0;
+    rx->long_lines = 0;
+    rx->broken_lines = 0;
+    ring_buffer_spsc_init(&rx->ring, rx->ring_storage, UART_RX_RING_SIZE);
+
+    return HAL_UARTEx_ReceiveToIdle_DMA(huart, rx->dma_buffer, UART_RX_DMA_SIZE) == HAL_OK;
+}
+
+/**
+ * @brief Moves the bytes the DMA wrote since the last event into the ring.
+ *        Call it from HAL_UARTEx_RxEventCallback() (interrupt context).
+ *
+ * @param rx Pointer to the receive pipeline.
+ * @param pos DMA write position reported by the HAL (1..UART_RX_DMA_SIZE).
+ */
+void uart_rx_event(uart_rx_t *rx, uint16_t pos)
+{
+    if (pos > UART_RX_DMA_SIZE || pos == rx->dma_pos) {
+        return;
+    }
+    rx->events++;
+    if (pos < rx->dma_pos) {
+        // The DMA wrapped: first the tail of the area, then its beginning
+        const uint16_t n = UART_RX_DMA_SIZE - rx->dma_pos;
+        rx->dropped += n - ring_buffer_spsc_write_bulk(&rx->ring, &rx->dma_buffer[rx->dma_pos], n);
+        rx->dma_pos = 0;
+    }
+    const uint16_t n = pos - rx->dma_pos;
+    rx->dropped += n - ring_buffer_spsc_write_bulk(&rx->ring, &rx->dma_buffer[rx->dma_pos], n);
+    rx->dma_pos = (pos == UART_RX_DMA_SIZE) ? 0 : pos;
+}
+
+/**
+ * @brief Starts the reception again after a receive error stopped the DMA.
+ *        Call it from HAL_UART_ErrorCallback() (interrupt context) once
+ *        RxState is back to READY. The DMA starts over at the beginning of
+ *        its area; the partial line is dropped by the next
+ *        uart_rx_read_line(), which is the only one that touches it.
+ *
+ * @param rx Pointer to the receive pipeline.
+ * @return true if the reception was started again.
+ */
+bool uart_rx_restart(uart_rx_t *rx)
+{
+    rx->dma_pos = 0;
+    rx->errors++;
+    return HAL_UARTEx_ReceiveToIdle_DMA(rx->huart, rx->dma_buffer, UART_RX_DMA_SIZE) == HAL_OK;
+}
+
+/**
+ * @brief Returns the next complete line received, without its "\r\n" or "\n".
+ *        Lines longer than UART_RX_LINE_MAX are discarded whole.
+ *
+ * @param rx Pointer to the receive pipeline.
+ * @param len Set to the length of the line (may be NULL).
+ * @return The NUL-terminated line, valid until the next call, or NULL if no
+ *         complete line has arrived yet.
+ */
+const char *uart_rx_read_line(uart_rx_t *rx, uint16_t *len)
+{
+    const uint8_t *span;
+    uint16_t n;
+
+    // A receive error cut the line in progress: discard it up to its end
+    const uint32_t errors = rx->errors;
+    if (errors != rx->errors_seen) {
+        rx->errors_seen = errors;
+        rx->line_len = 0;
+        rx->line_overflow = true;
+        rx->line_broken = true;
+    }
+    while ((n = ring_buffer_spsc_peek_contiguous(&rx->ring, &span)) > 0) {
+        const uint8_t *end = memchr(span, '\n', n);
+        const uint16_t take = end ? (uint16_t)(end - span) : n;
+
+        if (!rx->line_overflow) {
+            if (rx->line_len + take > UART_RX_LINE_MAX) {
+                rx->line_overflow = true;
+            } else {
+                memcpy(&rx->line[rx->line_len], span, take);
+                rx->line_len += take;
+            }
+        }
+        ring_buffer_spsc_consume(&rx->ring, end ? take + 1U : take);
+        if (end == NULL) {
+            continue;
+        }
+
+        // End of line: hand it out unless it was too long or cut by an error
+        const bool overflow = rx->line_overflow, broken = rx->line_broken;
+        uint16_t line_len = rx->line_len;
+        rx->line_len = 0;
+        rx->line_overflow = false;
+        rx->line_broken = false;
+        if (overflow) {
+            if (broken) {
+                rx->broken_lines++;
+            } else {
+                rx->long_lines++;
+            }
+            continue;
+        }
+        if (line_len > 0 && rx->line[line_len - 1] == '\r') {
+            line_len--;
+        }
+        rx->line[line_len] = '\0';
+        rx->lines++;
+        if (len) {
+            *len = line_len;
+        }
+        return rx->line;
+    }
+    return NULL;
+}
@@ -0,0 +1,50 @@
+#ifndef UART_RX_H
+#define UART_RX_H
+
+#include "main.h"
+#include "ring_buffer.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * UART receive pipeline: the UART fills dma_buffer in circular DMA mode and
+ * the HAL reports the write position on half transfer, transfer complete and
+ * IDLE line, so there is one interrupt per burst instead of one per byte.
+ * uart_rx_event() runs in that interrupt and moves the new bytes into the
+ * single-producer/single-consumer ring; the main loop takes whole lines out
+ * with uart_rx_read_line().
+ *
+ * A receive error (overrun, framing, noise) makes the HAL stop the DMA and
+ * call HAL_UART_ErrorCallback(); uart_rx_restart() starts it again from
+ * there. The line being received at that moment is discarded.
+ */
+
+#define UART_RX_DMA_SIZE  64    // circular DMA area: half of it is the IRQ batch
+#define UART_RX_RING_SIZE 256   // power of two, see ring_buffer_spsc_init()
+#define UART_RX_LINE_MAX  64    // longest line, terminator excluded
+
+typedef struct {
+    UART_HandleTypeDef *huart;
+    uint8_t dma_buffer[UART_RX_DMA_SIZE];
+    uint16_t dma_pos;               // next DMA position not yet moved to the ring
+    ring_buffer_spsc_t ring;
+    uint8_t ring_storage[UART_RX_RING_SIZE];
+    char line[UART_RX_LINE_MAX + 1];
+    uint16_t line_len;
+    bool line_overflow;             // the current line is being discarded
+    bool line_broken;               // ... because a receive error cut it
+    volatile uint32_t events;       // interrupts that reported data
+    volatile uint32_t dropped;      // bytes lost because the ring was full
+    volatile uint32_t errors;       // receive errors, each one restarted the DMA
+    uint32_t errors_seen;           // errors the line assembly has accounted for
+    uint32_t lines;                 // lines handed out by uart_rx_read_line()
+    uint32_t long_lines;            // lines discarded for exceeding UART_RX_LINE_MAX
+    uint32_t broken_lines;          // lines discarded after a receive error
+} uart_rx_t;
+
+bool uart_rx_init(uart_rx_t *rx, UART_HandleTypeDef *huart);
+void uart_rx_event(uart_rx_t *rx, uint16_t pos);
+bool uart_rx_restart(uart_rx_t *rx);
+const char *uart_rx_read_line(uart_rx_t *rx, uint16_t *len);
+
+#endif // UART_RX_H
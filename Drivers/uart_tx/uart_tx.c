@@ -0,0 +1,133 @@
+#include "uart_tx.h"
+#include "fmt.h"
+#include <string.h>
+
+/**
+ * @brief Starts the next DMA transfer if none is running and data is queued.
+ *        Safe from both the main loop and the UART interrupt: the busy flag
+ *        makes sure only one of them takes the consumer side of the ring.
+ */
+static void uart_tx_kick(uart_tx_t *tx)
+{
+    const uint8_t *span;
+
+    while (!atomic_exchange(&tx->busy, true)) {
+        const uint16_t n = ring_buffer_spsc_peek_contiguous(&tx->ring, &span);
+        // Set before the start: the transfer can complete before the call returns
+        tx->in_flight = n;
+        if (n > 0 && HAL_UART_Transmit_DMA(tx->huart, span, n) == HAL_OK) {
+            return;
+        }
+        tx->in_flight = 0;
+        atomic_store(&tx->busy, false);
+        // Data published after the peek would wait for the next write: look again
+        if (n > 0 || ring_buffer_spsc_is_empty(&tx->ring)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Initializes the transmit queue.
+ *
+ * @param tx Pointer to the transmit queue.
+ * @param huart UART whose hdmatx channel is configured in normal mode.
+ */
+void uart_tx_init(uart_tx_t *tx, UART_HandleTypeDef *huart)
+{
+    tx->huart = huart;
+    ring_buffer_spsc_init(&tx->ring, tx->ring_storage, UART_TX_RING_SIZE);
+    atomic_init(&tx->busy, false);
+    tx->in_flight = 0;
+    tx->queued = 0;
+    tx->sent = 0;
+    tx->dropped = 0;
+}
+
+/**
+ * @brief Queues a message and starts sending it if the UART is idle. Never blocks.
+ *        Main loop only.
+ *
+ * @param tx Pointer to the transmit queue.
+ * @param data The bytes to send.
+ * @param len Number of bytes.
+ * @return true if the whole message was queued, false if it was dropped.
+ */
+bool uart_tx_write(uart_tx_t *tx, const void *data, uint16_t len)
+{
+    if (len > uart_tx_free(tx)) {
+        tx->dropped += len;
+        return false;
+    }
+    ring_buffer_spsc_write_bulk(&tx->ring, data, len);
+    tx->queued += len;
+    uart_tx_kick(tx);
+    return true;
+}
+
+/**
+ * @brief Queues a NUL-terminated string, see uart_tx_write().
+ */
+bool uart_tx_puts(uart_tx_t *tx, const char *text)
+{
+    return uart_tx_write(tx, text, (uint16_t)strlen(text));
+}
+
+/**
+ * @brief Formats a message with fmt_vformat() and queues it in one copy, see
+ *        uart_tx_write(). Only the integer conversions of fmt.h are available.
+ */
+bool uart_tx_printf(uart_tx_t *tx, const char *format, ...)
+{
+    char text[UART_TX_FORMAT_MAX + 1];
+    va_list args;
+
+    va_start(args, format);
+    size_t len = fmt_vformat(text, sizeof(text), format, args);
+    va_end(args);
+    if (len > UART_TX_FORMAT_MAX) {
+        len = UART_TX_FORMAT_MAX;
+    }
+    return uart_tx_write(tx, text, (uint16_t)len);
+}
+
+/**
+ * @brief Returns how many bytes uart_tx_write() would accept now.
+ */
+uint16_t uart_tx_free(uart_tx_t *tx)
+{
+    return (uint16_t)(UART_TX_RING_SIZE - ring_buffer_spsc_count(&tx->ring));
+}
+
+/**
+ * @brief Releases the bytes just sent and chains the next transfer.
+ *        Call it from HAL_UART_TxCpltCallback() (interrupt context).
+ *
+ * @param tx Pointer to the transmit queue.
+ */
+void uart_tx_complete(uart_tx_t *tx)
+{
+    ring_buffer_spsc_consume(&tx->ring, tx->in_flight);
+    tx->sent += tx->in_flight;
+    tx->in_flight = 0;
+    atomic_store(&tx->busy, false);
+    uart_tx_kick(tx);
+}
+
+/**
+ * @brief Gives up the transfer that failed and goes on with the queue.
+ *        Call it from HAL_UART_ErrorCallback() (interrupt context).
+ *
+ * @param tx Pointer to the transmit queue.
+ */
+void uart_tx_error(uart_tx_t *tx)
+{
+    if (!atomic_load(&tx->busy) || tx->in_flight == 0) {
+        return;
+    }
+    ring_buffer_spsc_consume(&tx->ring, tx->in_flight);
+    tx->dropped += tx->in_flight;
+    tx->in_flight = 0;
+    atomic_store(&tx->busy, false);
+    uart_tx_kick(tx);
+}
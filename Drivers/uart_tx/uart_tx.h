@@ -0,0 +1,44 @@
+#ifndef UART_TX_H
+#define UART_TX_H
+
+#include "main.h"
+#include "ring_buffer.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/*
+ * Non-blocking UART transmit queue. uart_tx_write() copies a message into the
+ * single-producer/single-consumer ring and returns at once; the ring is sent
+ * in place by DMA, each transfer being chained from the transfer-complete
+ * callback (uart_tx_complete()) while data is queued.
+ *
+ * Drop policy: a message is queued whole or not at all. If it does not fit in
+ * the free space it is dropped, counted in `dropped`, and uart_tx_write()
+ * returns false; callers that must not lose it can check uart_tx_free() first
+ * and retry later (backpressure) instead.
+ */
+
+#define UART_TX_RING_SIZE 512   // power of two, see ring_buffer_spsc_init()
+#define UART_TX_FORMAT_MAX 96   // longest message uart_tx_printf() queues, longer ones are truncated
+
+typedef struct {
+    UART_HandleTypeDef *huart;
+    ring_buffer_spsc_t ring;
+    uint8_t ring_storage[UART_TX_RING_SIZE];
+    atomic_bool busy;               // a DMA transfer owns the consumer side of the ring
+    uint16_t in_flight;             // bytes of the transfer in progress
+    uint32_t queued;                // bytes accepted by uart_tx_write()
+    volatile uint32_t sent;         // bytes whose transfer completed
+    uint32_t dropped;               // bytes rejected because the queue was full
+} uart_tx_t;
+
+void uart_tx_init(uart_tx_t *tx, UART_HandleTypeDef *huart);
+bool uart_tx_write(uart_tx_t *tx, const void *data, uint16_t len);
+bool uart_tx_puts(uart_tx_t *tx, const char *text);
+bool uart_tx_printf(uart_tx_t *tx, const char *format, ...);
+uint16_t uart_tx_free(uart_tx_t *tx);
+void uart_tx_complete(uart_tx_t *tx);
+void uart_tx_error(uart_tx_t *tx);
+
+#endif // UART_TX_H
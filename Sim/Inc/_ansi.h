@@ -0,0 +1,17 @@
+/**
+ * newlib's <_ansi.h> is not part of the host C library; the drivers only
+ * need the C++ linkage guards from it.
+ */
+
+#ifndef _ANSIDECL_H_
+#define _ANSIDECL_H_
+
+#ifdef __cplusplus
+#define _BEGIN_STD_C extern "C" {
+#define _END_STD_C  }
+#else
+#define _BEGIN_STD_C
+#define _END_STD_C
+#endif
+
+#endif /* _ANSIDECL_H_ */
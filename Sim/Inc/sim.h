@@ -0,0 +1,159 @@
+/**
+ * Host simulator control API.
+ *
+ * Everything runs on one virtual clock in nanoseconds. Time only moves when
+ * the firmware touches the simulated hardware (every register access costs
+ * SIM_ACCESS_NS), blocks in HAL_Delay or a blocking transfer, or when the
+ * runner calls sim_advance_ns(). Scheduled events (DMA completions, UART
+ * bytes, key presses, ...) fire from inside those calls, like interrupts.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stm32l4xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Virtual cost of one peripheral register access (~8 cycles at 80 MHz) */
+#define SIM_ACCESS_NS 100U
+
+/* Virtual cost of a busy-wait re-read of an unchanged pin (see HAL_GPIO_ReadPin) */
+#define SIM_POLL_NS 10000U
+
+#define SIM_NS_PER_US 1000ULL
+#define SIM_NS_PER_MS 1000000ULL
+
+typedef void (*sim_event_fn_t)(void *ctx);
+
+/* Level of an externally driven input pin: 0, 1, or SIM_PIN_RELEASED */
+#define SIM_PIN_RELEASED (-1)
+typedef int (*sim_pin_source_t)(void *ctx);
+
+typedef struct {
+    uint32_t gpio_writes;
+    uint32_t exti_events;
+    uint32_t i2c_transactions;
+    uint32_t i2c_bytes;
+    uint32_t uart_tx_bytes;
+    uint32_t uart_rx_bytes;
+    uint32_t uart_rx_irqs;      /* RXNE, or DMA half/complete and IDLE */
+    uint32_t uart_tx_dma;       /* transmit DMA transfers */
+    uint64_t uart_tx_block_ns;  /* time spent inside blocking HAL_UART_Transmit */
+    uint32_t pwm_updates;
+    uint32_t systicks;          /* SysTick interrupts: every millisecond unless suspended */
+} sim_stats_t;
+
+typedef struct {
+    uint64_t sleep_ns;          /* time in tickless Sleep or STOP2 */
+    uint64_t stop2_ns;          /* part of it in STOP2 */
+    uint32_t wakeups;           /* sleeps ended by an interrupt or the LPTIM1 match */
+} sim_lowpower_stats_t;
+
+/* Clock and events */
+void sim_reset(void);
+/* Stops (1) or restarts (0) the SysTick counter, as clearing CTRL.ENABLE does */
+void sim_systick_hold(int hold);
+uint64_t sim_now_ns(void);
+void sim_advance_ns(uint64_t ns);
+void sim_run_until_ns(uint64_t t_ns);
+int sim_schedule_at(uint64_t t_ns, sim_event_fn_t fn, void *ctx);
+uint64_t sim_next_event_ns(void);       /* UINT64_MAX when the queue is empty */
+/* Low-power port: while the core sleeps EXTI edges are latched, and their
+   callbacks run when it is awake again (sim_core_sleep(0)) */
+void sim_core_sleep(int asleep);
+
+/*
+ * Trace of side effects as CSV: t_ns,kind,what,value. Kinds are gpio (output
+ * level changes), exti, pwm, i2c, uart_tx, plus whatever the runner adds for
+ * its stimuli. Nothing is written until sim_trace_open() succeeds.
+ */
+int sim_trace_open(const char *path);
+void sim_trace_close(void);
+void sim_trace(const char *kind, const char *what, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/* GPIO */
+void sim_gpio_attach(GPIO_TypeDef *port, uint16_t pin, sim_pin_source_t source, void *ctx);
+void sim_gpio_set_input(GPIO_TypeDef *port, uint16_t pin, int level);
+int sim_gpio_level(GPIO_TypeDef *port, uint16_t pin);
+void sim_gpio_refresh(void);
+
+/* UART */
+void sim_uart_set_loopback(UART_HandleTypeDef *huart, uint8_t on);
+void sim_uart_inject(UART_HandleTypeDef *huart, const uint8_t *data, size_t len);
+size_t sim_uart_take_tx(UART_HandleTypeDef *huart, char *out, size_t max);
+/* The caller of HAL_UART_Transmit_DMA() is preempted until the transfer is over */
+void sim_uart_preempt_tx(UART_HandleTypeDef *huart, uint8_t on);
+/* The n-th next byte received has a framing error: it is lost and the reception aborted */
+void sim_uart_framing_error(UART_HandleTypeDef *huart, uint32_t nth);
+
+/*
+ * I2C transfers the sink took, oldest first. sim_i2c_take_writes() copies up
+ * to max of those logged since the last take (SIM_I2C_LOG_SIZE at most are
+ * kept) and returns how many there were. sim_i2c_nack() makes the n-th next
+ * transfer fail on the address byte: nothing reaches the device.
+ */
+#define SIM_I2C_LOG_SIZE 32
+typedef struct {
+    uint64_t t_ns;              /* start of the transfer */
+    uint16_t mem_address;       /* 0x00 commands, 0x40 data for the SSD1306 */
+    uint16_t size;
+    uint8_t  head[8];           /* first bytes */
+} sim_i2c_write_t;
+
+size_t sim_i2c_take_writes(sim_i2c_write_t *out, size_t max);
+void sim_i2c_nack(uint32_t nth);
+
+/* SSD1306 panel behind the I2C sink */
+const uint8_t *sim_ssd1306_ram(void);
+void sim_ssd1306_print(void);
+
+/* 4x4 matrix keypad wired to the given row outputs and column inputs */
+void sim_keypad_connect(GPIO_TypeDef *const row_ports[4], const uint16_t row_pins[4],
+                        GPIO_TypeDef *const col_ports[4], const uint16_t col_pins[4]);
+void sim_keypad_press(char key, uint32_t hold_ms);
+/* Worst time from a key press until the firmware first drove a row to scan it, and that of the last press */
+uint64_t sim_keypad_max_latency_ns(void);
+uint64_t sim_keypad_last_latency_ns(void);
+
+/*
+ * DHT11 on a single-wire pin. Answers every host start pulse of 18 ms or more
+ * with the 80/80 us response and 40 data bits for the current reading.
+ */
+void sim_dht11_connect(GPIO_TypeDef *port, uint16_t pin);
+void sim_dht11_set(int16_t temp_tenths, uint8_t humidity);
+uint32_t sim_dht11_transfers(void);
+
+/*
+ * Thermal model of the room (sim_thermal.c): every second it moves the room
+ * temperature with the duty of the given PWM channel and hands it to the
+ * DHT11 model, closing the loop around the fan control.
+ */
+typedef struct {
+    double outdoor_c;           /* air the walls leak to and the fan blows in */
+    double load_k;              /* rise over outdoor the heat load gives with the fan off */
+    double fan_ratio;           /* fan at 100 % over the walls, as heat conductance */
+    double tau_s;               /* time constant with the fan off */
+} sim_thermal_t;
+
+void sim_thermal_start(const sim_thermal_t *model, double temp_c, TIM_HandleTypeDef *htim, uint32_t channel);
+void sim_thermal_set_load(double load_k);
+void sim_thermal_stop(void);
+double sim_thermal_temp(void);
+
+void sim_get_stats(sim_stats_t *stats);
+
+/* Low-power port (sim_lowpower.c); the horizon is where the runner stops next */
+void sim_lowpower_set_horizon(uint64_t t_ns);
+void sim_lowpower_get_stats(sim_lowpower_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_H */
@@ -0,0 +1,95 @@
+/**
+ * Built-in smoke test of the host simulator.
+ *
+ * The runner, the smoke sequence and the scripts live in sim_main.c; the
+ * checks and benchmarks of each driver live in their own sim_test_*.c and
+ * are called from sim_smoke(), in a fixed order on the one virtual clock.
+ * Every entry point returns its number of failed checks.
+ */
+
+#ifndef SIM_TESTS_H
+#define SIM_TESTS_H
+
+#include <stdint.h>
+#include "sim.h"
+#include "keypad.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+#include "fan_ramp.h"
+#include "lowpower.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Board handles (sim_main.c) */
+extern TIM_HandleTypeDef htim3;
+extern DMA_HandleTypeDef hdma_tim3_up;
+extern UART_HandleTypeDef huart2;
+
+/* Firmware state owned by app.c */
+extern keypad_handle_t keypad;
+extern uart_rx_t uart2_rx;
+extern uart_tx_t uart2_tx;
+extern fan_ramp_t fan_ramp;
+
+/* Runner (sim_main.c) */
+void sim_run_until(uint64_t until_ns);
+int sim_check(int ok, const char *what);
+long long sim_tick_drift_ms(void);
+uint32_t sim_fuzz_next(void);
+int sim_uart_sent(const char *text);
+void sim_uart_command(const char *line);
+
+/* Host time for the benchmarks */
+#if defined(__x86_64__) || defined(__i386__)
+#define SIM_CYCLES_UNIT "TSC cycles"
+#else
+#define SIM_CYCLES_UNIT "ns"
+#endif
+uint64_t sim_cycles(void);
+
+/* sim_test_room_control.c */
+int sim_fsm_walk(void);
+
+/* sim_test_uart.c */
+int sim_uart_replay(void);
+int sim_uart_tx_burst(void);
+
+/* sim_test_keypad.c */
+int sim_keypad_scanner(void);
+int sim_keypad_rollover(void);
+
+/* sim_test_fan_ramp.c */
+int sim_fan_ramp(void);
+
+/* sim_test_fan_pid.c */
+int sim_fan_control(void);
+
+/* sim_test_commands.c */
+int sim_command_bench(uint32_t rounds);
+
+/* sim_test_fmt.c */
+int sim_fmt(uint32_t rounds);
+
+/* sim_test_ssd1306.c */
+int sim_text_bench(uint32_t rounds);
+int sim_arc_bench(uint32_t rounds);
+int sim_display_flush(void);
+
+/* sim_test_dht11.c */
+int sim_dht11_decoder(uint32_t frames);
+
+/* sim_test_ring_buffer.c */
+int sim_ring_buffer_bulk(uint32_t rounds);
+int sim_ring_buffer_zero_copy(uint32_t rounds);
+int sim_spsc_stress(void);
+
+/* sim_test_lowpower.c: mode is the --idle cap */
+int sim_idle(lowpower_mode_t mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_TESTS_H */
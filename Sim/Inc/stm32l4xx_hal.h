@@ -0,0 +1,451 @@
+/**
+ * Simulated STM32L4 HAL for the host build.
+ *
+ * Only the part of the HAL used by Core/Src and Drivers/ is provided, with the
+ * same names and signatures. The peripherals are models driven by the virtual
+ * clock of Sim/Src/sim_hal.c: GPIO pins with pull-ups, EXTI edges and external
+ * sources, free-running TIM counters, compare registers and update interrupts, input capture
+ * with DMA, an I2C sink with bus timing and DMA completion, and a UART with
+ * injected RX, loopback, circular RX DMA with IDLE-line events and TX DMA.
+ * See sim.h for the simulator side of the API.
+ */
+
+#ifndef __STM32L4xx_HAL_H
+#define __STM32L4xx_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __weak   __attribute__((weak))
+#define __IO     volatile
+#define UNUSED(X) (void)(X)
+
+#define __NOP()         do { } while (0)
+#define __disable_irq() do { } while (0)
+#define __enable_irq()  do { } while (0)
+#define __WFI()         do { } while (0)   /* the runner jumps to the next event instead */
+
+/* Interrupts run as events of the virtual clock, never inside firmware code */
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+
+/* Active exception number: nonzero while an event of the virtual clock runs */
+extern uint32_t sim_ipsr;
+static inline uint32_t __get_IPSR(void) { return sim_ipsr; }
+
+typedef enum {
+    HAL_OK       = 0x00U,
+    HAL_ERROR    = 0x01U,
+    HAL_BUSY     = 0x02U,
+    HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+/* Core clock of the target, used to convert timer prescalers to time */
+#define SIM_SYSCLK_HZ 80000000U
+
+typedef enum {
+    DMA1_Channel3_IRQn = 13,
+    DMA1_Channel5_IRQn = 15,
+    DMA1_Channel6_IRQn = 16,
+    DMA1_Channel7_IRQn = 17,
+    I2C1_EV_IRQn       = 31,
+    I2C1_ER_IRQn       = 32,
+    USART2_IRQn        = 38,
+    EXTI9_5_IRQn       = 23,
+    EXTI15_10_IRQn     = 40,
+    TIM6_DAC_IRQn      = 54,
+    DMA2_Channel7_IRQn = 69
+} IRQn_Type;
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+
+HAL_StatusTypeDef HAL_Init(void);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+void HAL_SuspendTick(void);
+void HAL_ResumeTick(void);
+
+/* SysTick count behind HAL_GetTick(); it only moves while the tick is not suspended */
+extern volatile uint32_t uwTick;
+
+/* DWT cycle counter: reading DWT syncs CYCCNT with the virtual clock while
+   CTRL.CYCCNTENA is set; writes to CYCCNT are not kept */
+typedef struct {
+    uint32_t CTRL;
+    uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    uint32_t DEMCR;
+} CoreDebug_Type;
+
+DWT_Type *sim_dwt(void);
+extern CoreDebug_Type sim_core_debug;
+#define DWT       (sim_dwt())
+#define CoreDebug (&sim_core_debug)
+#define DWT_CTRL_CYCCNTENA_Msk     (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+/* ------------------------------------------------------------------------- */
+/* GPIO                                                                      */
+/* ------------------------------------------------------------------------- */
+
+typedef struct {
+    char     name;          /* 'A', 'B', ... */
+    uint16_t ODR;           /* output latch */
+    uint16_t IDR;           /* level of every pin after the last refresh */
+    uint16_t output;        /* pins in output mode */
+    uint16_t pullup;
+    uint16_t exti_rising;
+    uint16_t exti_falling;
+    uint16_t exti_pending;  /* edges latched while the core sleeps */
+    uint16_t alternate;     /* pins in alternate function mode */
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef sim_gpio_ports[8];
+#define GPIOA (&sim_gpio_ports[0])
+#define GPIOB (&sim_gpio_ports[1])
+#define GPIOC (&sim_gpio_ports[2])
+#define GPIOD (&sim_gpio_ports[3])
+#define GPIOE (&sim_gpio_ports[4])
+#define GPIOF (&sim_gpio_ports[5])
+#define GPIOG (&sim_gpio_ports[6])
+#define GPIOH (&sim_gpio_ports[7])
+
+#define GPIO_PIN_0   ((uint16_t)0x0001)
+#define GPIO_PIN_1   ((uint16_t)0x0002)
+#define GPIO_PIN_2   ((uint16_t)0x0004)
+#define GPIO_PIN_3   ((uint16_t)0x0008)
+#define GPIO_PIN_4   ((uint16_t)0x0010)
+#define GPIO_PIN_5   ((uint16_t)0x0020)
+#define GPIO_PIN_6   ((uint16_t)0x0040)
+#define GPIO_PIN_7   ((uint16_t)0x0080)
+#define GPIO_PIN_8   ((uint16_t)0x0100)
+#define GPIO_PIN_9   ((uint16_t)0x0200)
+#define GPIO_PIN_10  ((uint16_t)0x0400)
+#define GPIO_PIN_11  ((uint16_t)0x0800)
+#define GPIO_PIN_12  ((uint16_t)0x1000)
+#define GPIO_PIN_13  ((uint16_t)0x2000)
+#define GPIO_PIN_14  ((uint16_t)0x4000)
+#define GPIO_PIN_15  ((uint16_t)0x8000)
+#define GPIO_PIN_All ((uint16_t)0xFFFF)
+
+typedef enum {
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_MODE_INPUT              0x00000000U
+#define GPIO_MODE_OUTPUT_PP          0x00000001U
+#define GPIO_MODE_OUTPUT_OD          0x00000011U
+#define GPIO_MODE_AF_PP              0x00000002U
+#define GPIO_MODE_AF_OD              0x00000012U
+#define GPIO_MODE_ANALOG             0x00000003U
+#define GPIO_MODE_IT_RISING          0x10110000U
+#define GPIO_MODE_IT_FALLING         0x10210000U
+#define GPIO_MODE_IT_RISING_FALLING  0x10310000U
+
+#define GPIO_NOPULL   0x00000000U
+#define GPIO_PULLUP   0x00000001U
+#define GPIO_PULLDOWN 0x00000002U
+
+#define GPIO_SPEED_FREQ_LOW       0x00000000U
+#define GPIO_SPEED_FREQ_MEDIUM    0x00000001U
+#define GPIO_SPEED_FREQ_HIGH      0x00000002U
+#define GPIO_SPEED_FREQ_VERY_HIGH 0x00000003U
+
+#define GPIO_AF1_TIM2 ((uint8_t)0x01)
+#define GPIO_AF2_TIM3 ((uint8_t)0x02)
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+
+/* ------------------------------------------------------------------------- */
+/* DMA                                                                       */
+/* ------------------------------------------------------------------------- */
+
+/* A channel only stands for its identity: which requests reach it is up to sim_hal.c */
+typedef struct {
+    uint32_t CCR;
+} DMA_Channel_TypeDef;
+
+extern DMA_Channel_TypeDef sim_dma1_channels[7], sim_dma2_channels[7];
+#define DMA1_Channel1 (&sim_dma1_channels[0])
+#define DMA1_Channel2 (&sim_dma1_channels[1])
+#define DMA1_Channel3 (&sim_dma1_channels[2])
+#define DMA1_Channel4 (&sim_dma1_channels[3])
+#define DMA1_Channel5 (&sim_dma1_channels[4])
+#define DMA1_Channel6 (&sim_dma1_channels[5])
+#define DMA1_Channel7 (&sim_dma1_channels[6])
+#define DMA2_Channel7 (&sim_dma2_channels[6])
+
+#define DMA_REQUEST_0 0U
+#define DMA_REQUEST_1 1U
+#define DMA_REQUEST_2 2U
+#define DMA_REQUEST_3 3U
+#define DMA_REQUEST_4 4U
+#define DMA_REQUEST_5 5U
+#define DMA_REQUEST_6 6U
+#define DMA_REQUEST_7 7U
+
+typedef struct {
+    uint32_t Request;
+} DMA_InitTypeDef;
+
+typedef struct {
+    DMA_Channel_TypeDef *Instance;
+    DMA_InitTypeDef Init;
+    void *Parent;
+    volatile uint32_t CNDTR;    /* transfers left, as the channel register */
+} DMA_HandleTypeDef;
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__) ((__HANDLE__)->CNDTR)
+
+/* ------------------------------------------------------------------------- */
+/* TIM                                                                       */
+/* ------------------------------------------------------------------------- */
+
+typedef struct {
+    uint32_t CNT;           /* counter value at base_ns */
+    uint32_t PSC;
+    uint32_t ARR;
+    uint32_t CCR1;
+    uint32_t CCR2;
+    uint32_t CCR3;
+    uint32_t CCR4;
+    uint32_t CR1;           /* bit 0: counter enabled */
+    uint64_t base_ns;       /* virtual time of the last CNT write */
+    uint32_t ic_polarity[4];            /* input capture edges per channel */
+    uint32_t *ic_dst[4];                /* DMA destination while capturing */
+    struct __TIM_HandleTypeDef *ic_handle;
+    const uint16_t *burst_src;          /* DMA source of the update-request burst, one register */
+    uint32_t burst_channel;             /* TIM_CHANNEL_x of the compare register written */
+    uint64_t burst_due_ns;              /* time of the next update DMA request */
+    struct __TIM_HandleTypeDef *burst_handle;
+    uint64_t up_due_ns;                 /* time of the next update interrupt */
+    struct __TIM_HandleTypeDef *up_handle;  /* non-NULL while the update interrupt is enabled */
+} TIM_TypeDef;
+
+extern TIM_TypeDef sim_tim2, sim_tim3, sim_tim6;
+#define TIM2 (&sim_tim2)
+#define TIM3 (&sim_tim3)
+#define TIM6 (&sim_tim6)
+
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t CounterMode;
+    uint32_t Period;
+    uint32_t ClockDivision;
+    uint32_t RepetitionCounter;
+    uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef enum {
+    HAL_DMA_BURST_STATE_RESET = 0x00U,
+    HAL_DMA_BURST_STATE_READY = 0x01U,
+    HAL_DMA_BURST_STATE_BUSY  = 0x02U
+} HAL_TIM_DMABurstStateTypeDef;
+
+typedef struct __TIM_HandleTypeDef {
+    TIM_TypeDef *Instance;
+    TIM_Base_InitTypeDef Init;
+    DMA_HandleTypeDef *hdma[7];
+    HAL_TIM_DMABurstStateTypeDef DMABurstState;    /* busy from a burst start to its stop, as the HAL */
+} TIM_HandleTypeDef;
+
+typedef struct {
+    uint32_t ICPolarity;
+    uint32_t ICSelection;
+    uint32_t ICPrescaler;
+    uint32_t ICFilter;
+} TIM_IC_InitTypeDef;
+
+#define TIM_DMA_ID_UPDATE ((uint16_t)0x0000)
+#define TIM_DMA_ID_CC1 ((uint16_t)0x0001)
+#define TIM_DMA_ID_CC2 ((uint16_t)0x0002)
+#define TIM_DMA_ID_CC3 ((uint16_t)0x0003)
+#define TIM_DMA_ID_CC4 ((uint16_t)0x0004)
+
+#define TIM_DMA_UPDATE                  0x00000100U
+#define TIM_DMABASE_CCR1                0x0000000DU
+#define TIM_DMABASE_CCR2                0x0000000EU
+#define TIM_DMABASE_CCR3                0x0000000FU
+#define TIM_DMABASE_CCR4                0x00000010U
+#define TIM_DMABURSTLENGTH_1TRANSFER    0x00000000U
+
+#define TIM_INPUTCHANNELPOLARITY_RISING   0x00000000U
+#define TIM_INPUTCHANNELPOLARITY_FALLING  0x00000002U
+#define TIM_INPUTCHANNELPOLARITY_BOTHEDGE 0x0000000AU
+#define TIM_ICSELECTION_DIRECTTI          0x00000001U
+#define TIM_ICPSC_DIV1                    0x00000000U
+
+#define TIM_CHANNEL_1 0x00000000U
+#define TIM_CHANNEL_2 0x00000004U
+#define TIM_CHANNEL_3 0x00000008U
+#define TIM_CHANNEL_4 0x0000000CU
+
+#define TIM_COUNTERMODE_UP              0x00000000U
+#define TIM_CLOCKDIVISION_DIV1          0x00000000U
+#define TIM_AUTORELOAD_PRELOAD_DISABLE  0x00000000U
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_DMABurst_MultiWriteStart(TIM_HandleTypeDef *htim, uint32_t BurstBaseAddress,
+                                                  uint32_t BurstRequestSrc, const uint32_t *BurstBuffer,
+                                                  uint32_t BurstLength, uint32_t DataLength);
+HAL_StatusTypeDef HAL_TIM_DMABurst_WriteStop(TIM_HandleTypeDef *htim, uint32_t BurstRequestSrc);
+HAL_StatusTypeDef HAL_TIM_IC_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_IC_InitTypeDef *sConfig, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_IC_Start_DMA(TIM_HandleTypeDef *htim, uint32_t Channel, uint32_t *pData, uint16_t Length);
+HAL_StatusTypeDef HAL_TIM_IC_Stop_DMA(TIM_HandleTypeDef *htim, uint32_t Channel);
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim);
+
+uint32_t sim_tim_get_counter(TIM_HandleTypeDef *htim);
+void sim_tim_set_counter(TIM_HandleTypeDef *htim, uint32_t value);
+void sim_tim_set_compare(TIM_HandleTypeDef *htim, uint32_t channel, uint32_t value);
+uint32_t sim_tim_get_compare(TIM_HandleTypeDef *htim, uint32_t channel);
+
+#define __HAL_TIM_GET_COUNTER(__HANDLE__)          sim_tim_get_counter(__HANDLE__)
+#define __HAL_TIM_SET_COUNTER(__HANDLE__, __V__)   sim_tim_set_counter((__HANDLE__), (__V__))
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CH__, __V__) sim_tim_set_compare((__HANDLE__), (__CH__), (__V__))
+#define __HAL_TIM_GET_COMPARE(__HANDLE__, __CH__)  sim_tim_get_compare((__HANDLE__), (__CH__))
+#define __HAL_TIM_GET_AUTORELOAD(__HANDLE__)       ((__HANDLE__)->Instance->ARR)
+
+/* ------------------------------------------------------------------------- */
+/* I2C                                                                       */
+/* ------------------------------------------------------------------------- */
+
+typedef struct {
+    uint32_t speed_hz;      /* SCL frequency used for the bus timing */
+    uint8_t  busy;          /* DMA transfer in flight */
+} I2C_TypeDef;
+
+extern I2C_TypeDef sim_i2c1;
+#define I2C1 (&sim_i2c1)
+
+typedef struct {
+    uint32_t Timing;
+    uint32_t OwnAddress1;
+    uint32_t AddressingMode;
+} I2C_InitTypeDef;
+
+typedef struct {
+    I2C_TypeDef *Instance;
+    I2C_InitTypeDef Init;
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+    volatile uint32_t ErrorCode;
+} I2C_HandleTypeDef;
+
+#define HAL_I2C_ERROR_AF      0x00000004U   /* acknowledge failure */
+
+#define I2C_MEMADD_SIZE_8BIT  0x00000001U
+#define I2C_MEMADD_SIZE_16BIT 0x00000002U
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                    uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                        uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+
+/* ------------------------------------------------------------------------- */
+/* UART                                                                      */
+/* ------------------------------------------------------------------------- */
+
+#define SIM_UART_LOG_SIZE 4096
+#define SIM_UART_RX_SIZE  256
+
+typedef struct {
+    uint8_t  loopback;      /* TX bytes are received back on RX */
+    uint8_t  tx_preempted;  /* transfers complete before HAL_UART_Transmit_DMA() returns */
+    uint32_t tx_len;        /* bytes in tx_log */
+    char     tx_log[SIM_UART_LOG_SIZE];
+    uint8_t  rx_line[SIM_UART_RX_SIZE];  /* bytes on the wire, not yet received */
+    uint16_t rx_head;
+    uint16_t rx_tail;
+    uint32_t rx_overruns;   /* bytes lost because no reception was armed */
+    uint32_t rx_error_in;   /* received bytes until the one with a framing error, 0: none */
+    uint64_t rx_idle_ns;    /* IDLE flag time after the last received byte */
+} USART_TypeDef;
+
+extern USART_TypeDef sim_usart2;
+#define USART2 (&sim_usart2)
+
+typedef struct {
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t HwFlowCtl;
+    uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef struct {
+    USART_TypeDef *Instance;
+    UART_InitTypeDef Init;
+    uint8_t *pRxBuffPtr;
+    uint16_t RxXferSize;
+    volatile uint16_t RxXferCount;
+    uint32_t ReceptionType;
+    volatile uint32_t gState;   /* transmit side: READY or BUSY_TX */
+    volatile uint32_t RxState;  /* receive side: READY or BUSY_RX */
+    volatile uint32_t ErrorCode;
+    DMA_HandleTypeDef *hdmatx;
+    DMA_HandleTypeDef *hdmarx;
+} UART_HandleTypeDef;
+
+#define HAL_UART_STATE_READY   0x00000020U
+#define HAL_UART_STATE_BUSY_TX 0x00000021U
+#define HAL_UART_STATE_BUSY_RX 0x00000022U
+
+#define HAL_UART_ERROR_NONE    0x00000000U
+#define HAL_UART_ERROR_FE      0x00000004U   /* framing error */
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+
+#define HAL_UART_RECEPTION_STANDARD 0x00000000U
+#define HAL_UART_RECEPTION_TOIDLE   0x00000001U
+
+/* The RX DMA channel is always taken as circular: no other mode is used */
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32L4xx_HAL_H */
@@ -0,0 +1,109 @@
+/**
+ * DHT11 single-wire sensor model.
+ *
+ * Watches the host side of the line: a low pulse of at least 18 ms followed
+ * by a release starts a transfer. The sensor then waits 30 us, answers with
+ * 80 us low / 80 us high, sends 40 bits (50 us low, then 26 us high for a 0
+ * or 70 us high for a 1, MSB first: humidity, humidity decimal, temperature,
+ * temperature decimal, checksum) and ends with 50 us low before releasing
+ * the line. Every level change is a scheduled event on the virtual clock.
+ */
+
+#include "sim.h"
+
+#define DHT11_START_MIN_NS (18ULL * SIM_NS_PER_MS)
+#define DHT11_PHASES       (3 + 40 * 2 + 1)
+
+static GPIO_TypeDef *dht_port;
+static uint16_t dht_pin;
+static int dht_drive = SIM_PIN_RELEASED;
+static int dht_host_low;
+static uint64_t dht_low_since_ns;
+static uint8_t dht_bytes[5];
+static uint32_t dht_transfers;
+
+/* Waveform of the transfer in progress: levels and durations in us */
+static int8_t dht_level[DHT11_PHASES];
+static uint8_t dht_us[DHT11_PHASES];
+static uint8_t dht_phase;
+static uint8_t dht_phases;
+
+static void dht_step(void *ctx) {
+    (void)ctx;
+    if (dht_phase == dht_phases) {
+        dht_phases = 0;
+        dht_drive = SIM_PIN_RELEASED;
+    } else {
+        dht_drive = dht_level[dht_phase];
+        sim_schedule_at(sim_now_ns() + dht_us[dht_phase] * SIM_NS_PER_US, dht_step, NULL);
+        dht_phase++;
+    }
+    sim_gpio_refresh();
+}
+
+static void dht_add_phase(int8_t level, uint8_t us) {
+    dht_level[dht_phases] = level;
+    dht_us[dht_phases] = us;
+    dht_phases++;
+}
+
+static void dht_start_transfer(void) {
+    dht_phases = 0;
+    dht_phase = 0;
+    dht_add_phase(SIM_PIN_RELEASED, 30);
+    dht_add_phase(0, 80);
+    dht_add_phase(1, 80);
+    for (uint32_t i = 0; i < 40; i++) {
+        const uint8_t bit = (uint8_t)((dht_bytes[i / 8] >> (7 - i % 8)) & 1U);
+        dht_add_phase(0, 50);
+        dht_add_phase(1, bit ? 70 : 26);
+    }
+    dht_add_phase(0, 50);
+
+    dht_transfers++;
+    sim_trace("dht11", "transfer", "%u.%u C %u%%", dht_bytes[2], dht_bytes[3], dht_bytes[0]);
+    sim_schedule_at(sim_now_ns(), dht_step, NULL);
+}
+
+static int dht_line(void *ctx) {
+    (void)ctx;
+    const int host_low = (dht_port->output & dht_pin) && !(dht_port->ODR & dht_pin);
+
+    if (host_low && !dht_host_low) {
+        dht_low_since_ns = sim_now_ns();
+    } else if (!host_low && dht_host_low && dht_phases == 0 &&
+               sim_now_ns() - dht_low_since_ns >= DHT11_START_MIN_NS) {
+        dht_start_transfer();
+    }
+    dht_host_low = host_low;
+    return dht_drive;
+}
+
+void sim_dht11_connect(GPIO_TypeDef *port, uint16_t pin) {
+    dht_port = port;
+    dht_pin = pin;
+    dht_drive = SIM_PIN_RELEASED;
+    dht_host_low = 0;
+    dht_phases = 0;
+    dht_transfers = 0;
+    sim_dht11_set(220, 50);
+    sim_gpio_attach(port, pin, dht_line, NULL);
+}
+
+/* The DHT11 reports 0..50 C; out of range values are clamped */
+void sim_dht11_set(int16_t temp_tenths, uint8_t humidity) {
+    if (temp_tenths < 0) {
+        temp_tenths = 0;
+    } else if (temp_tenths > 500) {
+        temp_tenths = 500;
+    }
+    dht_bytes[0] = humidity;
+    dht_bytes[1] = 0;
+    dht_bytes[2] = (uint8_t)(temp_tenths / 10);
+    dht_bytes[3] = (uint8_t)(temp_tenths % 10);
+    dht_bytes[4] = (uint8_t)(dht_bytes[0] + dht_bytes[1] + dht_bytes[2] + dht_bytes[3]);
+}
+
+uint32_t sim_dht11_transfers(void) {
+    return dht_transfers;
+}
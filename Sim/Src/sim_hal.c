@@ -0,0 +1,1179 @@
+/**
+ * Simulated HAL: virtual clock, event queue and peripheral models.
+ */
+
+#include "sim.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_MAX_EVENTS 64
+#define SIM_PORTS      8
+#define SIM_PINS       16
+
+void sim_ssd1306_write(uint16_t mem_address, const uint8_t *data, uint16_t len);
+
+GPIO_TypeDef sim_gpio_ports[SIM_PORTS];
+TIM_TypeDef sim_tim2, sim_tim3, sim_tim6;
+DMA_Channel_TypeDef sim_dma1_channels[7], sim_dma2_channels[7];
+I2C_TypeDef sim_i2c1;
+USART_TypeDef sim_usart2;
+
+typedef struct {
+    uint64_t t_ns;
+    uint32_t seq;           /* keeps events at the same time in FIFO order */
+    sim_event_fn_t fn;
+    void *ctx;
+} sim_event_t;
+
+static uint64_t sim_time_ns;
+static sim_event_t sim_events[SIM_MAX_EVENTS];
+static uint32_t sim_event_count;
+static uint32_t sim_event_seq;
+static sim_stats_t sim_stats;
+static FILE *sim_trace_file;
+static uint32_t sim_io_epoch;       /* bumped by every event and pin write */
+static uint8_t sim_core_asleep;     /* EXTI callbacks wait for sim_core_sleep(0) */
+
+volatile uint32_t uwTick;
+static uint8_t sim_tick_suspended;  /* interrupt masked by HAL_SuspendTick() */
+static uint8_t sim_tick_held;       /* counter stopped by sim_systick_hold() */
+static uint64_t sim_tick_held_since_ns;
+static uint64_t sim_tick_held_ns;   /* total time the counter was stopped */
+static uint64_t sim_tick_ms;        /* last SysTick millisecond accounted for in uwTick */
+static DWT_Type sim_dwt_regs;       /* CYCCNT follows sim_time_ns, see sim_dwt() */
+CoreDebug_Type sim_core_debug;
+uint32_t sim_ipsr;
+
+static sim_i2c_write_t sim_i2c_log[SIM_I2C_LOG_SIZE];
+static size_t sim_i2c_log_count;
+static uint32_t sim_i2c_nack_in;    /* transfers until the NACKed one, 0: none */
+
+static void sim_tick_sync(void);
+
+typedef struct {
+    sim_pin_source_t source;
+    void *ctx;
+    int8_t level;           /* forced input level or SIM_PIN_RELEASED */
+    uint8_t af;             /* alternate function number */
+} sim_pin_t;
+
+/* Timer input channels reachable through an alternate function */
+typedef struct {
+    GPIO_TypeDef *port;
+    uint16_t pin;
+    uint8_t af;
+    TIM_TypeDef *tim;
+    uint32_t channel;
+} sim_capture_route_t;
+
+static const sim_capture_route_t sim_capture_routes[] = {
+    {GPIOA, GPIO_PIN_5, GPIO_AF1_TIM2, TIM2, TIM_CHANNEL_1},
+};
+
+static void sim_tim_capture(GPIO_TypeDef *port, uint16_t pin, int rising);
+
+/* Timer DMA requests and the DMA1 channel/request pair that carries each
+   (RM0351, DMA1 request mapping). A handle on any other pair starts without
+   an error and never moves, as on the target */
+typedef struct {
+    TIM_TypeDef *tim;
+    uint16_t dma_id;        /* TIM_DMA_ID_x */
+    DMA_Channel_TypeDef *channel;
+    uint32_t request;
+} sim_tim_dma_route_t;
+
+static const sim_tim_dma_route_t sim_tim_dma_routes[] = {
+    {TIM2, TIM_DMA_ID_CC3,    DMA1_Channel1, DMA_REQUEST_4},
+    {TIM2, TIM_DMA_ID_UPDATE, DMA1_Channel2, DMA_REQUEST_4},
+    {TIM2, TIM_DMA_ID_CC1,    DMA1_Channel5, DMA_REQUEST_4},
+    {TIM2, TIM_DMA_ID_CC2,    DMA1_Channel7, DMA_REQUEST_4},
+    {TIM2, TIM_DMA_ID_CC4,    DMA1_Channel7, DMA_REQUEST_4},
+    {TIM3, TIM_DMA_ID_CC3,    DMA1_Channel2, DMA_REQUEST_5},
+    {TIM3, TIM_DMA_ID_CC4,    DMA1_Channel3, DMA_REQUEST_5},
+    {TIM3, TIM_DMA_ID_UPDATE, DMA1_Channel3, DMA_REQUEST_5},
+    {TIM3, TIM_DMA_ID_CC1,    DMA1_Channel6, DMA_REQUEST_5},
+};
+
+static sim_pin_t sim_pins[SIM_PORTS][SIM_PINS];
+static uint16_t sim_sampled[SIM_PORTS];     /* pins with a source or a forced level */
+
+static uint32_t sim_port_index(const GPIO_TypeDef *port) {
+    return (uint32_t)(port - sim_gpio_ports);
+}
+
+static uint32_t sim_pin_index(uint16_t pin) {
+    return (uint32_t)__builtin_ctz(pin);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Clock and events                                                          */
+/* ------------------------------------------------------------------------- */
+
+void sim_reset(void) {
+    sim_time_ns = 0;
+    sim_event_count = 0;
+    sim_event_seq = 0;
+    memset(&sim_stats, 0, sizeof(sim_stats));
+    sim_core_asleep = 0;
+    memset(sim_gpio_ports, 0, sizeof(sim_gpio_ports));
+    memset(sim_sampled, 0, sizeof(sim_sampled));
+    for (uint32_t p = 0; p < SIM_PORTS; p++) {
+        sim_gpio_ports[p].name = (char)('A' + p);
+        for (uint32_t i = 0; i < SIM_PINS; i++) {
+            sim_pins[p][i].source = NULL;
+            sim_pins[p][i].ctx = NULL;
+            sim_pins[p][i].level = SIM_PIN_RELEASED;
+        }
+    }
+    memset(&sim_tim2, 0, sizeof(sim_tim2));
+    memset(&sim_tim3, 0, sizeof(sim_tim3));
+    memset(&sim_tim6, 0, sizeof(sim_tim6));
+    memset(sim_dma1_channels, 0, sizeof(sim_dma1_channels));
+    memset(sim_dma2_channels, 0, sizeof(sim_dma2_channels));
+    memset(&sim_dwt_regs, 0, sizeof(sim_dwt_regs));
+    memset(&sim_core_debug, 0, sizeof(sim_core_debug));
+    memset(&sim_i2c1, 0, sizeof(sim_i2c1));
+    sim_i2c_log_count = 0;
+    sim_i2c_nack_in = 0;
+    memset(&sim_usart2, 0, sizeof(sim_usart2));
+    uwTick = 0;
+    sim_tick_suspended = 0;
+    sim_tick_held = 0;
+    sim_tick_held_ns = 0;
+    sim_tick_ms = 0;
+}
+
+uint64_t sim_now_ns(void) {
+    return sim_time_ns;
+}
+
+int sim_schedule_at(uint64_t t_ns, sim_event_fn_t fn, void *ctx) {
+    if (sim_event_count >= SIM_MAX_EVENTS) {
+        fprintf(stderr, "sim: event queue full\n");
+        return -1;
+    }
+    if (t_ns < sim_time_ns) {
+        t_ns = sim_time_ns;
+    }
+
+    // Keep the queue sorted by (time, seq); it is short, insertion is enough
+    uint32_t i = sim_event_count++;
+    while (i > 0 && sim_events[i - 1].t_ns > t_ns) {
+        sim_events[i] = sim_events[i - 1];
+        i--;
+    }
+    sim_events[i].t_ns = t_ns;
+    sim_events[i].seq = sim_event_seq++;
+    sim_events[i].fn = fn;
+    sim_events[i].ctx = ctx;
+    return 0;
+}
+
+void sim_run_until_ns(uint64_t t_ns) {
+    while (sim_event_count > 0 && sim_events[0].t_ns <= t_ns) {
+        sim_event_t ev = sim_events[0];
+        memmove(&sim_events[0], &sim_events[1], (sim_event_count - 1) * sizeof(sim_event_t));
+        sim_event_count--;
+        if (ev.t_ns > sim_time_ns) {
+            sim_time_ns = ev.t_ns;
+        }
+        sim_io_epoch++;
+        // Events are the interrupts: IPSR holds an exception number while one runs
+        const uint32_t ipsr = sim_ipsr;
+        sim_ipsr = 16U;
+        ev.fn(ev.ctx);
+        sim_ipsr = ipsr;
+    }
+    if (t_ns > sim_time_ns) {
+        sim_time_ns = t_ns;
+    }
+}
+
+void sim_advance_ns(uint64_t ns) {
+    sim_run_until_ns(sim_time_ns + ns);
+}
+
+DWT_Type *sim_dwt(void) {
+    if ((sim_core_debug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk) && (sim_dwt_regs.CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        sim_dwt_regs.CYCCNT = (uint32_t)(sim_time_ns * (SIM_SYSCLK_HZ / 1000000U) / 1000U);
+    }
+    return &sim_dwt_regs;
+}
+
+uint64_t sim_next_event_ns(void) {
+    return sim_event_count ? sim_events[0].t_ns : UINT64_MAX;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Trace                                                                     */
+/* ------------------------------------------------------------------------- */
+
+int sim_trace_open(const char *path) {
+    sim_trace_close();
+    sim_trace_file = fopen(path, "w");
+    if (sim_trace_file == NULL) {
+        return -1;
+    }
+    fputs("t_ns,kind,what,value\n", sim_trace_file);
+    return 0;
+}
+
+void sim_trace_close(void) {
+    if (sim_trace_file) {
+        fclose(sim_trace_file);
+        sim_trace_file = NULL;
+    }
+}
+
+void sim_trace(const char *kind, const char *what, const char *fmt, ...) {
+    va_list args;
+
+    if (sim_trace_file == NULL) {
+        return;
+    }
+    fprintf(sim_trace_file, "%llu,%s,%s,", (unsigned long long)sim_time_ns, kind, what);
+    va_start(args, fmt);
+    vfprintf(sim_trace_file, fmt, args);
+    va_end(args);
+    fputc('\n', sim_trace_file);
+}
+
+/* Port and pin as "PA5" for the trace */
+static const char *sim_pin_name(const GPIO_TypeDef *port, uint16_t pin) {
+    static char name[8];
+    snprintf(name, sizeof(name), "P%c%u", port->name, (unsigned)sim_pin_index(pin));
+    return name;
+}
+
+static void sim_trace_outputs(const GPIO_TypeDef *port, uint16_t before) {
+    const uint16_t changed = (uint16_t)((before ^ port->ODR) & port->output);
+
+    for (uint32_t i = 0; i < SIM_PINS && sim_trace_file; i++) {
+        const uint16_t pin = (uint16_t)(1U << i);
+        if (changed & pin) {
+            sim_trace("gpio", sim_pin_name(port, pin), "%u", (port->ODR & pin) ? 1U : 0U);
+        }
+    }
+}
+
+void sim_get_stats(sim_stats_t *stats) {
+    sim_tick_sync();
+    *stats = sim_stats;
+}
+
+/* ------------------------------------------------------------------------- */
+/* HAL core                                                                  */
+/* ------------------------------------------------------------------------- */
+
+HAL_StatusTypeDef HAL_Init(void) {
+    return HAL_OK;
+}
+
+/* SysTick time: the virtual clock minus the time the counter was held */
+static uint64_t sim_tick_time_ns(void) {
+    return (sim_tick_held ? sim_tick_held_since_ns : sim_time_ns) - sim_tick_held_ns;
+}
+
+/* SysTick interrupts for the millisecond boundaries passed since the last call */
+static void sim_tick_sync(void) {
+    const uint64_t ms = sim_tick_time_ns() / SIM_NS_PER_MS;
+
+    if (!sim_tick_suspended) {
+        uwTick += (uint32_t)(ms - sim_tick_ms);
+        sim_stats.systicks += (uint32_t)(ms - sim_tick_ms);
+    }
+    sim_tick_ms = ms;
+}
+
+uint32_t HAL_GetTick(void) {
+    sim_tick_sync();
+    return uwTick;
+}
+
+/* Like the HAL: masks the interrupt, the counter keeps running */
+void HAL_SuspendTick(void) {
+    sim_tick_sync();
+    sim_tick_suspended = 1;
+}
+
+void HAL_ResumeTick(void) {
+    sim_tick_sync();
+    sim_tick_suspended = 0;
+}
+
+void sim_systick_hold(int hold) {
+    sim_tick_sync();
+    if (hold && !sim_tick_held) {
+        sim_tick_held_since_ns = sim_time_ns;
+    } else if (!hold && sim_tick_held) {
+        sim_tick_held_ns += sim_time_ns - sim_tick_held_since_ns;
+    }
+    sim_tick_held = (uint8_t)(hold != 0);
+}
+
+void HAL_Delay(uint32_t Delay) {
+    // Like the HAL, wait at least one full tick more than asked
+    sim_advance_ns(((uint64_t)Delay + 1) * SIM_NS_PER_MS);
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority) {
+    UNUSED(IRQn);
+    UNUSED(PreemptPriority);
+    UNUSED(SubPriority);
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) {
+    UNUSED(IRQn);
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn) {
+    UNUSED(IRQn);
+}
+
+/* ------------------------------------------------------------------------- */
+/* GPIO                                                                      */
+/* ------------------------------------------------------------------------- */
+
+int sim_gpio_level(GPIO_TypeDef *port, uint16_t pin) {
+    const sim_pin_t *p = &sim_pins[sim_port_index(port)][sim_pin_index(pin)];
+
+    // The source sees every sample, also while the MCU drives the pin, so a
+    // device model can watch the host side of a shared line
+    int level = p->source ? p->source(p->ctx) : SIM_PIN_RELEASED;
+    if (port->output & pin) {
+        return (port->ODR & pin) ? 1 : 0;
+    }
+    if (level != SIM_PIN_RELEASED) {
+        return level ? 1 : 0;
+    }
+    if (p->level != SIM_PIN_RELEASED) {
+        return p->level;
+    }
+    return (port->pullup & pin) ? 1 : 0;
+}
+
+/* Re-sample every pin and raise EXTI callbacks for configured edges */
+void sim_gpio_refresh(void) {
+    for (uint32_t p = 0; p < SIM_PORTS; p++) {
+        GPIO_TypeDef *port = &sim_gpio_ports[p];
+        uint16_t idr = (uint16_t)((port->ODR & port->output) | (port->pullup & ~port->output));
+        for (uint32_t i = 0; i < SIM_PINS; i++) {
+            const uint16_t pin = (uint16_t)(1U << i);
+            if (sim_sampled[p] & pin) {
+                idr = sim_gpio_level(port, pin) ? (uint16_t)(idr | pin) : (uint16_t)(idr & ~pin);
+            }
+        }
+        const uint16_t rising = (uint16_t)(idr & ~port->IDR & port->exti_rising & ~port->output);
+        const uint16_t falling = (uint16_t)(~idr & port->IDR & port->exti_falling & ~port->output);
+        const uint16_t captured = (uint16_t)((idr ^ port->IDR) & port->alternate);
+        port->IDR = idr;
+        for (uint32_t i = 0; captured && i < SIM_PINS; i++) {
+            if (captured & (1U << i)) {
+                sim_tim_capture(port, (uint16_t)(1U << i), (idr >> i) & 1U);
+            }
+        }
+        for (uint32_t i = 0; i < SIM_PINS; i++) {
+            if ((rising | falling) & (1U << i)) {
+                sim_stats.exti_events++;
+                sim_trace("exti", sim_pin_name(port, (uint16_t)(1U << i)), "%s",
+                          (rising & (1U << i)) ? "rise" : "fall");
+                if (sim_core_asleep) {
+                    port->exti_pending |= (uint16_t)(1U << i);
+                } else {
+                    HAL_GPIO_EXTI_Callback((uint16_t)(1U << i));
+                }
+            }
+        }
+    }
+}
+
+void sim_core_sleep(int asleep) {
+    sim_core_asleep = (uint8_t)(asleep != 0);
+    for (uint32_t p = 0; p < SIM_PORTS && !sim_core_asleep; p++) {
+        GPIO_TypeDef *port = &sim_gpio_ports[p];
+        const uint16_t pending = port->exti_pending;
+        port->exti_pending = 0;
+        for (uint32_t i = 0; i < SIM_PINS; i++) {
+            if (pending & (1U << i)) {
+                const uint32_t ipsr = sim_ipsr;
+                sim_ipsr = 16U;
+                HAL_GPIO_EXTI_Callback((uint16_t)(1U << i));
+                sim_ipsr = ipsr;
+            }
+        }
+    }
+}
+
+void sim_gpio_attach(GPIO_TypeDef *port, uint16_t pin, sim_pin_source_t source, void *ctx) {
+    sim_pin_t *p = &sim_pins[sim_port_index(port)][sim_pin_index(pin)];
+    p->source = source;
+    p->ctx = ctx;
+    sim_sampled[sim_port_index(port)] |= pin;
+    sim_gpio_refresh();
+}
+
+void sim_gpio_set_input(GPIO_TypeDef *port, uint16_t pin, int level) {
+    sim_pins[sim_port_index(port)][sim_pin_index(pin)].level = (int8_t)level;
+    sim_sampled[sim_port_index(port)] |= pin;
+    sim_gpio_refresh();
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) {
+    const uint16_t pins = (uint16_t)GPIO_Init->Pin;
+    const uint32_t mode = GPIO_Init->Mode;
+
+    if ((mode & 0x3U) == 0x1U) {
+        GPIOx->output |= pins;
+    } else {
+        GPIOx->output &= (uint16_t)~pins;
+    }
+    if ((mode & 0x3U) == 0x2U) {
+        GPIOx->alternate |= pins;
+        for (uint32_t i = 0; i < SIM_PINS; i++) {
+            if (pins & (1U << i)) {
+                sim_pins[sim_port_index(GPIOx)][i].af = (uint8_t)GPIO_Init->Alternate;
+            }
+        }
+    } else {
+        GPIOx->alternate &= (uint16_t)~pins;
+    }
+    if (GPIO_Init->Pull == GPIO_PULLUP) {
+        GPIOx->pullup |= pins;
+    } else {
+        GPIOx->pullup &= (uint16_t)~pins;
+    }
+    GPIOx->exti_rising &= (uint16_t)~pins;
+    GPIOx->exti_falling &= (uint16_t)~pins;
+    if (mode == GPIO_MODE_IT_RISING || mode == GPIO_MODE_IT_RISING_FALLING) {
+        GPIOx->exti_rising |= pins;
+    }
+    if (mode == GPIO_MODE_IT_FALLING || mode == GPIO_MODE_IT_RISING_FALLING) {
+        GPIOx->exti_falling |= pins;
+    }
+    sim_io_epoch++;
+    sim_advance_ns(SIM_ACCESS_NS);
+    sim_gpio_refresh();
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    static const GPIO_TypeDef *poll_port;
+    static uint16_t poll_pin;
+    static uint32_t poll_epoch;
+
+    // Re-reading a pin while no event fired and no pin was written since the
+    // last read can only return the same level: the firmware is busy-waiting
+    // (delay loops, pulse timing). Such a read costs SIM_POLL_NS, cut short
+    // at the next event so the change is still seen when it happens
+    uint64_t cost = SIM_ACCESS_NS;
+    if (GPIOx == poll_port && GPIO_Pin == poll_pin && sim_io_epoch == poll_epoch) {
+        cost = SIM_POLL_NS;
+        if (sim_next_event_ns() < sim_time_ns + cost) {
+            cost = (sim_next_event_ns() > sim_time_ns + SIM_ACCESS_NS)
+                   ? sim_next_event_ns() - sim_time_ns : SIM_ACCESS_NS;
+        }
+    }
+    sim_advance_ns(cost);
+    poll_port = GPIOx;
+    poll_pin = GPIO_Pin;
+    poll_epoch = sim_io_epoch;
+    return sim_gpio_level(GPIOx, GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+    const uint16_t before = GPIOx->ODR;
+
+    if (PinState != GPIO_PIN_RESET) {
+        GPIOx->ODR |= GPIO_Pin;
+    } else {
+        GPIOx->ODR &= (uint16_t)~GPIO_Pin;
+    }
+    sim_trace_outputs(GPIOx, before);
+    sim_stats.gpio_writes++;
+    sim_io_epoch++;
+    sim_advance_ns(SIM_ACCESS_NS);
+    sim_gpio_refresh();
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin) {
+    const uint16_t before = GPIOx->ODR;
+
+    GPIOx->ODR ^= GPIO_Pin;
+    sim_trace_outputs(GPIOx, before);
+    sim_stats.gpio_writes++;
+    sim_io_epoch++;
+    sim_advance_ns(SIM_ACCESS_NS);
+    sim_gpio_refresh();
+}
+
+__weak void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+    UNUSED(GPIO_Pin);
+}
+
+/* ------------------------------------------------------------------------- */
+/* TIM                                                                       */
+/* ------------------------------------------------------------------------- */
+
+/* Counter value now: counts SYSCLK/(PSC+1) while enabled, wraps at ARR */
+static uint32_t sim_tim_counter(const TIM_TypeDef *tim) {
+    if (!(tim->CR1 & 1U)) {
+        return tim->CNT;
+    }
+    const uint64_t ticks = (sim_time_ns - tim->base_ns) * (SIM_SYSCLK_HZ / 1000000U)
+                           / (1000U * ((uint64_t)tim->PSC + 1U));
+    return (uint32_t)((tim->CNT + ticks) % ((uint64_t)tim->ARR + 1U));
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim) {
+    htim->Instance->PSC = htim->Init.Prescaler;
+    htim->Instance->ARR = htim->Init.Period;
+    htim->Instance->CNT = 0;
+    htim->DMABurstState = HAL_DMA_BURST_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim) {
+    return HAL_TIM_Base_Init(htim);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim) {
+    TIM_TypeDef *tim = htim->Instance;
+    if (!(tim->CR1 & 1U)) {
+        tim->base_ns = sim_time_ns;
+        tim->CR1 |= 1U;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim) {
+    TIM_TypeDef *tim = htim->Instance;
+    tim->CNT = sim_tim_counter(tim);
+    tim->CR1 &= ~1U;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel) {
+    UNUSED(Channel);
+    return HAL_TIM_Base_Start(htim);
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel) {
+    UNUSED(Channel);
+    return HAL_TIM_Base_Stop(htim);
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Init(TIM_HandleTypeDef *htim) {
+    return HAL_TIM_Base_Init(htim);
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_IC_InitTypeDef *sConfig, uint32_t Channel) {
+    htim->Instance->ic_polarity[Channel / 4U] = sConfig->ICPolarity;
+    return HAL_OK;
+}
+
+/* Whether the DMA handle linked for a timer request is a channel that request reaches */
+static int sim_tim_dma_routed(const TIM_TypeDef *tim, uint16_t dma_id, const DMA_HandleTypeDef *hdma) {
+    for (size_t r = 0; r < sizeof(sim_tim_dma_routes) / sizeof(sim_tim_dma_routes[0]); r++) {
+        const sim_tim_dma_route_t *route = &sim_tim_dma_routes[r];
+        if (route->tim == tim && route->dma_id == dma_id) {
+            if (route->channel == hdma->Instance && route->request == hdma->Init.Request) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Start_DMA(TIM_HandleTypeDef *htim, uint32_t Channel, uint32_t *pData, uint16_t Length) {
+    TIM_TypeDef *tim = htim->Instance;
+    DMA_HandleTypeDef *hdma = htim->hdma[TIM_DMA_ID_CC1 + Channel / 4U];
+
+    if (tim->ic_dst[Channel / 4U] != NULL) {
+        return HAL_BUSY;
+    }
+    if (hdma == NULL || pData == NULL || Length == 0) {
+        return HAL_ERROR;
+    }
+    tim->ic_dst[Channel / 4U] = pData;
+    tim->ic_handle = htim;
+    hdma->CNDTR = Length;
+    sim_advance_ns(SIM_ACCESS_NS);
+    return HAL_TIM_Base_Start(htim);
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Stop_DMA(TIM_HandleTypeDef *htim, uint32_t Channel) {
+    htim->Instance->ic_dst[Channel / 4U] = NULL;
+    sim_advance_ns(SIM_ACCESS_NS);
+    return HAL_TIM_Base_Stop(htim);
+}
+
+/* An edge on a pin routed to a timer input: latch the counter into the DMA buffer */
+static void sim_tim_capture(GPIO_TypeDef *port, uint16_t pin, int rising) {
+    const uint8_t af = sim_pins[sim_port_index(port)][sim_pin_index(pin)].af;
+
+    for (size_t r = 0; r < sizeof(sim_capture_routes) / sizeof(sim_capture_routes[0]); r++) {
+        const sim_capture_route_t *route = &sim_capture_routes[r];
+        if (route->port != port || route->pin != pin || route->af != af) {
+            continue;
+        }
+        TIM_TypeDef *tim = route->tim;
+        const uint32_t ch = route->channel / 4U;
+        const uint32_t polarity = tim->ic_polarity[ch];
+        const int wanted = (polarity == TIM_INPUTCHANNELPOLARITY_BOTHEDGE) ||
+                           (rising ? polarity == TIM_INPUTCHANNELPOLARITY_RISING
+                                   : polarity == TIM_INPUTCHANNELPOLARITY_FALLING);
+        if (tim->ic_dst[ch] == NULL || !wanted) {
+            continue;
+        }
+        TIM_HandleTypeDef *htim = tim->ic_handle;
+        DMA_HandleTypeDef *hdma = htim->hdma[TIM_DMA_ID_CC1 + ch];
+        if (!sim_tim_dma_routed(tim, (uint16_t)(TIM_DMA_ID_CC1 + ch), hdma)) {
+            continue;   /* the capture request reaches no channel that serves it */
+        }
+        *tim->ic_dst[ch]++ = sim_tim_counter(tim);
+        if (--hdma->CNDTR == 0) {
+            tim->ic_dst[ch] = NULL;
+            HAL_TIM_IC_CaptureCallback(htim);
+        }
+    }
+}
+
+__weak void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim) {
+    UNUSED(htim);
+}
+
+uint32_t sim_tim_get_counter(TIM_HandleTypeDef *htim) {
+    sim_advance_ns(SIM_ACCESS_NS);
+    return sim_tim_counter(htim->Instance);
+}
+
+void sim_tim_set_counter(TIM_HandleTypeDef *htim, uint32_t value) {
+    htim->Instance->CNT = value;
+    htim->Instance->base_ns = sim_time_ns;
+}
+
+static uint32_t *sim_tim_ccr(TIM_TypeDef *tim, uint32_t channel) {
+    switch (channel) {
+        case TIM_CHANNEL_1: return &tim->CCR1;
+        case TIM_CHANNEL_2: return &tim->CCR2;
+        case TIM_CHANNEL_3: return &tim->CCR3;
+        default:            return &tim->CCR4;
+    }
+}
+
+static void sim_tim_write_compare(TIM_TypeDef *tim, uint32_t channel, uint32_t value) {
+    *sim_tim_ccr(tim, channel) = value;
+    sim_stats.pwm_updates++;
+    sim_trace("pwm", (tim == TIM3) ? "TIM3" : "TIM2", "ch%u=%lu", (unsigned)(channel / 4U + 1U), (unsigned long)value);
+}
+
+void sim_tim_set_compare(TIM_HandleTypeDef *htim, uint32_t channel, uint32_t value) {
+    sim_tim_write_compare(htim->Instance, channel, value);
+    sim_advance_ns(SIM_ACCESS_NS);
+}
+
+uint32_t sim_tim_get_compare(TIM_HandleTypeDef *htim, uint32_t channel) {
+    return *sim_tim_ccr(htim->Instance, channel);
+}
+
+/* Time at which the counter next reaches value, after now or, for a value
+   just written to a preloaded compare register, in the next period;
+   UINT64_MAX if it never does */
+static uint64_t sim_tim_match_ns(const TIM_TypeDef *tim, uint32_t value, int next_period) {
+    if (!(tim->CR1 & 1U) || value > tim->ARR) {
+        return UINT64_MAX;
+    }
+    const uint64_t mhz = SIM_SYSCLK_HZ / 1000000U;
+    const uint64_t tick = 1000U * ((uint64_t)tim->PSC + 1U);     /* ns per count, times mhz */
+    const uint64_t period = (uint64_t)tim->ARR + 1U;
+    const uint64_t ticks = (sim_time_ns - tim->base_ns) * mhz / tick;
+    const uint64_t count = (tim->CNT + ticks) % period;
+    const uint64_t ahead = next_period ? period - count + value : (value + period - count - 1U) % period + 1U;
+    return tim->base_ns + ((ticks + ahead) * tick + mhz - 1U) / mhz;
+}
+
+static void sim_tim_burst_request(void *ctx);
+
+/* The update DMA request comes every period, whatever the compare values */
+static void sim_tim_burst_schedule(TIM_TypeDef *tim) {
+    tim->burst_due_ns = sim_tim_match_ns(tim, 0, 1);
+    if (tim->burst_due_ns != UINT64_MAX) {
+        sim_schedule_at(tim->burst_due_ns, sim_tim_burst_request, tim);
+    }
+}
+
+/* Update event with the DMA request enabled: the next half-word goes to the burst register */
+static void sim_tim_burst_request(void *ctx) {
+    TIM_TypeDef *tim = ctx;
+    if (tim->burst_src == NULL || sim_time_ns != tim->burst_due_ns) {
+        return;     /* stopped or restarted since */
+    }
+    TIM_HandleTypeDef *htim = tim->burst_handle;
+    DMA_HandleTypeDef *hdma = htim->hdma[TIM_DMA_ID_UPDATE];
+    sim_tim_write_compare(tim, tim->burst_channel, *tim->burst_src++);
+    if (--hdma->CNDTR == 0) {
+        // DMA transfer complete: the HAL reports it as a period elapsed, the burst stays busy until stopped
+        tim->burst_src = NULL;
+        HAL_TIM_PeriodElapsedCallback(htim);
+        return;
+    }
+    sim_tim_burst_schedule(tim);
+}
+
+/* Only the update request and one compare register per burst, the way fan_ramp uses it */
+HAL_StatusTypeDef HAL_TIM_DMABurst_MultiWriteStart(TIM_HandleTypeDef *htim, uint32_t BurstBaseAddress,
+                                                  uint32_t BurstRequestSrc, const uint32_t *BurstBuffer,
+                                                  uint32_t BurstLength, uint32_t DataLength) {
+    TIM_TypeDef *tim = htim->Instance;
+    DMA_HandleTypeDef *hdma = htim->hdma[TIM_DMA_ID_UPDATE];
+
+    if (htim->DMABurstState == HAL_DMA_BURST_STATE_BUSY) {
+        return HAL_BUSY;
+    }
+    if (hdma == NULL || BurstBuffer == NULL || DataLength == 0 || BurstRequestSrc != TIM_DMA_UPDATE ||
+        BurstLength != TIM_DMABURSTLENGTH_1TRANSFER || BurstBaseAddress < TIM_DMABASE_CCR1 ||
+        BurstBaseAddress > TIM_DMABASE_CCR4) {
+        return HAL_ERROR;
+    }
+    htim->DMABurstState = HAL_DMA_BURST_STATE_BUSY;
+    hdma->CNDTR = DataLength;
+    sim_advance_ns(SIM_ACCESS_NS);
+    if (!sim_tim_dma_routed(tim, TIM_DMA_ID_UPDATE, hdma)) {
+        sim_trace("dma", (tim == TIM3) ? "TIM3" : "TIM2", "update request not routed");
+        return HAL_OK;
+    }
+    // The channel is configured for half-word memory accesses (hdma_tim3_up)
+    tim->burst_src = (const uint16_t *)BurstBuffer;
+    tim->burst_channel = (BurstBaseAddress - TIM_DMABASE_CCR1) * 4U;     /* TIM_CHANNEL_x */
+    tim->burst_handle = htim;
+    sim_tim_burst_schedule(tim);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_DMABurst_WriteStop(TIM_HandleTypeDef *htim, uint32_t BurstRequestSrc) {
+    UNUSED(BurstRequestSrc);
+    htim->Instance->burst_src = NULL;
+    htim->DMABurstState = HAL_DMA_BURST_STATE_READY;
+    sim_advance_ns(SIM_ACCESS_NS);
+    return HAL_OK;
+}
+
+static void sim_tim_update(void *ctx);
+
+/* The update event comes when the counter wraps from ARR to 0 */
+static void sim_tim_update_schedule(TIM_TypeDef *tim) {
+    tim->up_due_ns = sim_tim_match_ns(tim, 0, 1);
+    if (tim->up_due_ns != UINT64_MAX) {
+        sim_schedule_at(tim->up_due_ns, sim_tim_update, tim);
+    }
+}
+
+/* Update interrupt: schedule the next one first, the callback may stop the timer */
+static void sim_tim_update(void *ctx) {
+    TIM_TypeDef *tim = ctx;
+    if (tim->up_handle == NULL || sim_time_ns != tim->up_due_ns) {
+        return;     /* stopped or restarted since */
+    }
+    sim_tim_update_schedule(tim);
+    HAL_TIM_PeriodElapsedCallback(tim->up_handle);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim) {
+    TIM_TypeDef *tim = htim->Instance;
+    tim->up_handle = htim;
+    HAL_TIM_Base_Start(htim);
+    sim_tim_update_schedule(tim);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim) {
+    htim->Instance->up_handle = NULL;
+    return HAL_TIM_Base_Stop(htim);
+}
+
+__weak void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+    UNUSED(htim);
+}
+
+/* ------------------------------------------------------------------------- */
+/* I2C                                                                       */
+/* ------------------------------------------------------------------------- */
+
+/* Bus time of a memory write: start, address, memory address, data, stop */
+static uint64_t sim_i2c_duration_ns(const I2C_HandleTypeDef *hi2c, uint16_t mem_size, uint16_t size) {
+    const uint64_t bits = 2U + 9U * (1U + mem_size + size);
+    return bits * 1000000000ULL / hi2c->Instance->speed_hz;
+}
+
+static void sim_i2c_sink(uint16_t dev_address, uint16_t mem_address, const uint8_t *data, uint16_t size) {
+    sim_stats.i2c_transactions++;
+    sim_stats.i2c_bytes += size;
+    sim_trace("i2c", (mem_address == 0x40) ? "data" : "cmd", "0x%02X+%u", (unsigned)dev_address, (unsigned)size);
+    if (sim_i2c_log_count < SIM_I2C_LOG_SIZE) {
+        sim_i2c_write_t *w = &sim_i2c_log[sim_i2c_log_count];
+        w->t_ns = sim_time_ns;
+        w->mem_address = mem_address;
+        w->size = size;
+        memset(w->head, 0, sizeof(w->head));
+        memcpy(w->head, data, (size < sizeof(w->head)) ? size : sizeof(w->head));
+    }
+    sim_i2c_log_count++;
+    if (dev_address == (0x3C << 1)) {
+        sim_ssd1306_write(mem_address, data, size);
+    }
+}
+
+size_t sim_i2c_take_writes(sim_i2c_write_t *out, size_t max) {
+    const size_t count = sim_i2c_log_count;
+    const size_t kept = (count < SIM_I2C_LOG_SIZE) ? count : SIM_I2C_LOG_SIZE;
+    if (out != NULL) {
+        memcpy(out, sim_i2c_log, ((kept < max) ? kept : max) * sizeof(sim_i2c_write_t));
+    }
+    sim_i2c_log_count = 0;
+    return count;
+}
+
+void sim_i2c_nack(uint32_t nth) {
+    sim_i2c_nack_in = nth;
+}
+
+/* True when this transfer is the one sim_i2c_nack() asked to fail */
+static int sim_i2c_nacked(void) {
+    if (sim_i2c_nack_in == 0) {
+        return 0;
+    }
+    return --sim_i2c_nack_in == 0;
+}
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c) {
+    hi2c->Instance->speed_hz = 400000U;
+    hi2c->Instance->busy = 0;
+    hi2c->ErrorCode = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                    uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    UNUSED(Timeout);
+    if (hi2c->Instance->busy) {
+        return HAL_BUSY;
+    }
+    if (sim_i2c_nacked()) {
+        sim_advance_ns(sim_i2c_duration_ns(hi2c, 0, 0));
+        hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+        return HAL_ERROR;
+    }
+    sim_i2c_sink(DevAddress, MemAddress, pData, Size);
+    sim_advance_ns(sim_i2c_duration_ns(hi2c, MemAddSize, Size));
+    return HAL_OK;
+}
+
+static void sim_i2c_dma_complete(void *ctx) {
+    I2C_HandleTypeDef *hi2c = ctx;
+    hi2c->Instance->busy = 0;
+    HAL_I2C_MemTxCpltCallback(hi2c);
+}
+
+static void sim_i2c_dma_error(void *ctx) {
+    I2C_HandleTypeDef *hi2c = ctx;
+    hi2c->Instance->busy = 0;
+    hi2c->ErrorCode = HAL_I2C_ERROR_AF;
+    HAL_I2C_ErrorCallback(hi2c);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                        uint16_t MemAddSize, uint8_t *pData, uint16_t Size) {
+    if (hi2c->Instance->busy) {
+        return HAL_BUSY;
+    }
+    hi2c->Instance->busy = 1;
+    if (sim_i2c_nacked()) {
+        // The device does not answer its address: the error interrupt ends the transfer
+        sim_schedule_at(sim_time_ns + sim_i2c_duration_ns(hi2c, 0, 0), sim_i2c_dma_error, hi2c);
+        return HAL_OK;
+    }
+    // The data is taken when the transfer starts; the panel sees it at once
+    sim_i2c_sink(DevAddress, MemAddress, pData, Size);
+    sim_schedule_at(sim_time_ns + sim_i2c_duration_ns(hi2c, MemAddSize, Size), sim_i2c_dma_complete, hi2c);
+    return HAL_OK;
+}
+
+__weak void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    UNUSED(hi2c);
+}
+
+__weak void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+    UNUSED(hi2c);
+}
+
+/* ------------------------------------------------------------------------- */
+/* UART                                                                      */
+/* ------------------------------------------------------------------------- */
+
+/* Printable copy of UART bytes for the trace; quotes and control bytes escaped */
+static void sim_escape(char *out, size_t max, const uint8_t *data, uint16_t len) {
+    size_t n = 0;
+
+    for (uint16_t i = 0; i < len && n + 5 < max; i++) {
+        const uint8_t c = data[i];
+        if (c == '\r') {
+            n += (size_t)snprintf(out + n, max - n, "\\r");
+        } else if (c == '\n') {
+            n += (size_t)snprintf(out + n, max - n, "\\n");
+        } else if (c < 0x20 || c >= 0x7F || c == '"' || c == '\\') {
+            n += (size_t)snprintf(out + n, max - n, "\\x%02X", c);
+        } else {
+            out[n++] = (char)c;
+        }
+    }
+    out[n] = '\0';
+}
+
+/* Wire time of one 8N1 frame */
+static uint64_t sim_uart_byte_ns(const UART_HandleTypeDef *huart) {
+    return 10ULL * 1000000000ULL / huart->Init.BaudRate;
+}
+
+/* IDLE line one frame after the last byte: report the DMA position */
+static void sim_uart_idle(void *ctx) {
+    UART_HandleTypeDef *huart = ctx;
+    const uint16_t remaining = (uint16_t)huart->hdmarx->CNDTR;
+
+    if (huart->Instance->rx_idle_ns != sim_time_ns || huart->ReceptionType != HAL_UART_RECEPTION_TOIDLE) {
+        return;
+    }
+    sim_stats.uart_rx_irqs++;
+    if (remaining > 0 && remaining < huart->RxXferSize) {
+        HAL_UARTEx_RxEventCallback(huart, (uint16_t)(huart->RxXferSize - remaining));
+    }
+}
+
+/* Circular DMA reception: half and full transfer report the position too */
+static void sim_uart_rx_dma(UART_HandleTypeDef *huart, uint8_t byte) {
+    DMA_HandleTypeDef *hdma = huart->hdmarx;
+
+    huart->pRxBuffPtr[huart->RxXferSize - hdma->CNDTR] = byte;
+    if (--hdma->CNDTR == huart->RxXferSize / 2U) {
+        sim_stats.uart_rx_irqs++;
+        HAL_UARTEx_RxEventCallback(huart, (uint16_t)(huart->RxXferSize / 2U));
+    } else if (hdma->CNDTR == 0) {
+        hdma->CNDTR = huart->RxXferSize;
+        sim_stats.uart_rx_irqs++;
+        HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+    }
+    if (huart->Instance->rx_tail == huart->Instance->rx_head) {
+        huart->Instance->rx_idle_ns = sim_time_ns + sim_uart_byte_ns(huart);
+        sim_schedule_at(huart->Instance->rx_idle_ns, sim_uart_idle, huart);
+    }
+}
+
+/*
+ * A blocking error while the DMA receives, as HAL_UART_IRQHandler() handles
+ * it: the reception ends (RxState back to READY) and the error callback runs.
+ */
+static void sim_uart_rx_error(UART_HandleTypeDef *huart) {
+    sim_stats.uart_rx_irqs++;
+    huart->ErrorCode = HAL_UART_ERROR_FE;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->pRxBuffPtr = NULL;
+    huart->RxXferCount = 0;
+    HAL_UART_ErrorCallback(huart);
+}
+
+static void sim_uart_rx_byte(void *ctx) {
+    UART_HandleTypeDef *huart = ctx;
+    USART_TypeDef *uart = huart->Instance;
+
+    if (uart->rx_tail == uart->rx_head) {
+        return;
+    }
+    const uint8_t byte = uart->rx_line[uart->rx_tail];
+    uart->rx_tail = (uint16_t)((uart->rx_tail + 1) % SIM_UART_RX_SIZE);
+    // Bytes follow each other on the wire: one event in flight per UART
+    if (uart->rx_tail != uart->rx_head) {
+        sim_schedule_at(sim_time_ns + sim_uart_byte_ns(huart), sim_uart_rx_byte, huart);
+    }
+
+    if (uart->rx_error_in > 0 && --uart->rx_error_in == 0) {
+        if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE) {
+            sim_uart_rx_error(huart);
+        }
+        return;
+    }
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE) {
+        sim_stats.uart_rx_bytes++;
+        sim_uart_rx_dma(huart, byte);
+        return;
+    }
+    if (huart->pRxBuffPtr == NULL || huart->RxXferCount == 0) {
+        uart->rx_overruns++;
+        return;
+    }
+    sim_stats.uart_rx_bytes++;
+    sim_stats.uart_rx_irqs++;
+    *huart->pRxBuffPtr++ = byte;
+    if (--huart->RxXferCount == 0) {
+        huart->pRxBuffPtr = NULL;
+        HAL_UART_RxCpltCallback(huart);
+    }
+}
+
+void sim_uart_inject(UART_HandleTypeDef *huart, const uint8_t *data, size_t len) {
+    USART_TypeDef *uart = huart->Instance;
+    const uint64_t byte_ns = sim_uart_byte_ns(huart);
+
+    const int line_idle = (uart->rx_tail == uart->rx_head);
+
+    for (size_t i = 0; i < len; i++) {
+        const uint16_t next = (uint16_t)((uart->rx_head + 1) % SIM_UART_RX_SIZE);
+        if (next == uart->rx_tail) {
+            uart->rx_overruns++;
+            continue;
+        }
+        uart->rx_line[uart->rx_head] = data[i];
+        uart->rx_head = next;
+    }
+    if (line_idle && uart->rx_tail != uart->rx_head) {
+        sim_schedule_at(sim_time_ns + byte_ns, sim_uart_rx_byte, huart);
+    }
+}
+
+void sim_uart_preempt_tx(UART_HandleTypeDef *huart, uint8_t on) {
+    huart->Instance->tx_preempted = on;
+}
+
+void sim_uart_framing_error(UART_HandleTypeDef *huart, uint32_t nth) {
+    huart->Instance->rx_error_in = nth;
+}
+
+void sim_uart_set_loopback(UART_HandleTypeDef *huart, uint8_t on) {
+    huart->Instance->loopback = on;
+}
+
+size_t sim_uart_take_tx(UART_HandleTypeDef *huart, char *out, size_t max) {
+    USART_TypeDef *uart = huart->Instance;
+    size_t n = (uart->tx_len < max) ? uart->tx_len : max;
+    memcpy(out, uart->tx_log, n);
+    memmove(uart->tx_log, uart->tx_log + n, uart->tx_len - n);
+    uart->tx_len -= (uint32_t)n;
+    return n;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart) {
+    huart->pRxBuffPtr = NULL;
+    huart->RxXferSize = 0;
+    huart->RxXferCount = 0;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    return HAL_OK;
+}
+
+/* Bytes put on the TX line: log, trace and loopback */
+static void sim_uart_tx_bytes(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size) {
+    USART_TypeDef *uart = huart->Instance;
+
+    for (uint16_t i = 0; i < Size; i++) {
+        if (uart->tx_len < SIM_UART_LOG_SIZE) {
+            uart->tx_log[uart->tx_len++] = (char)pData[i];
+        }
+    }
+    sim_stats.uart_tx_bytes += Size;
+    if (sim_trace_file) {
+        char text[96];
+        sim_escape(text, sizeof(text), pData, Size);
+        sim_trace("uart_tx", "USART2", "\"%s\"", text);
+    }
+    if (uart->loopback) {
+        sim_uart_inject(huart, pData, Size);
+    }
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout) {
+    UNUSED(Timeout);
+
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+    sim_uart_tx_bytes(huart, pData, Size);
+    sim_stats.uart_tx_block_ns += Size * sim_uart_byte_ns(huart);
+    sim_advance_ns(Size * sim_uart_byte_ns(huart));
+    return HAL_OK;
+}
+
+static void sim_uart_tx_dma_complete(void *ctx) {
+    UART_HandleTypeDef *huart = ctx;
+
+    huart->gState = HAL_UART_STATE_READY;
+    HAL_UART_TxCpltCallback(huart);
+}
+
+/* The bytes are logged at once; the line is busy until the last one has left */
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size) {
+    if (pData == NULL || Size == 0) {
+        return HAL_ERROR;
+    }
+    if (huart->gState != HAL_UART_STATE_READY) {
+        return HAL_BUSY;
+    }
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    sim_stats.uart_tx_dma++;
+    sim_uart_tx_bytes(huart, pData, Size);
+    if (huart->Instance->tx_preempted) {
+        // Interrupts held the caller for longer than the transfer: it is over on return
+        sim_advance_ns(Size * sim_uart_byte_ns(huart));
+        const uint32_t ipsr = sim_ipsr;
+        sim_ipsr = 16U;
+        sim_uart_tx_dma_complete(huart);
+        sim_ipsr = ipsr;
+        return HAL_OK;
+    }
+    sim_schedule_at(sim_time_ns + Size * sim_uart_byte_ns(huart), sim_uart_tx_dma_complete, huart);
+    return HAL_OK;
+}
+
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    UNUSED(huart);
+}
+
+__weak void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+    UNUSED(huart);
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+    if (huart->pRxBuffPtr != NULL && huart->RxXferCount > 0) {
+        return HAL_BUSY;
+    }
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->RxXferCount = Size;
+    return HAL_OK;
+}
+
+__weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
+    UNUSED(huart);
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+    if (huart->hdmarx == NULL || pData == NULL || Size == 0) {
+        return HAL_ERROR;
+    }
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE || (huart->pRxBuffPtr != NULL && huart->RxXferCount > 0)) {
+        return HAL_BUSY;
+    }
+    huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->RxXferCount = Size;
+    huart->hdmarx->CNDTR = Size;
+    return HAL_OK;
+}
+
+__weak void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+    UNUSED(huart);
+    UNUSED(Size);
+}
@@ -0,0 +1,107 @@
+/**
+ * 4x4 matrix keypad model.
+ *
+ * A pressed key connects its row to its column. A column reads low while a
+ * path of pressed keys leads from it to a row driven low; otherwise the pin
+ * is released and its pull-up applies. There are no diodes: through other
+ * pressed keys a path may cross rows driven high (the low driver is taken to
+ * win), which is how the fourth corner of a rectangle of pressed keys ghosts.
+ */
+
+#include "sim.h"
+
+static const char keypad_keys[4][4] = {
+    {'1', '2', '3', 'A'},
+    {'4', '5', '6', 'B'},
+    {'7', '8', '9', 'C'},
+    {'*', '0', '#', 'D'}
+};
+
+static GPIO_TypeDef *keypad_row_ports[4];
+static uint16_t keypad_row_pins[4];
+static uint16_t keypad_pressed;     /* bit row * 4 + col */
+static uint8_t keypad_cols[4] = {0, 1, 2, 3};
+static uint64_t keypad_press_ns;
+static int keypad_waiting;          /* pressed, the firmware has not scanned yet */
+static uint64_t keypad_max_latency_ns;
+static uint64_t keypad_last_latency_ns;
+
+static int keypad_column_level(void *ctx) {
+    const uint8_t col = *(const uint8_t *)ctx;
+
+    // The rows idle low; the first one driven high after a press starts its scan
+    for (uint8_t row = 0; keypad_waiting && row < 4; row++) {
+        if (sim_gpio_level(keypad_row_ports[row], keypad_row_pins[row]) == 1) {
+            const uint64_t latency = sim_now_ns() - keypad_press_ns;
+            keypad_last_latency_ns = latency;
+            if (latency > keypad_max_latency_ns) {
+                keypad_max_latency_ns = latency;
+            }
+            keypad_waiting = 0;
+        }
+    }
+
+    // Rows and columns pulled low, grown through the pressed keys until stable
+    uint8_t rows_low = 0, cols_low = 0, grown;
+    for (uint8_t row = 0; row < 4; row++) {
+        if (sim_gpio_level(keypad_row_ports[row], keypad_row_pins[row]) == 0) {
+            rows_low |= (uint8_t)(1U << row);
+        }
+    }
+    do {
+        grown = 0;
+        for (uint8_t k = 0; k < 16; k++) {
+            const uint8_t row_bit = (uint8_t)(1U << (k / 4)), col_bit = (uint8_t)(1U << (k % 4));
+            if ((keypad_pressed & (1U << k)) && ((rows_low & row_bit) != 0) != ((cols_low & col_bit) != 0)) {
+                rows_low |= row_bit;
+                cols_low |= col_bit;
+                grown = 1;
+            }
+        }
+    } while (grown);
+    return (cols_low & (1U << col)) ? 0 : SIM_PIN_RELEASED;
+}
+
+void sim_keypad_connect(GPIO_TypeDef *const row_ports[4], const uint16_t row_pins[4],
+                        GPIO_TypeDef *const col_ports[4], const uint16_t col_pins[4]) {
+    keypad_pressed = 0;
+    keypad_waiting = 0;
+    keypad_max_latency_ns = 0;
+    keypad_last_latency_ns = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        keypad_row_ports[i] = row_ports[i];
+        keypad_row_pins[i] = row_pins[i];
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        sim_gpio_attach(col_ports[i], col_pins[i], keypad_column_level, &keypad_cols[i]);
+    }
+}
+
+static void keypad_release(void *ctx) {
+    keypad_pressed &= (uint16_t)~(uintptr_t)ctx;
+    sim_gpio_refresh();
+}
+
+void sim_keypad_press(char key, uint32_t hold_ms) {
+    for (uint8_t row = 0; row < 4; row++) {
+        for (uint8_t col = 0; col < 4; col++) {
+            if (keypad_keys[row][col] == key) {
+                const uint16_t bit = (uint16_t)(1U << (row * 4 + col));
+                keypad_pressed |= bit;
+                keypad_press_ns = sim_now_ns();
+                keypad_waiting = 1;
+                sim_gpio_refresh();
+                sim_schedule_at(sim_now_ns() + hold_ms * SIM_NS_PER_MS, keypad_release, (void *)(uintptr_t)bit);
+                return;
+            }
+        }
+    }
+}
+
+uint64_t sim_keypad_max_latency_ns(void) {
+    return keypad_max_latency_ns;
+}
+
+uint64_t sim_keypad_last_latency_ns(void) {
+    return keypad_last_latency_ns;
+}
@@ -0,0 +1,83 @@
+/**
+ * Low-power port of the simulator: LPTIM1 and the sleep modes of
+ * lowpower_port_sleep() on the virtual clock.
+ *
+ * LPTIM1 counts at 32 kHz from lowpower_port_init() on. A sleep runs the
+ * clock to the compare match or to the next scheduled event, whichever comes
+ * first. Every model event is taken as an interrupt that wakes the core, so
+ * the wake count is an upper bound. STOP2 adds its exit time (wakeup on HSI16
+ * and PLL relock). SysTick is held from one LPTIM1 tick edge to another, as
+ * the target port does. EXTI callbacks that come up during the sleep run only
+ * once all of that is over, as the masked interrupt is taken then. The
+ * runner's horizon, where its next stimulus is due, also ends a sleep, as
+ * that stimulus would have; such wakes are not counted.
+ */
+
+#include "sim.h"
+#include "lowpower.h"
+
+#define SIM_LPTIM_HZ      32000ULL
+#define SIM_STOP2_EXIT_NS 40000ULL
+
+static uint64_t lptim_origin_ns;
+static uint64_t horizon_ns = UINT64_MAX;
+static sim_lowpower_stats_t stats;
+
+static uint64_t sim_lptim_ticks(uint64_t t_ns) {
+    return (t_ns - lptim_origin_ns) * SIM_LPTIM_HZ / 1000000000ULL;
+}
+
+/* Busy-waits for the next tick edge and returns the count there */
+static uint64_t sim_lptim_edge(void) {
+    const uint64_t next = sim_lptim_ticks(sim_now_ns()) + 1U;
+    sim_run_until_ns(lptim_origin_ns + (next * 1000000000ULL + SIM_LPTIM_HZ - 1) / SIM_LPTIM_HZ);
+    return next;
+}
+
+void lowpower_port_init(void) {
+    lptim_origin_ns = sim_now_ns();
+    sim_advance_ns(SIM_ACCESS_NS);
+}
+
+uint32_t lowpower_port_sleep(lowpower_mode_t mode, uint32_t ms) {
+    const uint64_t start = sim_lptim_edge();
+    const uint64_t start_ns = sim_now_ns();
+    const uint64_t match = start + (uint64_t)ms * LOWPOWER_TICKS_PER_MS;
+    uint64_t wake_ns = lptim_origin_ns + (match * 1000000000ULL + SIM_LPTIM_HZ - 1) / SIM_LPTIM_HZ;
+    int counted = 1;
+
+    if (sim_next_event_ns() < wake_ns) {
+        wake_ns = sim_next_event_ns();
+    }
+    if (horizon_ns < wake_ns) {
+        wake_ns = horizon_ns;
+        counted = 0;
+    }
+    sim_trace("power", (mode == LOWPOWER_STOP2) ? "stop2" : "sleep", "%lu", (unsigned long)ms);
+    sim_systick_hold(1);
+    sim_core_sleep(1);
+    sim_run_until_ns(wake_ns);
+
+    const uint64_t slept_ns = sim_now_ns() - start_ns;
+    stats.sleep_ns += slept_ns;
+    stats.wakeups += (uint32_t)counted;
+    if (mode == LOWPOWER_STOP2) {
+        stats.stop2_ns += slept_ns;
+        sim_advance_ns(SIM_STOP2_EXIT_NS);
+    }
+    const uint64_t end = sim_lptim_edge();
+    sim_systick_hold(0);
+    sim_core_sleep(0);
+    return (uint32_t)(end - start);
+}
+
+void lowpower_port_irq_handler(void) {
+}
+
+void sim_lowpower_set_horizon(uint64_t t_ns) {
+    horizon_ns = t_ns;
+}
+
+void sim_lowpower_get_stats(sim_lowpower_stats_t *out) {
+    *out = stats;
+}
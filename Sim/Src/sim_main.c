@@ -0,0 +1,620 @@
+/**
+ * Host entry point: board bring-up on the simulated HAL and the runner that
+ * drives the firmware main loop (app_loop_step, one scheduler pass) on the
+ * virtual clock.
+ *
+ *   room_control_sim [--trace FILE] [--quiet] [--idle wfi|tickless|stop2] [SCRIPT]
+ *
+ * Without a script it runs a built-in smoke test, with the checks of each
+ * driver in its own sim_test_*.c (see sim_tests.h). A script is a list of
+ * timed stimuli and checks, one per line ('#' starts a comment):
+ *
+ *   <time> key <K> [hold_ms]      press a keypad key (default hold 80 ms)
+ *   <time> uart <text>            bytes on USART2 RX; \r \n \\ \xHH escapes
+ *   <time> dht11 <temp> <hum>     next DHT11 readings, e.g. 24.5 40
+ *   <time> expect state <NAME>    LOCKED, INPUT_PASSWORD, UNLOCKED, ...
+ *   <time> expect fan <percent>   fan duty, 0..100 (0, 30, 70 or 100 with FAN_MODE:STEP)
+ *   <time> expect door <0|1>      door output level
+ *   <time> expect uart <text>     USART2 sent text since the last expect uart
+ *   <time> print                  dump the panel
+ *   <time> end                    stop the run
+ *
+ * Times are absolute and never decrease. A plain number is in milliseconds;
+ * units h, m, s and ms can be given and combined (90s, 7h30m, 1s500ms).
+ *
+ * A pass of the loop that had no side effect (GPIO write, PWM, I2C, UART,
+ * EXTI) is followed by a jump to the next event or the next millisecond
+ * boundary, whichever comes first: between those the firmware only sees
+ * the same inputs and the same HAL_GetTick(), so it would do the same
+ * thing again. That keeps one simulated day in the range of seconds.
+ *
+ * --idle caps the low-power mode of the idle hook (default stop2, see
+ * lowpower.h). The report predicts the CPU duty cycle (time awake, SysTick
+ * interrupts included) and the number of wakeups for the run.
+ */
+
+#include "main.h"
+#include "app.h"
+#include "sim.h"
+#include "sim_tests.h"
+#include "dht11.h"
+#include "scheduler.h"
+#include "lowpower.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Loop overhead charged per pass of the super loop that did something */
+#define SIM_LOOP_NS 2000U
+
+/* CPU time of one SysTick interrupt (entry, HAL_IncTick, exit) */
+#define SIM_SYSTICK_NS 1000U
+
+I2C_HandleTypeDef hi2c1;
+TIM_HandleTypeDef htim3;
+TIM_HandleTypeDef htim2;
+TIM_HandleTypeDef htim6;
+DMA_HandleTypeDef hdma_tim3_up;
+DMA_HandleTypeDef hdma_i2c1_tx;
+DMA_HandleTypeDef hdma_tim2_ch1;
+DMA_HandleTypeDef hdma_usart2_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
+UART_HandleTypeDef huart2;
+
+typedef struct {
+    uint64_t passes;
+    uint64_t idle_jumps;
+    uint64_t busy_ns;       /* virtual time spent inside passes */
+    uint64_t awake_ns;      /* busy_ns and loop overhead, without low-power sleeps */
+    uint64_t max_pass_ns;
+    uint64_t max_pass_at_ns;
+} sim_loop_stats_t;
+
+static sim_loop_stats_t loop_stats;
+static int quiet;
+static lowpower_mode_t idle_mode = LOWPOWER_STOP2;
+
+void Error_Handler(void) {
+    fprintf(stderr, "Error_Handler at t=%llu ns\n", (unsigned long long)sim_now_ns());
+    exit(1);
+}
+
+/* Pin and peripheral setup of MX_GPIO_Init() and the other MX_*_Init() */
+static void sim_board_init(void) {
+    GPIO_InitTypeDef gpio = {0};
+
+    HAL_GPIO_WritePin(GPIOA, DOOR_STATUS_Pin | LD2_Pin | KEYPAD_R1_Pin, GPIO_PIN_RESET);
+    HAL_GPIO_WritePin(GPIOB, KEYPAD_R2_Pin | KEYPAD_R4_Pin | KEYPAD_R3_Pin, GPIO_PIN_RESET);
+
+    gpio.Pin = B1_Pin;
+    gpio.Mode = GPIO_MODE_IT_FALLING;
+    gpio.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(B1_GPIO_Port, &gpio);
+    sim_gpio_set_input(B1_GPIO_Port, B1_Pin, 1);
+
+    gpio.Pin = DOOR_STATUS_Pin | LD2_Pin | KEYPAD_R1_Pin;
+    gpio.Mode = GPIO_MODE_OUTPUT_PP;
+    HAL_GPIO_Init(GPIOA, &gpio);
+    gpio.Pin = KEYPAD_R2_Pin | KEYPAD_R4_Pin | KEYPAD_R3_Pin;
+    HAL_GPIO_Init(GPIOB, &gpio);
+
+    gpio.Mode = GPIO_MODE_IT_FALLING;
+    gpio.Pull = GPIO_PULLUP;
+    gpio.Pin = KEYPAD_C1_Pin;
+    HAL_GPIO_Init(KEYPAD_C1_GPIO_Port, &gpio);
+    gpio.Pin = KEYPAD_C4_Pin;
+    HAL_GPIO_Init(KEYPAD_C4_GPIO_Port, &gpio);
+    gpio.Pin = KEYPAD_C2_Pin | KEYPAD_C3_Pin;
+    HAL_GPIO_Init(GPIOA, &gpio);
+
+    sim_keypad_connect(keypad.row_ports, keypad.row_pins, keypad.col_ports, keypad.col_pins);
+    sim_dht11_connect(DHT11_PORT, DHT11_PIN);
+
+    huart2.Instance = USART2;
+    huart2.Init.BaudRate = 115200;
+    huart2.hdmarx = &hdma_usart2_rx;
+    huart2.hdmatx = &hdma_usart2_tx;
+    HAL_UART_Init(&huart2);
+
+    hi2c1.Instance = I2C1;
+    hi2c1.hdmatx = &hdma_i2c1_tx;
+    HAL_I2C_Init(&hi2c1);
+
+    htim3.Instance = TIM3;
+    htim3.Init.Prescaler = 8000 - 1;
+    htim3.Init.Period = 100 - 1;
+    hdma_tim3_up.Instance = DMA1_Channel3;
+    hdma_tim3_up.Init.Request = DMA_REQUEST_5;
+    htim3.hdma[TIM_DMA_ID_UPDATE] = &hdma_tim3_up;
+    HAL_TIM_PWM_Init(&htim3);
+
+    TIM_IC_InitTypeDef ic = {0};
+    htim2.Instance = TIM2;
+    htim2.Init.Prescaler = 80 - 1;
+    htim2.Init.Period = 0xFFFFFFFF;
+    hdma_tim2_ch1.Instance = DMA1_Channel5;
+    hdma_tim2_ch1.Init.Request = DMA_REQUEST_4;
+    htim2.hdma[TIM_DMA_ID_CC1] = &hdma_tim2_ch1;
+    HAL_TIM_IC_Init(&htim2);
+    ic.ICPolarity = TIM_INPUTCHANNELPOLARITY_BOTHEDGE;
+    ic.ICSelection = TIM_ICSELECTION_DIRECTTI;
+    HAL_TIM_IC_ConfigChannel(&htim2, &ic, TIM_CHANNEL_1);
+
+    htim6.Instance = TIM6;
+    htim6.Init.Prescaler = 8000 - 1;
+    htim6.Init.Period = 10 - 1;
+    HAL_TIM_Base_Init(&htim6);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Runner                                                                    */
+/* ------------------------------------------------------------------------- */
+
+static uint64_t sim_activity(void) {
+    sim_stats_t s;
+    sim_get_stats(&s);
+    return (uint64_t)s.gpio_writes + s.exti_events + s.i2c_transactions +
+           s.uart_tx_bytes + s.uart_rx_bytes + s.pwm_updates;
+}
+
+/* Super loop of main() until the virtual clock reaches until_ns */
+void sim_run_until(uint64_t until_ns) {
+    sim_lowpower_set_horizon(until_ns);
+    while (sim_now_ns() < until_ns) {
+        const uint64_t activity = sim_activity();
+        const uint64_t start_ns = sim_now_ns();
+        sim_lowpower_stats_t lp_before, lp_after;
+
+        sim_lowpower_get_stats(&lp_before);
+        app_loop_step();
+        sim_lowpower_get_stats(&lp_after);
+
+        // A tickless sleep inside the pass is not pass time
+        const uint64_t pass_ns = sim_now_ns() - start_ns - (lp_after.sleep_ns - lp_before.sleep_ns);
+        loop_stats.passes++;
+        loop_stats.busy_ns += pass_ns;
+        loop_stats.awake_ns += pass_ns;
+        if (pass_ns > loop_stats.max_pass_ns) {
+            loop_stats.max_pass_ns = pass_ns;
+            loop_stats.max_pass_at_ns = start_ns;
+        }
+
+        if (sim_activity() != activity) {
+            sim_advance_ns(SIM_LOOP_NS);
+            loop_stats.awake_ns += SIM_LOOP_NS;
+            continue;
+        }
+        uint64_t next = (sim_now_ns() / SIM_NS_PER_MS + 1) * SIM_NS_PER_MS;
+        if (sim_next_event_ns() < next) {
+            next = sim_next_event_ns();
+        }
+        if (until_ns < next) {
+            next = until_ns;
+        }
+        if (next <= sim_now_ns()) {
+            sim_advance_ns(SIM_LOOP_NS);
+            loop_stats.awake_ns += SIM_LOOP_NS;
+        } else {
+            loop_stats.idle_jumps++;
+            sim_run_until_ns(next);
+        }
+    }
+}
+
+/* How far HAL_GetTick() is from the virtual clock after the tickless sleeps */
+long long sim_tick_drift_ms(void) {
+    return (long long)(int32_t)(HAL_GetTick() - (uint32_t)(sim_now_ns() / SIM_NS_PER_MS));
+}
+
+static const char *const sim_state_names[] = {
+    "LOCKED", "UNLOCKED", "INPUT_PASSWORD", "ACCESS_DENIED", "EMERGENCY"
+};
+
+int sim_check(int ok, const char *what) {
+    printf("%10.3f s  %-40s %s\n", (double)sim_now_ns() / 1e9, what, ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+static void sim_report(double wall_s) {
+    sim_stats_t stats;
+    char tx[128];
+
+    if (!quiet) {
+        sim_ssd1306_print();
+    }
+    sim_get_stats(&stats);
+    size_t n = sim_uart_take_tx(&huart2, tx, sizeof(tx) - 1);
+    tx[n] = '\0';
+    printf("virtual time      %.3f s (%.3f s on the host)\n", (double)sim_now_ns() / 1e9, wall_s);
+    printf("loop passes       %llu (%llu idle jumps)\n",
+           (unsigned long long)loop_stats.passes, (unsigned long long)loop_stats.idle_jumps);
+    printf("pass time         avg %llu ns, max %llu us at %.3f s\n",
+           (unsigned long long)(loop_stats.passes ? loop_stats.busy_ns / loop_stats.passes : 0),
+           (unsigned long long)(loop_stats.max_pass_ns / SIM_NS_PER_US),
+           (double)loop_stats.max_pass_at_ns / 1e9);
+    printf("gpio writes       %lu\n", (unsigned long)stats.gpio_writes);
+    printf("exti events       %lu\n", (unsigned long)stats.exti_events);
+    printf("i2c transactions  %lu (%lu bytes)\n", (unsigned long)stats.i2c_transactions, (unsigned long)stats.i2c_bytes);
+    printf("uart tx           %lu bytes in %lu DMA transfers, %lu dropped, %llu us blocked\n",
+           (unsigned long)stats.uart_tx_bytes, (unsigned long)stats.uart_tx_dma, (unsigned long)uart2_tx.dropped,
+           (unsigned long long)(stats.uart_tx_block_ns / SIM_NS_PER_US));
+    if (n > 0) {
+        printf("uart tx text      %s%s", tx, (tx[n - 1] == '\n') ? "" : "\n");
+    }
+    printf("uart rx           %lu bytes, %lu interrupts, %lu lines, %lu errors\n", (unsigned long)stats.uart_rx_bytes,
+           (unsigned long)stats.uart_rx_irqs, (unsigned long)uart2_rx.lines, (unsigned long)uart2_rx.errors);
+    printf("pwm updates       %lu (CCR2 = %lu)\n", (unsigned long)stats.pwm_updates,
+           (unsigned long)__HAL_TIM_GET_COMPARE(&htim3, TIM_CHANNEL_2));
+    const int16_t temp = room_control_get_temperature_tenths(&room_system);
+    const int16_t hum = room_control_get_humidity_tenths(&room_system);
+    printf("dht11 transfers   %lu (%s%d.%d C, %d.%d %%)\n", (unsigned long)sim_dht11_transfers(),
+           temp < 0 ? "-" : "", abs(temp) / 10, abs(temp) % 10, hum / 10, hum % 10);
+
+    sched_stats_t sched;
+    sched_get_stats(&sched);
+    printf("scheduler         %lu events (%lu dropped, max %u queued), %lu timer runs\n",
+           (unsigned long)sched.dispatched, (unsigned long)sched.dropped, (unsigned)sched.max_depth,
+           (unsigned long)sched.timer_runs);
+
+    lowpower_stats_t lp;
+    sim_lowpower_stats_t sleep;
+    lowpower_get_stats(&lp);
+    sim_lowpower_get_stats(&sleep);
+    const double total_ns = sim_now_ns() ? (double)sim_now_ns() : 1.0;
+    const uint64_t awake_ns = loop_stats.awake_ns + (uint64_t)stats.systicks * SIM_SYSTICK_NS;
+    printf("idle              %lu WFI, %lu tickless, %lu STOP2 (%lu early), longest %lu ms, %.1f %% in STOP2\n",
+           (unsigned long)lp.sleeps, (unsigned long)lp.tickless, (unsigned long)lp.stop2,
+           (unsigned long)lp.early_wakes, (unsigned long)lp.max_sleep_ms, 100.0 * (double)sleep.stop2_ns / total_ns);
+    printf("cpu duty cycle    %.3f %% awake, %llu wakeups (%lu SysTick, %lu low-power), %.1f per second\n",
+           100.0 * (double)awake_ns / total_ns, (unsigned long long)stats.systicks + sleep.wakeups,
+           (unsigned long)stats.systicks, (unsigned long)sleep.wakeups,
+           ((double)stats.systicks + sleep.wakeups) * 1e9 / total_ns);
+    printf("tick              HAL_GetTick() %+lld ms from the virtual clock, key service within %llu us\n",
+           sim_tick_drift_ms(), (unsigned long long)(sim_keypad_max_latency_ns() / SIM_NS_PER_US));
+}
+
+/* Random bytes for the fuzz runs: xorshift32 from a fixed seed, so every run is the same */
+uint32_t sim_fuzz_next(void) {
+    static uint32_t state = 0x12345678U;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/* True if USART2 sent text since the last call; what was sent is dropped */
+int sim_uart_sent(const char *text) {
+    static char tx[SIM_UART_LOG_SIZE + 1];
+    const size_t n = sim_uart_take_tx(&huart2, tx, SIM_UART_LOG_SIZE);
+    tx[n] = '\0';
+    return strstr(tx, text) != NULL;
+}
+
+/* Sends a command line and lets the firmware answer it */
+void sim_uart_command(const char *line) {
+    sim_uart_inject(&huart2, (const uint8_t *)line, strlen(line));
+    sim_run_until(sim_now_ns() + 20 * SIM_NS_PER_MS);
+}
+
+uint64_t sim_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* ------------------------------------------------------------------------- */
+/* Built-in smoke test                                                       */
+/* ------------------------------------------------------------------------- */
+
+static int sim_smoke(void) {
+    int failures = 0;
+    sim_stats_t stats;
+
+    // app_init() sent the banner with USART2 looped back
+    sim_run_until(1000 * SIM_NS_PER_MS);
+    sim_get_stats(&stats);
+    failures += sim_check(room_control_get_state(&room_system) == ROOM_STATE_LOCKED, "starts locked");
+    failures += sim_check(stats.uart_rx_bytes == strlen("ROOM CONTROL ENABLE\r\n") && uart2_rx.lines == 1,
+                          "UART loopback received the banner");
+    failures += sim_fsm_walk();
+    failures += sim_uart_replay();
+
+    // Default password, one key every 300 ms
+    for (const char *k = "0000"; *k; k++) {
+        sim_keypad_press(*k, 50);
+        sim_run_until(sim_now_ns() + 300 * SIM_NS_PER_MS);
+    }
+    sim_run_until(sim_now_ns() + 500 * SIM_NS_PER_MS);
+    failures += sim_check(room_control_get_state(&room_system) == ROOM_STATE_UNLOCKED, "unlocks with 0000");
+    failures += sim_check(sim_gpio_level(DOOR_STATUS_GPIO_Port, DOOR_STATUS_Pin) == 1, "door output released");
+
+    // A warm room must reach the firmware through the DHT11 waveform; the step table
+    // gives a level that is easy to check, the PID gets its own run on the plant model
+    room_control_set_fan_mode(&room_system, FAN_MODE_STEP);
+    sim_dht11_set(295, 40);
+    sim_run_until(sim_now_ns() + 5000 * SIM_NS_PER_MS);
+    failures += sim_check(room_control_get_temperature_tenths(&room_system) == 295, "DHT11 reading 29.5 C");
+    failures += sim_check(room_control_get_humidity_tenths(&room_system) == 400, "DHT11 humidity 40 %");
+    failures += sim_check(room_control_get_fan_duty(&room_system) == FAN_LEVEL_MED, "fan follows the temperature");
+
+    // Remote console on USART2
+    sim_uart_sent("");
+    sim_uart_command("GET_TEMP\r\n");
+    failures += sim_check(sim_uart_sent("TEMP:29.5\r\n"), "GET_TEMP answers the reading");
+    sim_uart_command("GET_STATUS\r\n");
+    failures += sim_check(sim_uart_sent("STATUS:UNLOCKED,FAN:70\r\n"), "GET_STATUS answers state and fan");
+    sim_uart_command("FORCE_FAN:3\r\n");
+    failures += sim_check(sim_uart_sent("OK\r\n") && room_control_get_fan_duty(&room_system) == FAN_LEVEL_HIGH,
+                          "FORCE_FAN:3 drives the fan");
+    sim_uart_command("FORCE_FAN:7\r\nSET_PASS:12\r\nOPEN\r\n");
+    failures += sim_check(sim_uart_sent("ERROR:BAD_VALUE\r\nERROR:BAD_VALUE\r\nERROR:UNKNOWN_COMMAND\r\n"),
+                          "bad commands are rejected");
+    failures += sim_keypad_scanner();
+    failures += sim_keypad_rollover();
+    failures += sim_fan_ramp();
+    failures += sim_fan_control();
+    failures += sim_uart_tx_burst();
+    failures += sim_command_bench(100000);
+    failures += sim_fmt(20000);
+    failures += sim_text_bench(2000);
+    failures += sim_arc_bench(2000);
+    failures += sim_display_flush();
+    failures += sim_dht11_decoder(20000);
+    failures += sim_ring_buffer_bulk(100000);
+    failures += sim_ring_buffer_zero_copy(100000);
+    failures += sim_spsc_stress();
+
+    sched_stats_t sched;
+    sched_get_stats(&sched);
+    failures += sim_check(sched.dropped == 0 && sched.dispatched == sched.posted, "scheduler ran every event");
+    failures += sim_idle(idle_mode);
+
+    return failures;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Scripts                                                                   */
+/* ------------------------------------------------------------------------- */
+
+/* "1500", "90s", "7h30m", "1m500ms" -> ns; returns the rest of the line or NULL */
+static char *sim_parse_time(char *s, uint64_t *t_ns) {
+    uint64_t total = 0;
+
+    do {
+        char *end;
+        const unsigned long long v = strtoull(s, &end, 10);
+        if (end == s) {
+            return NULL;
+        }
+        uint64_t unit = SIM_NS_PER_MS;
+        if (strncmp(end, "ms", 2) == 0) {
+            end += 2;
+        } else if (*end == 's') {
+            unit = 1000 * SIM_NS_PER_MS;
+            end++;
+        } else if (*end == 'm') {
+            unit = 60 * 1000 * SIM_NS_PER_MS;
+            end++;
+        } else if (*end == 'h') {
+            unit = 3600 * 1000 * SIM_NS_PER_MS;
+            end++;
+        }
+        total += v * unit;
+        s = end;
+    } while (isdigit((unsigned char)*s));
+
+    if (*s != '\0' && !isspace((unsigned char)*s)) {
+        return NULL;
+    }
+    *t_ns = total;
+    return s;
+}
+
+static size_t sim_unescape(const char *s, uint8_t *out, size_t max) {
+    size_t n = 0;
+
+    while (*s && n < max) {
+        if (*s != '\\') {
+            out[n++] = (uint8_t)*s++;
+            continue;
+        }
+        s++;
+        if (*s == 'r') {
+            out[n++] = '\r';
+            s++;
+        } else if (*s == 'n') {
+            out[n++] = '\n';
+            s++;
+        } else if (*s == 'x' && isxdigit((unsigned char)s[1]) && isxdigit((unsigned char)s[2])) {
+            char hex[3] = {s[1], s[2], '\0'};
+            out[n++] = (uint8_t)strtoul(hex, NULL, 16);
+            s += 3;
+        } else if (*s) {
+            out[n++] = (uint8_t)*s++;
+        }
+    }
+    return n;
+}
+
+static int sim_expect(char *args, const char *line) {
+    char what[16], value[32];
+
+    if (sscanf(args, "%15s %31s", what, value) != 2) {
+        return -1;
+    }
+    if (strcmp(what, "state") == 0) {
+        const room_state_t state = room_control_get_state(&room_system);
+        const char *name = (state < sizeof(sim_state_names) / sizeof(sim_state_names[0]))
+                           ? sim_state_names[state] : "?";
+        return sim_check(strcmp(name, value) == 0, line);
+    }
+    if (strcmp(what, "fan") == 0) {
+        return sim_check((int)room_control_get_fan_duty(&room_system) == atoi(value), line);
+    }
+    if (strcmp(what, "uart") == 0) {
+        return sim_check(sim_uart_sent(value), line);
+    }
+    if (strcmp(what, "door") == 0) {
+        return sim_check(sim_gpio_level(DOOR_STATUS_GPIO_Port, DOOR_STATUS_Pin) == atoi(value), line);
+    }
+    return -1;
+}
+
+/* Runs a script; returns the number of failed checks, or -1 on a bad line */
+static int sim_script(FILE *f, const char *path) {
+    char line[256];
+    int failures = 0;
+    unsigned lineno = 0;
+    uint64_t last_ns = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        size_t len = strlen(line);
+        while (len && isspace((unsigned char)line[len - 1])) {
+            line[--len] = '\0';
+        }
+        char *s = line;
+        while (isspace((unsigned char)*s)) {
+            s++;
+        }
+        if (*s == '\0') {
+            continue;
+        }
+
+        uint64_t t_ns;
+        char cmd[16];
+        int used = 0;
+        char *rest = sim_parse_time(s, &t_ns);
+        if (rest == NULL || t_ns < last_ns || sscanf(rest, " %15s %n", cmd, &used) != 1) {
+            fprintf(stderr, "%s:%u: bad line\n", path, lineno);
+            return -1;
+        }
+        last_ns = t_ns;
+        char *args = rest + used;
+
+        sim_run_until(t_ns);
+
+        int bad = 0;
+        if (strcmp(cmd, "key") == 0) {
+            unsigned hold = 80;
+            if (*args == '\0') {
+                bad = 1;
+            } else {
+                sscanf(args + 1, "%u", &hold);
+                sim_trace("stim", "key", "%c", *args);
+                sim_keypad_press(*args, hold);
+            }
+        } else if (strcmp(cmd, "uart") == 0) {
+            uint8_t bytes[SIM_UART_RX_SIZE];
+            const size_t n = sim_unescape(args, bytes, sizeof(bytes));
+            sim_trace("stim", "uart", "%u bytes", (unsigned)n);
+            sim_uart_inject(&huart2, bytes, n);
+        } else if (strcmp(cmd, "dht11") == 0) {
+            float temp;
+            unsigned hum;
+            if (sscanf(args, "%f %u", &temp, &hum) != 2) {
+                bad = 1;
+            } else {
+                const int16_t tenths = (int16_t)(temp * 10.0f + (temp < 0 ? -0.5f : 0.5f));
+                sim_trace("stim", "dht11", "%d/%u", tenths, hum);
+                sim_dht11_set(tenths, (uint8_t)hum);
+            }
+        } else if (strcmp(cmd, "expect") == 0) {
+            const int r = sim_expect(args, s);
+            if (r < 0) {
+                bad = 1;
+            } else {
+                failures += r;
+            }
+        } else if (strcmp(cmd, "print") == 0) {
+            sim_ssd1306_print();
+        } else if (strcmp(cmd, "end") == 0) {
+            break;
+        } else {
+            bad = 1;
+        }
+        if (bad) {
+            fprintf(stderr, "%s:%u: bad command\n", path, lineno);
+            return -1;
+        }
+    }
+    return failures;
+}
+
+static void sim_usage(void) {
+    fprintf(stderr, "usage: room_control_sim [--trace FILE] [--quiet] [--idle wfi|tickless|stop2] [SCRIPT]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *script = NULL;
+    const char *trace = NULL;
+    int failures;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace = argv[++i];
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = 1;
+        } else if (strcmp(argv[i], "--idle") == 0 && i + 1 < argc) {
+            const char *mode = argv[++i];
+            if (strcmp(mode, "wfi") == 0) {
+                idle_mode = LOWPOWER_SLEEP;
+            } else if (strcmp(mode, "tickless") == 0) {
+                idle_mode = LOWPOWER_SLEEP_TICKLESS;
+            } else if (strcmp(mode, "stop2") != 0) {
+                sim_usage();
+                return 2;
+            }
+        } else if (argv[i][0] != '-' && script == NULL) {
+            script = argv[i];
+        } else {
+            sim_usage();
+            return 2;
+        }
+    }
+
+    sim_reset();
+    if (trace && sim_trace_open(trace) != 0) {
+        perror(trace);
+        return 2;
+    }
+    const clock_t wall_start = clock();
+
+    HAL_Init();
+    sim_board_init();
+    // The smoke test gets the banner back on RX; nothing after it is looped back
+    sim_uart_set_loopback(&huart2, script == NULL);
+    app_init();
+    lowpower_set_max_mode(idle_mode);
+    sim_uart_set_loopback(&huart2, 0);
+
+    if (script) {
+        FILE *f = fopen(script, "r");
+        if (f == NULL) {
+            perror(script);
+            return 2;
+        }
+        failures = sim_script(f, script);
+        fclose(f);
+        if (failures < 0) {
+            return 2;
+        }
+    } else {
+        failures = sim_smoke();
+    }
+
+    sim_report((double)(clock() - wall_start) / CLOCKS_PER_SEC);
+    sim_trace_close();
+    return failures ? 1 : 0;
+}
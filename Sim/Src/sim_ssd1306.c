@@ -0,0 +1,116 @@
+/**
+ * SSD1306 panel model behind the simulated I2C sink.
+ *
+ * Decodes the command stream (control byte 0x00) and stores the data stream
+ * (control byte 0x40) in a 128x64 GDDRAM, in page or horizontal addressing
+ * mode, so the host can check what actually reached the panel.
+ */
+
+#include "sim.h"
+#include <stdio.h>
+#include <string.h>
+
+#define PANEL_WIDTH 128
+#define PANEL_PAGES 8
+
+static uint8_t panel_ram[PANEL_PAGES * PANEL_WIDTH];
+static uint8_t panel_cmd[8];
+static uint8_t panel_cmd_len;
+static uint8_t panel_cmd_expect;
+static uint8_t panel_mode = 2;          /* 0: horizontal, 2: page (reset default) */
+static uint8_t panel_col, panel_col_start, panel_col_end = PANEL_WIDTH - 1;
+static uint8_t panel_page, panel_page_start, panel_page_end = PANEL_PAGES - 1;
+
+/* Argument bytes that follow each multi-byte command */
+static uint8_t panel_cmd_args(uint8_t cmd) {
+    switch (cmd) {
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 1;
+        case 0x21: case 0x22: case 0xA3:
+            return 2;
+        case 0x29: case 0x2A:
+            return 5;
+        case 0x26: case 0x27:
+            return 6;
+        default:
+            return 0;
+    }
+}
+
+static void panel_execute(void) {
+    const uint8_t cmd = panel_cmd[0];
+
+    if (cmd == 0x20) {
+        panel_mode = panel_cmd[1] & 0x03;
+    } else if (cmd == 0x21) {
+        panel_col_start = panel_cmd[1] & 0x7F;
+        panel_col_end = panel_cmd[2] & 0x7F;
+        panel_col = panel_col_start;
+    } else if (cmd == 0x22) {
+        panel_page_start = panel_cmd[1] & 0x07;
+        panel_page_end = panel_cmd[2] & 0x07;
+        panel_page = panel_page_start;
+    } else if (cmd >= 0xB0 && cmd <= 0xB7) {
+        panel_page = cmd & 0x07;
+    } else if (cmd <= 0x0F) {
+        panel_col = (uint8_t)((panel_col & 0xF0) | cmd);
+    } else if (cmd >= 0x10 && cmd <= 0x17) {
+        panel_col = (uint8_t)((panel_col & 0x0F) | ((cmd & 0x07) << 4));
+    }
+}
+
+static void panel_command(uint8_t byte) {
+    if (panel_cmd_len == 0) {
+        panel_cmd_expect = panel_cmd_args(byte);
+    }
+    panel_cmd[panel_cmd_len++] = byte;
+    if (panel_cmd_len > panel_cmd_expect) {
+        panel_execute();
+        panel_cmd_len = 0;
+    }
+}
+
+static void panel_data(uint8_t byte) {
+    panel_ram[panel_page * PANEL_WIDTH + panel_col] = byte;
+
+    if (panel_mode == 0) {
+        if (panel_col == panel_col_end) {
+            panel_col = panel_col_start;
+            panel_page = (panel_page == panel_page_end) ? panel_page_start : (uint8_t)(panel_page + 1);
+        } else {
+            panel_col = (uint8_t)((panel_col + 1) & 0x7F);
+        }
+    } else {
+        panel_col = (uint8_t)((panel_col + 1) & 0x7F);
+    }
+}
+
+void sim_ssd1306_write(uint16_t mem_address, const uint8_t *data, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        if (mem_address == 0x40) {
+            panel_data(data[i]);
+        } else {
+            panel_command(data[i]);
+        }
+    }
+}
+
+const uint8_t *sim_ssd1306_ram(void) {
+    return panel_ram;
+}
+
+/* Print the panel as text, two pixel rows per line */
+void sim_ssd1306_print(void) {
+    for (uint32_t y = 0; y < PANEL_PAGES * 8; y += 2) {
+        char line[PANEL_WIDTH + 1];
+        for (uint32_t x = 0; x < PANEL_WIDTH; x++) {
+            const uint8_t b = panel_ram[(y / 8) * PANEL_WIDTH + x];
+            const uint8_t top = (b >> (y % 8)) & 1;
+            const uint8_t bottom = (b >> ((y + 1) % 8)) & 1;
+            line[x] = top ? (bottom ? '#' : '\'') : (bottom ? '.' : ' ');
+        }
+        line[PANEL_WIDTH] = '\0';
+        printf("|%s|\n", line);
+    }
+}
@@ -0,0 +1,59 @@
+/**
+ * Simulator benchmark of the console command parser on the host.
+ */
+
+#include "app.h"
+#include "sim_tests.h"
+#include "commands.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * command_execute() over a mix of valid, invalid and unknown lines. The worst
+ * case is the slowest line at its fastest run, so preemption of the host
+ * process does not show up as parser cost.
+ */
+int sim_command_bench(uint32_t rounds) {
+    static const char *const lines[] = {
+        "GET_TEMP", "GET_STATUS", "SET_PASS:12a4", "FORCE_FAN:9", "FORCE_FAN:2",
+        "SET_PASS:4321", "GET_TEMPERATURE", "HELLO", "", "GET_STATUS:1",
+    };
+    const size_t count = sizeof(lines) / sizeof(lines[0]);
+    uint16_t lens[sizeof(lines) / sizeof(lines[0])];
+    uint64_t best[sizeof(lines) / sizeof(lines[0])];
+    // A locked copy: nothing reaches the fan or the real password
+    room_control_t room = room_system;
+    room.current_state = ROOM_STATE_LOCKED;
+    char reply[COMMAND_REPLY_MAX];
+    uint64_t worst = 0;
+    uint32_t wrong = 0;
+    size_t worst_line = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        lens[i] = (uint16_t)strlen(lines[i]);
+        best[i] = UINT64_MAX;
+    }
+    const clock_t start = clock();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) {
+            const uint64_t t0 = sim_cycles();
+            const command_status_t status = command_execute(&room, lines[i], lens[i], reply, sizeof(reply));
+            const uint64_t t = sim_cycles() - t0;
+            best[i] = (t < best[i]) ? t : best[i];
+            wrong += (i < 2 || i == 5) ? status != COMMAND_OK : status == COMMAND_OK;
+        }
+    }
+    const double s = (double)(clock() - start) / CLOCKS_PER_SEC;
+    for (size_t i = 0; i < count; i++) {
+        if (best[i] > worst) {
+            worst = best[i];
+            worst_line = i;
+        }
+    }
+
+    printf("command parser    %.0f commands/s on the host, worst %llu %s per command (\"%s\")\n",
+           (double)rounds * count / (s > 0 ? s : 1e-9), (unsigned long long)worst, SIM_CYCLES_UNIT,
+           lines[worst_line]);
+    return sim_check(wrong == 0, "command parser results");
+}
@@ -0,0 +1,78 @@
+/**
+ * Simulator tests of DHT11_DecodeEdges(): random frames with timing jitter
+ * against the bytes that were sent, and truncated or damaged captures.
+ */
+
+#include "sim_tests.h"
+#include "dht11.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* Nominal duration plus up to +-jitter us */
+static uint32_t fuzz_us(uint32_t nominal, uint32_t jitter) {
+    return nominal - jitter + sim_fuzz_next() % (2 * jitter + 1);
+}
+
+/* Edge timestamps of a frame as TIM2 would capture them, starting near a wrap */
+static uint32_t fuzz_frame(const uint8_t bytes[5], int leading_edge, uint32_t *edges) {
+    uint32_t n = 0;
+    uint32_t t = 0xFFFFFFFFU - sim_fuzz_next() % 10000U;
+
+    if (leading_edge) {
+        edges[n++] = t;                     // line released before the capture started
+        t += fuzz_us(30, 10);
+    }
+    edges[n++] = t;
+    t += fuzz_us(80, 8);
+    edges[n++] = t;
+    t += fuzz_us(80, 8);
+    for (uint32_t i = 0; i < 40; i++) {
+        edges[n++] = t;
+        t += fuzz_us(50, 8);
+        edges[n++] = t;
+        t += ((bytes[i / 8] >> (7 - i % 8)) & 1U) ? fuzz_us(70, 8) : fuzz_us(26, 8);
+    }
+    edges[n++] = t;
+    t += 50;
+    edges[n++] = t;                         // sensor releases the line
+    return n;
+}
+
+/* Jittered, truncated, corrupted and random frames through DHT11_DecodeEdges() */
+int sim_dht11_decoder(uint32_t frames) {
+    uint32_t edges[DHT11_FRAME_EDGES + 4];
+    uint32_t wrong = 0, accepted_garbage = 0;
+    uint8_t bytes[5], out[5];
+
+    const clock_t start = clock();
+    for (uint32_t f = 0; f < frames; f++) {
+        for (int i = 0; i < 4; i++) {
+            bytes[i] = (uint8_t)sim_fuzz_next();
+        }
+        bytes[4] = (uint8_t)(bytes[0] + bytes[1] + bytes[2] + bytes[3]);
+        const uint32_t n = fuzz_frame(bytes, (f & 3U) == 0, edges);
+
+        if (DHT11_DecodeEdges(edges, n, out) != DHT11_DECODE_OK || memcmp(out, bytes, 5) != 0) {
+            wrong++;
+        }
+        if (DHT11_DecodeEdges(edges, sim_fuzz_next() % (DHT11_FRAME_EDGES - 1), out) == DHT11_DECODE_OK) {
+            wrong++;
+        }
+        const uint32_t victim = 4 + sim_fuzz_next() % 78;
+        edges[victim] += 200;
+        if (DHT11_DecodeEdges(edges, n, out) == DHT11_DECODE_OK) {
+            wrong++;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            edges[i] = (i ? edges[i - 1] : 0) + sim_fuzz_next() % 128U;
+        }
+        if (DHT11_DecodeEdges(edges, n, out) == DHT11_DECODE_OK && (uint8_t)(out[0] + out[1] + out[2] + out[3]) != out[4]) {
+            accepted_garbage++;
+        }
+    }
+    const double ns = (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / (4.0 * frames);
+
+    printf("dht11 decoder     %lu frames, %.0f ns per decode on the host\n", (unsigned long)frames, ns);
+    return sim_check(wrong == 0 && accepted_garbage == 0, "DHT11 decoder on fuzzed edges");
+}
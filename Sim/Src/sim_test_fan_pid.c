@@ -0,0 +1,125 @@
+/**
+ * Simulator tests of the fan PID: integrator windup, and closed-loop runs
+ * on the thermal model of the room.
+ */
+
+#include "app.h"
+#include "sim_tests.h"
+#include "fan_ramp.h"
+#include "fan_pid.h"
+#include <math.h>
+#include <stdio.h>
+
+/*
+ * Anti-windup: held far above the setpoint the PI saturates at 100 %, and
+ * the first reading below the setpoint must already bring it down. Without
+ * the conditional integration the integrator would still be unwinding.
+ */
+static int sim_fan_pid_windup(void) {
+    const fan_pid_config_t config = { .kp = FAN_PID_Q16(24.0), .ki = FAN_PID_Q16(0.016), .kd = 0,
+                                      .sample_ms = TEMP_READ_INTERVAL_MS, .min_step = 4 };
+    fan_pid_t pid;
+    int wrong = 0;
+
+    fan_pid_init(&pid, &config, 250);
+    for (int i = 0; i < 1000; i++) {
+        wrong += fan_pid_update(&pid, 400) != 100;
+    }
+    wrong += pid.integral > (100 << 16) || pid.saturated != 1000;
+    wrong += fan_pid_update(&pid, 245) >= 100;
+    // Below the setpoint it winds down to 0 and stays within range there too
+    for (int i = 0; i < 1000; i++) {
+        fan_pid_update(&pid, 100);
+    }
+    wrong += pid.output != 0 || pid.integral < 0 || fan_pid_update(&pid, 255) == 0;
+    // Steps under min_step do not move the output, the ends always do
+    fan_pid_reset(&pid, 50);
+    pid.integral = 50 << 16;
+    wrong += fan_pid_update(&pid, 250) != 50 || fan_pid_update(&pid, 250) != 50;
+    return sim_check(wrong == 0, "PI anti-windup leaves saturation at once");
+}
+
+/*
+ * Closed loop on the thermal model (sim_thermal.c): the duty the firmware
+ * puts on TIM3 CH2 cools the room and the DHT11 reports the result. Outdoor
+ * air at 20 C, a load that would hold the room at 32 C with the fan off and
+ * a one-hour time constant; the sun adds 3 C of load halfway through. Each
+ * mode runs the same three hours from a warm 28 C.
+ */
+static const sim_thermal_t sim_room_plant = { .outdoor_c = 20.0, .load_k = 12.0, .fan_ratio = 5.0, .tau_s = 3600.0 };
+
+#define SIM_FAN_LOOP_MIN   180
+#define SIM_FAN_LOOP_SUN   90      // minute the load goes up
+#define SIM_FAN_LOOP_LAST  60      // minutes at the end that make the band
+
+typedef struct {
+    double min_c, max_c, mean_c;   // over the last SIM_FAN_LOOP_LAST minutes, one sample a minute
+    double peak_c;                 // highest after the sun came out
+    double changes_per_hour;       // fan ramps started
+} sim_fan_loop_t;
+
+static void sim_fan_loop(const char *name, const char *command, sim_fan_loop_t *out) {
+    sim_uart_command(command);
+    sim_thermal_start(&sim_room_plant, 28.0, &htim3, TIM_CHANNEL_2);
+    const uint32_t ramps = fan_ramp.ramps;
+    double sum = 0.0;
+
+    out->min_c = 100.0;
+    out->max_c = out->peak_c = -100.0;
+    for (int minute = 1; minute <= SIM_FAN_LOOP_MIN; minute++) {
+        if (minute == SIM_FAN_LOOP_SUN) {
+            sim_thermal_set_load(sim_room_plant.load_k + 3.0);
+        }
+        sim_run_until(sim_now_ns() + 60000 * SIM_NS_PER_MS);
+        const double t = sim_thermal_temp();
+        if (minute > SIM_FAN_LOOP_SUN && t > out->peak_c) {
+            out->peak_c = t;
+        }
+        if (minute > SIM_FAN_LOOP_MIN - SIM_FAN_LOOP_LAST) {
+            out->min_c = (t < out->min_c) ? t : out->min_c;
+            out->max_c = (t > out->max_c) ? t : out->max_c;
+            sum += t;
+        }
+    }
+    sim_thermal_stop();
+    out->mean_c = sum / SIM_FAN_LOOP_LAST;
+    out->changes_per_hour = (double)(fan_ramp.ramps - ramps) * 60.0 / SIM_FAN_LOOP_MIN;
+    printf("fan %-5s         %.2f C mean, %.2f..%.2f C in the last hour, %.2f C peak after the sun, "
+           "%.1f fan changes per hour\n", name, out->mean_c, out->min_c, out->max_c, out->peak_c,
+           out->changes_per_hour);
+}
+
+int sim_fan_control(void) {
+    sim_fan_loop_t step, pid;
+    int failures = sim_fan_pid_windup();
+
+    // Console: setpoint in degrees with one optional decimal, range checked by room_control
+    sim_uart_sent("");
+    sim_uart_command("SET_POINT:24.5\r\n");
+    failures += sim_check(sim_uart_sent("OK\r\n") && room_control_get_setpoint(&room_system) == 245,
+                          "SET_POINT:24.5 sets the setpoint");
+    sim_uart_command("SET_POINT:99\r\nSET_POINT:25.\r\nSET_POINT:\r\nFAN_MODE:FAST\r\n");
+    failures += sim_check(sim_uart_sent("ERROR:BAD_VALUE\r\nERROR:BAD_VALUE\r\nERROR:BAD_VALUE\r\n"
+                                        "ERROR:BAD_VALUE\r\n") && room_control_get_setpoint(&room_system) == 245,
+                          "bad setpoints and modes are rejected");
+    sim_uart_command("SET_POINT:25\r\n");
+
+    // FAN_MODE also ends the FORCE_FAN:3 the earlier tests left
+    sim_fan_loop("STEP", "FAN_MODE:STEP\r\n", &step);
+    sim_fan_loop("PID", "FAN_MODE:PID\r\n", &pid);
+    failures += sim_check(room_control_get_fan_mode(&room_system) == FAN_MODE_PID && !room_system.manual_fan_override,
+                          "FAN_MODE:PID takes the fan back");
+    failures += sim_check(pid.min_c >= 24.7 && pid.max_c <= 25.3 && pid.mean_c >= 24.9 && pid.mean_c <= 25.1,
+                          "PI holds the setpoint through a load step");
+    // The table settles wherever its level balances the load, off the setpoint
+    failures += sim_check(fabs(pid.mean_c - 25.0) < fabs(step.mean_c - 25.0) && pid.changes_per_hour <= 20.0,
+                          "PI is closer than the table, few fan changes");
+    failures += sim_check(room_control_get_fan_duty(&room_system) > FAN_LEVEL_LOW &&
+                          room_control_get_fan_duty(&room_system) < FAN_LEVEL_HIGH,
+                          "PI drives the fan between the table levels");
+
+    // Back to 100 % as FORCE_FAN:3 left it: a constant output lets the idle test use STOP2
+    room_control_force_fan_level(&room_system, FAN_LEVEL_HIGH);
+    sim_run_until(sim_now_ns() + (FAN_RAMP_MAX_STEPS + 2) * 10 * SIM_NS_PER_MS);
+    return failures;
+}
@@ -0,0 +1,102 @@
+/**
+ * Simulator tests of the fan PWM ramp.
+ */
+
+#include "app.h"
+#include "sim_tests.h"
+#include "fan_ramp.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * fan_ramp_generate() on random levels and lengths: monotonic, ending on the
+ * target, no step above the linear slope (plus rounding) for the line and
+ * none above 1.5 times it for the S-curve, whose first and last steps must be
+ * the gentlest. Then a level change on TIM3 played out by the DMA, sampled
+ * every PWM period, and one on a DMA channel the update request does not
+ * reach (DMA1 channel 4, the TIM7_UP/DAC_CH2 slot of request 5): it never
+ * moves, and the timeout must put the output on the target.
+ */
+static int sim_fan_ramp_waveforms(uint32_t rounds) {
+    uint16_t wave[FAN_RAMP_MAX_STEPS];
+    uint32_t wrong = 0;
+
+    for (uint32_t r = 0; r < rounds; r++) {
+        const uint16_t from = (uint16_t)(sim_fuzz_next() % 1001U);
+        const uint16_t to = (uint16_t)(sim_fuzz_next() % 1001U);
+        const uint16_t steps = (uint16_t)(1U + sim_fuzz_next() % FAN_RAMP_MAX_STEPS);
+        const fan_ramp_shape_t shape = (r & 1U) ? FAN_RAMP_SCURVE : FAN_RAMP_LINEAR;
+        const uint32_t distance = (uint32_t)abs((int)to - (int)from);
+        const uint32_t slope = (distance + steps - 1U) / steps;
+        const uint32_t limit = (shape == FAN_RAMP_SCURVE) ? (3U * distance + 2U * steps - 1U) / (2U * steps) + 1U : slope;
+
+        wrong += fan_ramp_generate(wave, steps, from, to, shape) != steps || wave[steps - 1] != to;
+        uint32_t first = 0, largest = 0;
+        for (uint16_t i = 0; i < steps; i++) {
+            const uint16_t prev = i ? wave[i - 1] : from;
+            const uint32_t step = (uint32_t)abs((int)wave[i] - (int)prev);
+            wrong += (to >= from) ? wave[i] < prev : wave[i] > prev;
+            largest = (step > largest) ? step : largest;
+            first = i ? first : step;
+        }
+        wrong += largest > limit;
+        if (shape == FAN_RAMP_SCURVE && steps > 2) {
+            wrong += first > slope || (uint32_t)abs((int)to - (int)wave[steps - 2]) > slope;
+        }
+    }
+    wrong += fan_ramp_generate(wave, 0, 0, 100, FAN_RAMP_LINEAR) != 1 || wave[0] != 100;
+    wrong += fan_ramp_generate(wave, FAN_RAMP_MAX_STEPS + 1, 0, 100, FAN_RAMP_LINEAR) != FAN_RAMP_MAX_STEPS;
+    return sim_check(wrong == 0, "fan ramp waveforms");
+}
+
+int sim_fan_ramp(void) {
+    int failures = sim_fan_ramp_waveforms(20000);
+    const uint64_t period_ns = 10 * SIM_NS_PER_MS;     // TIM3: 80 MHz / 8000 / 100
+    uint32_t largest = 0, periods = 0;
+
+    // FORCE_FAN:3 may still be ramping up
+    while (fan_ramp_is_busy(&fan_ramp) && periods++ < 2 * FAN_RAMP_MAX_STEPS) {
+        sim_run_until(sim_now_ns() + period_ns);
+    }
+    const uint32_t ramps = fan_ramp.ramps;
+    uint32_t prev = __HAL_TIM_GET_COMPARE(&htim3, TIM_CHANNEL_2);
+    periods = 0;
+
+    room_control_force_fan_level(&room_system, FAN_LEVEL_LOW);
+    while ((fan_ramp_is_busy(&fan_ramp) || prev != FAN_LEVEL_LOW) && periods < 2 * FAN_RAMP_MAX_STEPS) {
+        sim_run_until(sim_now_ns() + period_ns);
+        const uint32_t ccr = __HAL_TIM_GET_COMPARE(&htim3, TIM_CHANNEL_2);
+        const uint32_t step = (ccr > prev) ? ccr - prev : prev - ccr;
+        largest = (step > largest) ? step : largest;
+        prev = ccr;
+        periods++;
+    }
+    printf("fan ramp          100 -> 30 %% in %lu PWM periods, largest step %lu %%\n", (unsigned long)periods,
+           (unsigned long)largest);
+    failures += sim_check(prev == FAN_LEVEL_LOW && largest < 10 && fan_ramp.ramps == ramps + 1 &&
+                          !fan_ramp_is_busy(&fan_ramp), "fan ramps to a new level by DMA");
+
+    // Back to 100 % as FORCE_FAN:3 left it: a constant output lets the idle test use STOP2
+    room_control_force_fan_level(&room_system, FAN_LEVEL_HIGH);
+    sim_run_until(sim_now_ns() + (FAN_RAMP_MAX_STEPS + 2) * period_ns);
+
+    // A second engine on the same output, its transfer on the wrong channel; the app's stays idle
+    fan_ramp_t probe;
+    hdma_tim3_up.Instance = DMA1_Channel4;
+    fan_ramp_init(&probe, &htim3, TIM_CHANNEL_2, FAN_RAMP_SCURVE, FAN_RAMP_MAX_STEPS);
+    const uint64_t start = sim_now_ns();
+    fan_ramp_to(&probe, FAN_LEVEL_MED);
+    sim_run_until(start + FAN_RAMP_TIMEOUT_MS / 2 * SIM_NS_PER_MS);
+    fan_ramp_poll(&probe);
+    const int stuck = fan_ramp_is_busy(&probe) && __HAL_TIM_GET_COMPARE(&htim3, TIM_CHANNEL_2) == 0;
+    sim_run_until(start + (FAN_RAMP_TIMEOUT_MS + 1) * SIM_NS_PER_MS);
+    fan_ramp_poll(&probe);
+    const int landed = !fan_ramp_is_busy(&probe) && __HAL_TIM_GET_COMPARE(&htim3, TIM_CHANNEL_2) == FAN_LEVEL_MED;
+    fan_ramp_to(&probe, FAN_LEVEL_LOW);
+    const int jumps = !fan_ramp_is_busy(&probe) && __HAL_TIM_GET_COMPARE(&htim3, TIM_CHANNEL_2) == FAN_LEVEL_LOW;
+    failures += sim_check(stuck && landed && jumps && probe.timeouts == 1 && probe.ramps == 1,
+                          "misrouted ramp DMA times out to target");
+    hdma_tim3_up.Instance = DMA1_Channel3;
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_2, FAN_LEVEL_HIGH);
+    return failures;
+}
@@ -0,0 +1,71 @@
+/**
+ * Simulator tests of fmt_format() against snprintf(), and of _write().
+ */
+
+#include "sim_tests.h"
+#include "fmt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int _write(int file, char *ptr, int len);
+
+/*
+ * fmt_format() against snprintf() on random values for the conversions both
+ * support, %t against its definition, truncation, and the time per call of
+ * each on a display-style line.
+ */
+int sim_fmt(uint32_t rounds) {
+    static const char *const formats[] = { "%d", "%u", "%x", "%X", "%5d", "%-5d|", "%05d", "%08x", "%ld", "%c%s%%" };
+    char got[64], want[64];
+    uint32_t wrong = 0, seed = 0x2545F491U;
+
+    for (uint32_t r = 0; r < rounds; r++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        const int value = (r & 1U) ? (int)seed : (int)(seed % 2000U) - 1000;
+        for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+            const char *format = formats[f];
+            size_t n;
+            int m;
+            if (f == 8) {
+                n = fmt_format(got, sizeof(got), format, (long)value);
+                m = snprintf(want, sizeof(want), format, (long)value);
+            } else if (f == 9) {
+                n = fmt_format(got, sizeof(got), format, 'A' + (int)(seed % 26U), "xyz");
+                m = snprintf(want, sizeof(want), format, 'A' + (int)(seed % 26U), "xyz");
+            } else {
+                n = fmt_format(got, sizeof(got), format, value);
+                m = snprintf(want, sizeof(want), format, value);
+            }
+            wrong += n != (size_t)m || strcmp(got, want) != 0;
+        }
+        const int tenths = (int)(seed % 20001U) - 10000;
+        fmt_format(got, sizeof(got), "%t", tenths);
+        snprintf(want, sizeof(want), "%s%d.%d", tenths < 0 ? "-" : "", abs(tenths) / 10, abs(tenths) % 10);
+        wrong += strcmp(got, want) != 0;
+    }
+    wrong += fmt_format(got, 6, "Temp: %t C", 215) != 12 || strcmp(got, "Temp:") != 0;
+    wrong += fmt_format(NULL, 0, "%d", 12345) != 5;
+
+    uint64_t ours = UINT64_MAX, libc = UINT64_MAX;
+    for (uint32_t r = 0; r < 1000; r++) {
+        uint64_t t0 = sim_cycles();
+        fmt_format(got, sizeof(got), "Fan(%s): %d%%", "AUTO", (int)(r % 101U));
+        uint64_t t = sim_cycles() - t0;
+        ours = (t < ours) ? t : ours;
+        t0 = sim_cycles();
+        snprintf(want, sizeof(want), "Fan(%s): %d%%", "AUTO", (int)(r % 101U));
+        t = sim_cycles() - t0;
+        libc = (t < libc) ? t : libc;
+    }
+    printf("formatter         %llu vs %llu (snprintf) %s per display line\n", (unsigned long long)ours,
+           (unsigned long long)libc, SIM_CYCLES_UNIT);
+
+    int failures = sim_check(wrong == 0, "formatter matches snprintf");
+    _write(1, "DEBUG 1\r\n", 9);
+    sim_run_until(sim_now_ns() + 10 * SIM_NS_PER_MS);
+    failures += sim_check(sim_uart_sent("DEBUG 1\r\n"), "_write goes through the TX queue");
+    return failures;
+}
@@ -0,0 +1,173 @@
+/**
+ * Simulator tests of the keypad scanner: idle, bounce, rollover and the
+ * scan latency.
+ */
+
+#include "app.h"
+#include "sim_tests.h"
+#include "keypad.h"
+#include <string.h>
+
+/*
+ * The scanner on its own first: only interrupts run (sim_run_until_ns()) and
+ * the test drains the event queue in place of keypad_task(). Events are
+ * spelled P, R or L for press, release and long press, followed by the key,
+ * and G for a ghost. 'A' does nothing while unlocked, so the firmware can
+ * also see it.
+ */
+static void sim_keypad_events(uint64_t until_ns, char *out, size_t size) {
+    static const char types[] = { [KEYPAD_EVENT_PRESS] = 'P', [KEYPAD_EVENT_RELEASE] = 'R',
+                                  [KEYPAD_EVENT_LONG_PRESS] = 'L', [KEYPAD_EVENT_GHOST] = 'G' };
+    keypad_event_t event;
+    size_t n = 0;
+
+    sim_run_until_ns(until_ns);
+    while (keypad_get_event(&keypad, &event)) {
+        if (n + 2 < size) {
+            out[n++] = types[event.type];
+            if (event.key != '\0') {
+                out[n++] = event.key;
+            }
+        }
+    }
+    out[n] = '\0';
+}
+
+static int sim_keypad_idle(void) {
+    int low = 1;
+    for (uint8_t row = 0; row < KEYPAD_ROWS; row++) {
+        low = low && sim_gpio_level(keypad.row_ports[row], keypad.row_pins[row]) == 0;
+    }
+    return low && !keypad_is_scanning(&keypad);
+}
+
+static void sim_keypad_bounce(void *ctx) {
+    (void)ctx;
+    sim_keypad_press('A', 1);
+}
+
+static void sim_keypad_press_d(void *ctx) {
+    (void)ctx;
+    sim_keypad_press('D', 60);
+}
+
+static void sim_keypad_press_2(void *ctx) {
+    (void)ctx;
+    sim_keypad_press('2', 250);
+}
+
+static void sim_keypad_press_4(void *ctx) {
+    (void)ctx;
+    sim_keypad_press('4', 100);
+}
+
+/*
+ * Several keys at once: without three corners of a rectangle held (a row and
+ * a column, 1 2 3 and B C D) every key gets its own press and release.
+ * Holding 1, 2 and 4 makes 5 ghost: 1 and 2, pressed before the pattern, are
+ * reported; 4 and the phantom 5 are not. Last, the *+# chord
+ * with the firmware running locks the room in EMERGENCY until the password.
+ */
+int sim_keypad_rollover(void) {
+    int failures = 0;
+    char events[48];
+    const uint32_t ghost_scans = keypad.ghost_scans;
+    keypad_event_t event;
+
+    uint64_t t = sim_now_ns();
+    for (const char *k = "123BC"; *k; k++) {
+        sim_keypad_press(*k, 60);
+    }
+    sim_schedule_at(t + 10 * SIM_NS_PER_MS, sim_keypad_press_d, NULL);
+    sim_run_until_ns(t + 50 * SIM_NS_PER_MS);
+    uint16_t keys = 0;
+    while (keypad_get_event(&keypad, &event)) {
+        keys = event.keys;
+    }
+    sim_keypad_events(t + 150 * SIM_NS_PER_MS, events, sizeof(events));
+    failures += sim_check(keys == keypad_key_mask("123BCD") && strcmp(events, "R1R2R3RBRCRD") == 0 &&
+                          keypad.ghost_scans == ghost_scans, "six keys at once");
+
+    t = sim_now_ns();
+    sim_keypad_press('1', 300);
+    sim_schedule_at(t + 50 * SIM_NS_PER_MS, sim_keypad_press_2, NULL);
+    sim_schedule_at(t + 100 * SIM_NS_PER_MS, sim_keypad_press_4, NULL);
+    sim_keypad_events(t + 400 * SIM_NS_PER_MS, events, sizeof(events));
+    failures += sim_check(strcmp(events, "P1P2GR1R2") == 0 && keypad.ghost_scans > ghost_scans &&
+                          sim_keypad_idle(), "ghosted keys are held back");
+
+    sim_uart_sent("");
+    sim_keypad_press('*', 100);
+    sim_keypad_press('#', 100);
+    sim_run_until(sim_now_ns() + 300 * SIM_NS_PER_MS);
+    failures += sim_check(room_control_get_state(&room_system) == ROOM_STATE_EMERGENCY &&
+                          sim_uart_sent("ALERT:EMERGENCY\r\n") &&
+                          sim_gpio_level(DOOR_STATUS_GPIO_Port, DOOR_STATUS_Pin) == 0, "*+# chord locks in emergency");
+    for (const char *k = "0000"; *k; k++) {
+        sim_keypad_press(*k, 50);
+        sim_run_until(sim_now_ns() + 300 * SIM_NS_PER_MS);
+    }
+    failures += sim_check(room_control_get_state(&room_system) == ROOM_STATE_UNLOCKED, "password leaves emergency");
+    // The lock dropped FORCE_FAN:3: back to 100 % for the tests that follow
+    room_control_force_fan_level(&room_system, FAN_LEVEL_HIGH);
+    return failures;
+}
+
+int sim_keypad_scanner(void) {
+    int failures = 0;
+    char events[40];
+    const uint32_t dropped = keypad.dropped;
+
+    sim_keypad_press('A', 60);
+    sim_keypad_events(sim_now_ns() + 100 * SIM_NS_PER_MS, events, sizeof(events));
+    failures += sim_check(strcmp(events, "PARA") == 0 && sim_keypad_idle(), "key press and release events");
+
+    // 1 ms contacts 6 ms apart never fill an integrator; the hold after them reports once
+    uint64_t t = sim_now_ns();
+    for (int i = 0; i < 4; i++) {
+        sim_schedule_at(t + (uint64_t)i * 6 * SIM_NS_PER_MS, sim_keypad_bounce, NULL);
+    }
+    sim_keypad_events(t + 50 * SIM_NS_PER_MS, events, sizeof(events));
+    failures += sim_check(events[0] == '\0' && sim_keypad_idle(), "contact bounce is filtered");
+    t = sim_now_ns();
+    for (int i = 0; i < 4; i++) {
+        sim_schedule_at(t + (uint64_t)i * 6 * SIM_NS_PER_MS, sim_keypad_bounce, NULL);
+    }
+    sim_run_until_ns(t + 24 * SIM_NS_PER_MS);
+    sim_keypad_press('A', 60);
+    sim_keypad_events(sim_now_ns() + 100 * SIM_NS_PER_MS, events, sizeof(events));
+    failures += sim_check(strcmp(events, "PARA") == 0, "bounce then hold is one press");
+
+    sim_keypad_press('A', KEYPAD_LONG_PRESS_MS + 500);
+    sim_keypad_events(sim_now_ns() + (KEYPAD_LONG_PRESS_MS + 600) * SIM_NS_PER_MS, events, sizeof(events));
+    failures += sim_check(strcmp(events, "PALARA") == 0 && sim_keypad_idle(), "long press event");
+
+    // More events than the queue holds: whole records are kept in order, the rest dropped.
+    // A row at a time, so each scan queues three events behind a single keypad_task post
+    static const char *const rows[] = { "123", "456", "789" };
+    for (size_t r = 0; r < sizeof(rows) / sizeof(rows[0]); r++) {
+        for (const char *k = rows[r]; *k; k++) {
+            sim_keypad_press(*k, 60);
+        }
+        sim_run_until_ns(sim_now_ns() + 100 * SIM_NS_PER_MS);
+    }
+    sim_keypad_events(sim_now_ns(), events, sizeof(events));
+    failures += sim_check(strcmp(events, "P1P2P3R1R2R3P4P5P6R4R5R6P7P8P9R7") == 0 && keypad.dropped == dropped + 2,
+                          "full event queue drops whole events");
+
+    // With the main loop running: a held key must not keep it from other work
+    sched_stats_t before, after;
+    sched_get_stats(&before);
+    sim_keypad_press('A', KEYPAD_LONG_PRESS_MS + 500);
+    sim_run_until(sim_now_ns() + 500 * SIM_NS_PER_MS);
+    sim_uart_sent("");
+    sim_uart_command("GET_STATUS\r\n");
+    sched_get_stats(&after);
+    failures += sim_check(keypad_is_scanning(&keypad) && sim_uart_sent("STATUS:UNLOCKED,FAN:100\r\n") &&
+                          after.timer_runs > before.timer_runs, "main loop runs while a key is held");
+    sim_run_until(sim_now_ns() + (KEYPAD_LONG_PRESS_MS + 100) * SIM_NS_PER_MS);
+    failures += sim_check(sim_keypad_idle() && keypad.dropped == dropped + 2 &&
+                          room_control_get_state(&room_system) == ROOM_STATE_UNLOCKED,
+                          "scanner stops after the release");
+    return failures;
+}
@@ -0,0 +1,59 @@
+/**
+ * Simulator test of the low-power idle hook.
+ */
+
+#include "sim_tests.h"
+#include "lowpower.h"
+#include <stdio.h>
+
+/* Heartbeat period of app.c, the longest regular sleep */
+#define HEARTBEAT_MS 500U
+
+/*
+ * A quiet minute once the console hold has run out: only the heartbeat and
+ * the DHT11 timers may wake the core, HAL_GetTick() must keep up with the
+ * virtual clock, and a key press out of STOP2 must be scanned within the
+ * wake-up latency.
+ */
+static void sim_idle_key(void *ctx) {
+    (void)ctx;
+    sim_keypad_press('D', 50);
+}
+
+int sim_idle(lowpower_mode_t mode) {
+    sim_stats_t before, after;
+    sim_lowpower_stats_t lp_before, lp_after;
+    int failures = 0;
+
+    sim_run_until(sim_now_ns() + 40000 * SIM_NS_PER_MS);
+    sim_get_stats(&before);
+    sim_lowpower_get_stats(&lp_before);
+    sim_run_until(sim_now_ns() + 20000 * SIM_NS_PER_MS);
+    sim_get_stats(&after);
+    sim_lowpower_get_stats(&lp_after);
+
+    const uint32_t wakeups = (after.systicks - before.systicks) + (lp_after.wakeups - lp_before.wakeups);
+    printf("idle minute       %lu wakeups in 20 s, %.1f s of it in STOP2\n", (unsigned long)wakeups,
+           (double)(lp_after.stop2_ns - lp_before.stop2_ns) / 1e9);
+    if (mode != LOWPOWER_SLEEP) {
+        // Heartbeat twice a second, a DHT11 reading every 2 s with its ~8 ms of capture polling
+        failures += sim_check(wakeups <= 20 * (2 + 5) && (mode != LOWPOWER_STOP2 || lp_after.stop2_ns > lp_before.stop2_ns),
+                              "idle sleeps from timer to timer");
+    }
+    // Tickless sleeps are whole LPTIM1 ticks, fractions of a millisecond carried over:
+    // on the ideal 32 kHz clock only the rounding of either side remains
+    const long long drift = (sim_tick_drift_ms() < 0) ? -sim_tick_drift_ms() : sim_tick_drift_ms();
+    failures += sim_check(drift <= 2, "HAL_GetTick() follows the clock");
+
+    // Pressed halfway between two heartbeats, as an event, so it lands while the core sleeps
+    const uint64_t period_ns = HEARTBEAT_MS * SIM_NS_PER_MS;
+    sim_schedule_at((sim_now_ns() / period_ns + 1) * period_ns + period_ns / 2, sim_idle_key, NULL);
+    sim_run_until(sim_now_ns() + 2 * period_ns);
+    // Its EXTI handler runs once the core is awake again: a tickless or STOP2 wake costs time
+    const uint64_t latency = sim_keypad_last_latency_ns();
+    printf("key wake          %.1f us to the first row scanned\n", (double)latency / (double)SIM_NS_PER_US);
+    failures += sim_check((mode == LOWPOWER_SLEEP || latency > 0) &&
+                          latency <= LOWPOWER_WAKE_LATENCY_US * SIM_NS_PER_US,
+                          "key wakes the core and is scanned");
+    return failures;
+}
@@ -0,0 +1,137 @@
+/**
+ * Simulator tests of the ring buffers: the bulk and zero-copy calls against
+ * a byte-by-byte reference, and the SPSC variant between two host threads.
+ */
+
+#include "sim_tests.h"
+#include "ring_buffer.h"
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+/* Zero-copy reserve/commit and peek/consume against byte-wise write and read */
+int sim_ring_buffer_zero_copy(uint32_t rounds) {
+    ring_buffer_t zc, bytes;
+    uint8_t zc_storage[64], byte_storage[64];
+    uint32_t mismatches = 0;
+
+    _Static_assert(RING_BUFFER_IS_POW2(sizeof zc_storage) && RING_BUFFER_IS_POW2(sizeof byte_storage),
+                   "ring buffer storage must be a power of two");
+
+    ring_buffer_init(&zc, zc_storage, sizeof zc_storage);
+    ring_buffer_init(&bytes, byte_storage, sizeof byte_storage);
+    for (uint32_t r = 0; r < rounds; r++) {
+        uint16_t len = (uint16_t)(sim_fuzz_next() % 48U);
+        if (sim_fuzz_next() & 1U) {
+            while (len > 0) {
+                uint8_t *span;
+                uint16_t n = ring_buffer_reserve(&zc, &span);
+                if (n == 0) {
+                    break;
+                }
+                n = (n < len) ? n : len;
+                for (uint16_t i = 0; i < n; i++) {
+                    span[i] = (uint8_t)sim_fuzz_next();
+                    ring_buffer_write(&bytes, span[i]);
+                }
+                ring_buffer_commit(&zc, n);
+                len -= n;
+            }
+        } else {
+            while (len > 0) {
+                const uint8_t *span;
+                uint16_t n = ring_buffer_peek_contiguous(&zc, &span);
+                if (n == 0) {
+                    break;
+                }
+                n = (n < len) ? n : len;
+                for (uint16_t i = 0; i < n; i++) {
+                    uint8_t byte = 0;
+                    mismatches += !ring_buffer_read(&bytes, &byte) || byte != span[i];
+                }
+                ring_buffer_consume(&zc, n);
+                len -= n;
+            }
+        }
+        mismatches += ring_buffer_count(&zc) != ring_buffer_count(&bytes);
+    }
+    return sim_check(mismatches == 0, "ring buffer zero-copy access");
+}
+
+/* Random bulk transfers must leave the buffer exactly as byte-wise ones would */
+int sim_ring_buffer_bulk(uint32_t rounds) {
+    ring_buffer_t bulk, bytes;
+    uint8_t bulk_storage[64], byte_storage[64];
+    uint8_t in[100], out_bulk[100], out_bytes[100];
+    uint32_t mismatches = 0;
+
+    _Static_assert(RING_BUFFER_IS_POW2(sizeof bulk_storage) && RING_BUFFER_IS_POW2(sizeof byte_storage),
+                   "ring buffer storage must be a power of two");
+
+    // A capacity the mask cannot wrap is refused, not rounded down
+    const int refused = !ring_buffer_init(&bulk, bulk_storage, 48) && !ring_buffer_init(&bulk, bulk_storage, 0);
+    ring_buffer_init(&bulk, bulk_storage, sizeof bulk_storage);
+    ring_buffer_init(&bytes, byte_storage, sizeof byte_storage);
+    for (uint32_t r = 0; r < rounds; r++) {
+        const uint16_t len = (uint16_t)(sim_fuzz_next() % sizeof in);
+        if (sim_fuzz_next() & 1U) {
+            for (uint16_t i = 0; i < len; i++) {
+                in[i] = (uint8_t)sim_fuzz_next();
+                ring_buffer_write(&bytes, in[i]);
+            }
+            ring_buffer_write_bulk(&bulk, in, len);
+        } else {
+            uint16_t n = 0;
+            while (n < len && ring_buffer_read(&bytes, &out_bytes[n])) {
+                n++;
+            }
+            mismatches += ring_buffer_read_bulk(&bulk, out_bulk, len) != n;
+            mismatches += memcmp(out_bulk, out_bytes, n) != 0;
+        }
+        mismatches += ring_buffer_count(&bulk) != ring_buffer_count(&bytes);
+    }
+    int failures = sim_check(refused, "ring buffer refuses a bad capacity");
+    failures += sim_check(mismatches == 0, "ring buffer bulk transfers");
+    return failures;
+}
+
+#define SPSC_STRESS_BYTES 2000000U
+
+static ring_buffer_spsc_t spsc_rb;
+static uint8_t spsc_storage[64];
+
+/* Stands in for the UART RX interrupt: pushes a known sequence as fast as it can */
+static void *spsc_producer(void *arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < SPSC_STRESS_BYTES;) {
+        if (ring_buffer_spsc_write(&spsc_rb, (uint8_t)(i * 7U))) {
+            i++;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+int sim_spsc_stress(void) {
+    pthread_t producer;
+    uint32_t received = 0, out_of_order = 0;
+    uint8_t byte;
+
+    ring_buffer_spsc_init(&spsc_rb, spsc_storage, sizeof spsc_storage);
+    if (pthread_create(&producer, NULL, spsc_producer, NULL) != 0) {
+        return sim_check(0, "SPSC ring buffer across threads");
+    }
+    while (received < SPSC_STRESS_BYTES) {
+        if (ring_buffer_spsc_read(&spsc_rb, &byte)) {
+            out_of_order += byte != (uint8_t)(received * 7U);
+            received++;
+        } else {
+            sched_yield();
+        }
+    }
+    pthread_join(producer, NULL);
+
+    return sim_check(out_of_order == 0 && ring_buffer_spsc_is_empty(&spsc_rb),
+                     "SPSC ring buffer across threads");
+}
@@ -0,0 +1,172 @@
+/**
+ * Simulator walk of the room_control transition table.
+ */
+
+#include "sim_tests.h"
+#include "room_control.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Every state x input cell of the transition table, on a room of its own:
+ * each case reaches a state from LOCKED with keys ('!' is the emergency
+ * chord), optionally lets time pass for the timeout guards, sends one event
+ * and checks the next state and that exactly the expected row counted it
+ * (-1: the cell ignores the event). Every cell and every row of the table
+ * must be walked. It runs while the app room is LOCKED with the fan off and
+ * leaves the outputs that way.
+ */
+typedef struct {
+    const char *keys;
+    room_state_t from;
+    uint32_t wait_ms;
+    room_input_t input;
+    room_state_t to;
+    int8_t alt;
+} sim_fsm_case_t;
+
+#define FSM_ALL_KEYS(keys, from, digit_to, digit_alt, star_to, star_alt, hash_to, hash_alt, key_to, key_alt) \
+    { keys, from, 0, ROOM_INPUT_DIGIT, digit_to, digit_alt },                                              \
+    { keys, from, 0, ROOM_INPUT_STAR, star_to, star_alt },                                                 \
+    { keys, from, 0, ROOM_INPUT_HASH, hash_to, hash_alt },                                                 \
+    { keys, from, 0, ROOM_INPUT_KEY, key_to, key_alt },                                                    \
+    { keys, from, 0, ROOM_INPUT_TEMPERATURE, from, 0 },                                                    \
+    { keys, from, 0, ROOM_INPUT_DISPLAY_READY, from, -1 }
+
+static const sim_fsm_case_t fsm_cases[] = {
+    FSM_ALL_KEYS("", ROOM_STATE_LOCKED, ROOM_STATE_INPUT_PASSWORD, 0, ROOM_STATE_LOCKED, -1,
+                 ROOM_STATE_LOCKED, -1, ROOM_STATE_LOCKED, -1),
+    { "", ROOM_STATE_LOCKED, 0, ROOM_INPUT_TIMEOUT, ROOM_STATE_LOCKED, -1 },
+    { "", ROOM_STATE_LOCKED, 0, ROOM_INPUT_EMERGENCY, ROOM_STATE_EMERGENCY, 0 },
+
+    FSM_ALL_KEYS("1", ROOM_STATE_INPUT_PASSWORD, ROOM_STATE_INPUT_PASSWORD, 2, ROOM_STATE_INPUT_PASSWORD, 0,
+                 ROOM_STATE_LOCKED, 1, ROOM_STATE_INPUT_PASSWORD, 0),
+    { "000", ROOM_STATE_INPUT_PASSWORD, 0, ROOM_INPUT_DIGIT, ROOM_STATE_UNLOCKED, 0 },      /* '0' completes 0000 */
+    { "005", ROOM_STATE_INPUT_PASSWORD, 0, ROOM_INPUT_DIGIT, ROOM_STATE_ACCESS_DENIED, 1 },
+    { "1", ROOM_STATE_INPUT_PASSWORD, 0, ROOM_INPUT_TIMEOUT, ROOM_STATE_INPUT_PASSWORD, -1 },
+    { "1", ROOM_STATE_INPUT_PASSWORD, 20100, ROOM_INPUT_TIMEOUT, ROOM_STATE_LOCKED, 1 },
+    { "1", ROOM_STATE_INPUT_PASSWORD, 0, ROOM_INPUT_EMERGENCY, ROOM_STATE_EMERGENCY, 0 },
+
+    FSM_ALL_KEYS("0000", ROOM_STATE_UNLOCKED, ROOM_STATE_UNLOCKED, -1, ROOM_STATE_LOCKED, 0,
+                 ROOM_STATE_UNLOCKED, -1, ROOM_STATE_UNLOCKED, -1),
+    { "0000", ROOM_STATE_UNLOCKED, 0, ROOM_INPUT_TIMEOUT, ROOM_STATE_UNLOCKED, -1 },
+    { "0000", ROOM_STATE_UNLOCKED, 0, ROOM_INPUT_EMERGENCY, ROOM_STATE_EMERGENCY, 0 },
+
+    FSM_ALL_KEYS("1234", ROOM_STATE_ACCESS_DENIED, ROOM_STATE_ACCESS_DENIED, -1, ROOM_STATE_ACCESS_DENIED, -1,
+                 ROOM_STATE_ACCESS_DENIED, -1, ROOM_STATE_ACCESS_DENIED, -1),
+    { "1234", ROOM_STATE_ACCESS_DENIED, 0, ROOM_INPUT_TIMEOUT, ROOM_STATE_ACCESS_DENIED, -1 },
+    { "1234", ROOM_STATE_ACCESS_DENIED, 5100, ROOM_INPUT_TIMEOUT, ROOM_STATE_LOCKED, 1 },
+    { "1234", ROOM_STATE_ACCESS_DENIED, 0, ROOM_INPUT_EMERGENCY, ROOM_STATE_EMERGENCY, 0 },
+
+    FSM_ALL_KEYS("!", ROOM_STATE_EMERGENCY, ROOM_STATE_INPUT_PASSWORD, 0, ROOM_STATE_EMERGENCY, -1,
+                 ROOM_STATE_EMERGENCY, -1, ROOM_STATE_EMERGENCY, -1),
+    { "!", ROOM_STATE_EMERGENCY, 0, ROOM_INPUT_TIMEOUT, ROOM_STATE_EMERGENCY, -1 },
+    { "!", ROOM_STATE_EMERGENCY, 0, ROOM_INPUT_EMERGENCY, ROOM_STATE_EMERGENCY, -1 },
+
+    /* Password entry started in EMERGENCY: only the right password leaves it */
+    { "!1", ROOM_STATE_INPUT_PASSWORD, 0, ROOM_INPUT_HASH, ROOM_STATE_EMERGENCY, 0 },
+    { "!1", ROOM_STATE_INPUT_PASSWORD, 20100, ROOM_INPUT_TIMEOUT, ROOM_STATE_EMERGENCY, 0 },
+    { "!123", ROOM_STATE_INPUT_PASSWORD, 0, ROOM_INPUT_DIGIT, ROOM_STATE_ACCESS_DENIED, 1 },
+    { "!1234", ROOM_STATE_ACCESS_DENIED, 5100, ROOM_INPUT_TIMEOUT, ROOM_STATE_EMERGENCY, 0 },
+    { "!000", ROOM_STATE_INPUT_PASSWORD, 0, ROOM_INPUT_DIGIT, ROOM_STATE_UNLOCKED, 0 },
+    { "!0000*1", ROOM_STATE_INPUT_PASSWORD, 0, ROOM_INPUT_HASH, ROOM_STATE_LOCKED, 1 },
+};
+
+static room_control_t fsm_room;
+
+/* One event of each input; a digit that is not in the password unless the keys end in "000" */
+static room_event_t sim_fsm_event(room_input_t input, const char *keys) {
+    static const char input_keys[] = { [ROOM_INPUT_STAR] = '*', [ROOM_INPUT_HASH] = '#', [ROOM_INPUT_KEY] = 'A' };
+    const size_t n = strlen(keys);
+    const char digit = (n >= 3 && strcmp(&keys[n - 3], "000") == 0) ? '0' : '5';
+    room_event_t event = { .type = ROOM_EVENT_KEY };
+    switch (input) {
+        case ROOM_INPUT_TEMPERATURE:   event.type = ROOM_EVENT_TEMPERATURE; event.temperature = 300; break;
+        case ROOM_INPUT_TIMEOUT:       event.type = ROOM_EVENT_TIMEOUT; break;
+        case ROOM_INPUT_DISPLAY_READY: event.type = ROOM_EVENT_DISPLAY_READY; break;
+        case ROOM_INPUT_EMERGENCY:     event.type = ROOM_EVENT_EMERGENCY; break;
+        default:                       event.key = (input == ROOM_INPUT_DIGIT) ? digit : input_keys[input]; break;
+    }
+    return event;
+}
+
+static uint32_t sim_fsm_total(room_control_t *room) {
+    room_transition_stats_t stats;
+    uint32_t total = 0;
+    for (int s = 0; s < ROOM_STATE_COUNT; s++) {
+        for (int i = 0; i < ROOM_INPUT_COUNT; i++) {
+            for (uint8_t alt = 0; alt < ROOM_FSM_ALTS; alt++) {
+                total += room_control_get_transition_stats(room, (room_state_t)s, (room_input_t)i, alt, &stats)
+                         ? stats.count : 0;
+            }
+        }
+    }
+    return total;
+}
+
+int sim_fsm_walk(void) {
+    uint8_t covered[ROOM_STATE_COUNT][ROOM_INPUT_COUNT] = {{0}};
+    uint8_t fired[ROOM_STATE_COUNT][ROOM_INPUT_COUNT][ROOM_FSM_ALTS] = {{{0}}};
+    uint32_t wrong = 0, rows = 0, missed = 0, cycles_max = 0;
+    room_transition_stats_t stats;
+
+    for (size_t c = 0; c < sizeof(fsm_cases) / sizeof(fsm_cases[0]); c++) {
+        const sim_fsm_case_t *fc = &fsm_cases[c];
+        sched_timer_stop(&fsm_room.state_timer);
+        room_control_init(&fsm_room);
+        for (const char *k = fc->keys; *k; k++) {
+            const room_event_t setup = { .type = (*k == '!') ? ROOM_EVENT_EMERGENCY : ROOM_EVENT_KEY, .key = *k };
+            room_control_handle_event(&fsm_room, &setup);
+        }
+        // The room's own timeout must not beat the event under test
+        sched_timer_stop(&fsm_room.state_timer);
+        if (fc->wait_ms) {
+            sim_run_until(sim_now_ns() + fc->wait_ms * SIM_NS_PER_MS);
+        }
+
+        const room_event_t event = sim_fsm_event(fc->input, fc->keys);
+        const uint32_t total = sim_fsm_total(&fsm_room);
+        room_transition_stats_t before = {0};
+        if (fc->alt >= 0) {
+            room_control_get_transition_stats(&fsm_room, fc->from, fc->input, (uint8_t)fc->alt, &before);
+        }
+        const room_state_t from = room_control_get_state(&fsm_room);
+        room_control_handle_event(&fsm_room, &event);
+
+        int ok = from == fc->from && room_control_event_input(&event) == fc->input &&
+                 room_control_get_state(&fsm_room) == fc->to;
+        if (fc->alt >= 0) {
+            ok = ok && room_control_get_transition_stats(&fsm_room, fc->from, fc->input, (uint8_t)fc->alt, &stats) &&
+                 stats.count == before.count + 1 && sim_fsm_total(&fsm_room) == total + 1;
+            fired[fc->from][fc->input][fc->alt] = 1;
+            cycles_max = (stats.cycles_max > cycles_max) ? stats.cycles_max : cycles_max;
+        } else {
+            ok = ok && sim_fsm_total(&fsm_room) == total;
+        }
+        if (!ok) {
+            printf("state machine     case %u: %d x %d -> %d, expected %d -> %d (row %d)\n", (unsigned)c, (int)from,
+                   (int)fc->input, (int)room_control_get_state(&fsm_room), (int)fc->from, (int)fc->to, (int)fc->alt);
+        }
+        wrong += !ok;
+        covered[fc->from][fc->input] = 1;
+    }
+
+    // Every cell walked, every row of the table fired
+    for (int s = 0; s < ROOM_STATE_COUNT; s++) {
+        for (int i = 0; i < ROOM_INPUT_COUNT; i++) {
+            missed += !covered[s][i];
+            for (uint8_t alt = 0; alt < ROOM_FSM_ALTS; alt++) {
+                if (room_control_get_transition_stats(&fsm_room, (room_state_t)s, (room_input_t)i, alt, &stats)) {
+                    rows++;
+                    missed += !fired[s][i][alt];
+                }
+            }
+        }
+    }
+    sched_timer_stop(&fsm_room.state_timer);
+    room_control_init(&fsm_room);
+    printf("state machine     %lu cases over %d x %d cells, %lu rows, slowest transition %lu cycles (virtual clock)\n",
+           (unsigned long)(sizeof(fsm_cases) / sizeof(fsm_cases[0])), ROOM_STATE_COUNT, ROOM_INPUT_COUNT,
+           (unsigned long)rows, (unsigned long)cycles_max);
+    return sim_check(wrong == 0 && missed == 0, "state x event matrix walked");
+}
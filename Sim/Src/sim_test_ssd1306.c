@@ -0,0 +1,286 @@
+/**
+ * Simulator tests of the SSD1306 driver: the text and arc drawing
+ * benchmarks, and the DMA flush of the dirty pages.
+ */
+
+#include "sim_tests.h"
+#include "ssd1306.h"
+#include "ssd1306_fonts.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/* ------------------------------------------------------------------------- */
+/* Display drawing                                                           */
+/* ------------------------------------------------------------------------- */
+
+/* Per-pixel glyph renderer that the byte-column blitter of ssd1306_WriteChar() replaced */
+static void sim_text_pixels(uint8_t x, uint8_t y, const char *str, SSD1306_Font_t font, SSD1306_COLOR color) {
+    for (; *str; str++) {
+        const uint8_t char_width = font.char_width ? font.char_width[*str - 32] : font.width;
+        const uint32_t pages = (font.height + 7U) / 8U;
+        for (uint32_t i = 0; i < font.height; i++) {
+            for (uint32_t j = 0; j < char_width; j++) {
+                uint8_t set;
+                if (font.data) {
+                    set = (font.data[(*str - 32) * font.height + i] << j) & 0x8000 ? 1 : 0;
+                } else {
+                    set = (font.paged[((*str - 32) * pages + i / 8U) * font.width + j] >> (i % 8U)) & 1U;
+                }
+                ssd1306_DrawPixel((uint8_t)(x + j), (uint8_t)(y + i), set ? color : (SSD1306_COLOR)!color);
+            }
+        }
+        x = (uint8_t)(x + char_width);
+    }
+}
+
+/* Three lines of status text */
+static void sim_text_screen(int blit) {
+    static const struct { uint8_t y; char text[20]; } lines[] = {
+        { 5, "ACCESO PERMITIDO" }, { 22, "Temp: 24.5 C" }, { 38, "Fan(AUTO): 30%" },
+    };
+    ssd1306_Fill(Black);
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+        if (blit) {
+            char text[sizeof(lines[i].text)];
+            memcpy(text, lines[i].text, sizeof(text));
+            ssd1306_SetCursor(5, lines[i].y);
+            ssd1306_WriteString(text, Font_7x10, White);
+        } else {
+            sim_text_pixels(5, lines[i].y, lines[i].text, Font_7x10, White);
+        }
+    }
+}
+
+/*
+ * The status text drawn with the blitter and with the per-pixel renderer:
+ * the same frame buffer, and the time of each at its fastest run. The frame
+ * the app drew is put back afterwards and flushed as a whole.
+ */
+int sim_text_bench(uint32_t rounds) {
+    static uint8_t saved[SSD1306_BUFFER_SIZE], blit[SSD1306_BUFFER_SIZE];
+    uint64_t blit_best = UINT64_MAX, pixel_best = UINT64_MAX;
+
+    while (ssd1306_IsBusy()) {
+        sim_run_until_ns(sim_now_ns() + SIM_NS_PER_MS);
+    }
+    memcpy(saved, ssd1306_GetBuffer(), sizeof(saved));
+    for (uint32_t r = 0; r < rounds; r++) {
+        uint64_t t0 = sim_cycles();
+        sim_text_screen(1);
+        uint64_t t = sim_cycles() - t0;
+        blit_best = (t < blit_best) ? t : blit_best;
+        t0 = sim_cycles();
+        sim_text_screen(0);
+        t = sim_cycles() - t0;
+        pixel_best = (t < pixel_best) ? t : pixel_best;
+    }
+    sim_text_screen(1);
+    memcpy(blit, ssd1306_GetBuffer(), sizeof(blit));
+    sim_text_screen(0);
+    const int same = memcmp(blit, ssd1306_GetBuffer(), sizeof(blit)) == 0;
+    ssd1306_FillBuffer(saved, sizeof(saved));
+
+    printf("text blitter      %llu vs %llu (per pixel) %s per three lines, %.1f times faster\n",
+           (unsigned long long)blit_best, (unsigned long long)pixel_best, SIM_CYCLES_UNIT,
+           (double)pixel_best / (double)(blit_best ? blit_best : 1));
+    return sim_check(same, "blitter draws the per-pixel glyphs");
+}
+
+/* Float arc as ssd1306_DrawArc() drew it before the sine table */
+static void sim_arc_float(uint8_t x, uint8_t y, uint8_t radius, uint16_t start_angle, uint16_t sweep,
+                          SSD1306_COLOR color) {
+    const uint32_t segments = 36;
+    uint32_t count = ((start_angle % 360U) * segments) / 360U;
+    const uint32_t approx_segments = (sweep * segments) / 360U;
+    const float approx_degree = sweep / (float)approx_segments;
+
+    while (count < approx_segments) {
+        float rad = count * approx_degree * (3.14f / 180.0f);
+        const uint8_t xp1 = (uint8_t)(x + (int8_t)(sinf(rad) * radius));
+        const uint8_t yp1 = (uint8_t)(y + (int8_t)(cosf(rad) * radius));
+        count++;
+        rad = ((count != approx_segments) ? count * approx_degree : sweep) * (3.14f / 180.0f);
+        ssd1306_Line(xp1, yp1, (uint8_t)(x + (int8_t)(sinf(rad) * radius)), (uint8_t)(y + (int8_t)(cosf(rad) * radius)),
+                     color);
+    }
+}
+
+/*
+ * A 270 degree arc drawn from the sine table of ssd1306_DrawArc() and with
+ * the float reference, the time of each at its fastest run; every pixel of
+ * the table arc must lie on the circle, within the chord sag and rounding.
+ */
+int sim_arc_bench(uint32_t rounds) {
+    static uint8_t saved[SSD1306_BUFFER_SIZE];
+    const uint8_t cx = 30, cy = 30, radius = 28;
+    uint64_t table_best = UINT64_MAX, float_best = UINT64_MAX;
+
+    while (ssd1306_IsBusy()) {
+        sim_run_until_ns(sim_now_ns() + SIM_NS_PER_MS);
+    }
+    memcpy(saved, ssd1306_GetBuffer(), sizeof(saved));
+    for (uint32_t r = 0; r < rounds; r++) {
+        ssd1306_Fill(Black);
+        uint64_t t0 = sim_cycles();
+        ssd1306_DrawArc(cx, cy, radius, 0, 270, White);
+        uint64_t t = sim_cycles() - t0;
+        table_best = (t < table_best) ? t : table_best;
+        ssd1306_Fill(Black);
+        t0 = sim_cycles();
+        sim_arc_float(cx, cy, radius, 0, 270, White);
+        t = sim_cycles() - t0;
+        float_best = (t < float_best) ? t : float_best;
+    }
+
+    ssd1306_Fill(Black);
+    ssd1306_DrawArc(cx, cy, radius, 0, 270, White);
+    const uint8_t *fb = ssd1306_GetBuffer();
+    uint32_t lit = 0, off = 0;
+    for (uint32_t i = 0; i < SSD1306_BUFFER_SIZE * 8U; i++) {
+        const uint32_t x = i % SSD1306_WIDTH, y = i / SSD1306_WIDTH;
+        if ((fb[x + (y / 8U) * SSD1306_WIDTH] >> (y % 8U)) & 1U) {
+            const double d = hypot((double)x - cx, (double)y - cy);
+            lit++;
+            off += fabs(d - radius) > 1.5;
+        }
+    }
+    ssd1306_FillBuffer(saved, sizeof(saved));
+
+    printf("arc               %llu vs %llu (float) %s per 270 degree arc, %.1f times faster\n",
+           (unsigned long long)table_best, (unsigned long long)float_best, SIM_CYCLES_UNIT,
+           (double)float_best / (double)(table_best ? table_best : 1));
+    return sim_check(lit > 2U * radius && off == 0, "sine-table arc lies on the circle");
+}
+
+/* ------------------------------------------------------------------------- */
+/* Display flush                                                             */
+/* ------------------------------------------------------------------------- */
+
+/* Runs interrupts one event at a time until the asynchronous flush is over */
+static void sim_flush_finish(void) {
+    while (ssd1306_IsBusy()) {
+        sim_run_until_ns(sim_next_event_ns());
+    }
+}
+
+/* A short line on each of the given pages, so that every page is a window of its own */
+static void sim_flush_marks(const uint8_t *pages, size_t count, uint8_t x, SSD1306_COLOR color) {
+    for (size_t i = 0; i < count; i++) {
+        ssd1306_Line(x, (uint8_t)(pages[i] * 8U + 3U), (uint8_t)(x + 9U), (uint8_t)(pages[i] * 8U + 3U), color);
+    }
+}
+
+/* Every window is a command transfer for its page, then its data, in page order */
+static int sim_flush_windows(const sim_i2c_write_t *writes, size_t n, const uint8_t *pages, size_t count) {
+    if (n != 2 * count) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const sim_i2c_write_t *cmd = &writes[2 * i], *data = &writes[2 * i + 1];
+        if (cmd->mem_address != 0x00 || cmd->size != 6 || cmd->head[0] != 0x21 || cmd->head[3] != 0x22 ||
+            cmd->head[4] != pages[i] || cmd->head[5] != pages[i] || data->mem_address != 0x40 ||
+            data->size != cmd->head[2] - cmd->head[1] + 1) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int sim_flush_panel(void) {
+    return memcmp(sim_ssd1306_ram(), ssd1306_GetBuffer(), SSD1306_BUFFER_SIZE) == 0;
+}
+
+static int isr_flush_busy;
+
+/* Redraws and flushes from interrupt context while a flush is in progress */
+static void sim_flush_from_isr(void *ctx) {
+    (void)ctx;
+    ssd1306_Line(100, 60, 110, 60, White);
+    ssd1306_UpdateScreen();
+    isr_flush_busy = ssd1306_IsBusy();
+}
+
+/*
+ * The DMA flush on the panel model: the windows in order, the busy flag up
+ * through the whole chain, a redraw during a flush left for the next one, an
+ * I2C error aborting into a full resend, and a blocking flush from an ISR
+ * that must not wait. The frame the app drew is put back afterwards.
+ */
+int sim_display_flush(void) {
+    static uint8_t saved[SSD1306_BUFFER_SIZE], sent[SSD1306_BUFFER_SIZE];
+    static const uint8_t pages[] = { 0, 3, 7 };
+    const size_t count = sizeof(pages) / sizeof(pages[0]);
+    sim_i2c_write_t writes[SIM_I2C_LOG_SIZE];
+    int failures = 0;
+
+    sim_flush_finish();
+    memcpy(saved, ssd1306_GetBuffer(), sizeof(saved));
+    ssd1306_Fill(Black);
+    ssd1306_UpdateScreenAsync();
+    sim_flush_finish();
+    sim_i2c_take_writes(NULL, 0);
+
+    // Three pages far apart, chained from the transfer complete interrupts
+    sim_flush_marks(pages, count, 20, White);
+    failures += sim_check(ssd1306_UpdateScreenAsync() == SSD1306_OK && ssd1306_UpdateScreenAsync() == SSD1306_ERR,
+                          "flush refuses a second start");
+    size_t n = 0;
+    while (ssd1306_IsBusy()) {
+        n += sim_i2c_take_writes(&writes[n], SIM_I2C_LOG_SIZE - n);
+        sim_run_until_ns(sim_next_event_ns());
+    }
+    const size_t busy_for = n;
+    n += sim_i2c_take_writes(&writes[n], SIM_I2C_LOG_SIZE - n);
+    sim_run_until_ns(sim_now_ns() + SIM_NS_PER_MS);
+    failures += sim_check(busy_for == 2 * count && n == 2 * count && sim_i2c_take_writes(NULL, 0) == 0,
+                          "busy through all chained windows");
+    failures += sim_check(sim_flush_windows(writes, n, pages, count), "flush sends command, then data");
+    failures += sim_check(sim_flush_panel(), "panel RAM matches the framebuffer");
+
+    // The transfer reads the shadow copy: a redraw during it goes out with the next flush
+    sim_flush_marks(pages, count, 60, White);
+    memcpy(sent, ssd1306_GetBuffer(), sizeof(sent));
+    ssd1306_UpdateScreenAsync();
+    ssd1306_Fill(White);
+    sim_flush_finish();
+    const int kept = memcmp(sim_ssd1306_ram(), sent, sizeof(sent)) == 0;
+    ssd1306_UpdateScreenAsync();
+    sim_flush_finish();
+    failures += sim_check(kept && sim_flush_panel(), "redraw waits for the next flush");
+
+    // NACK on the second window: the flush stops, and the next one resends everything
+    sim_flush_marks(pages, count, 90, Black);
+    sim_i2c_take_writes(NULL, 0);
+    sim_i2c_nack(3);
+    ssd1306_UpdateScreenAsync();
+    sim_flush_finish();
+    sim_run_until_ns(sim_now_ns() + SIM_NS_PER_MS);
+    const size_t aborted = sim_i2c_take_writes(NULL, 0);
+    ssd1306_UpdateScreenAsync();
+    sim_flush_finish();
+    n = sim_i2c_take_writes(writes, SIM_I2C_LOG_SIZE);
+    failures += sim_check(aborted == 2 && n == 2 && writes[0].head[4] == 0 && writes[0].head[5] == SSD1306_PAGES - 1 &&
+                          writes[1].size == SSD1306_BUFFER_SIZE && sim_flush_panel(),
+                          "I2C error aborts, then all is resent");
+
+    // From an ISR the blocking flush gives up instead of spinning on the busy flag
+    ssd1306_Fill(Black);
+    ssd1306_UpdateScreenAsync();
+    sim_i2c_take_writes(NULL, 0);
+    isr_flush_busy = 0;
+    sim_schedule_at(sim_now_ns() + 10 * SIM_NS_PER_US, sim_flush_from_isr, NULL);
+    sim_run_until_ns(sim_now_ns() + 10 * SIM_NS_PER_US);
+    const int gave_up = isr_flush_busy && sim_i2c_take_writes(NULL, 0) == 0;
+    sim_flush_finish();
+    ssd1306_UpdateScreenAsync();
+    sim_flush_finish();
+    failures += sim_check(gave_up && sim_flush_panel(), "ISR flush leaves the bus to the DMA");
+
+    ssd1306_FillBuffer(saved, sizeof(saved));
+    ssd1306_UpdateScreenAsync();
+    sim_flush_finish();
+    // Let the main loop take the display-ready events the flushes posted
+    sim_run_until(sim_now_ns() + 20 * SIM_NS_PER_MS);
+    return failures;
+}
@@ -0,0 +1,111 @@
+/**
+ * Simulator tests of the USART2 pipeline: a captured terminal session
+ * replayed through the DMA receiver, and bursts through the transmit queue.
+ */
+
+#include "sim_tests.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+#include <stdio.h>
+#include <string.h>
+
+/* A terminal session as captured on the wire: pause before each burst and its bytes */
+static const struct {
+    uint32_t gap_ms;
+    const char *bytes;
+} uart_capture[] = {
+    {0,   "G"}, {180, "E"}, {150, "T"}, {210, "_"}, {160, "T"}, {140, "E"}, {170, "M"},
+    {190, "P"}, {260, "\r\n"},                                       // typed by hand
+    {900, "GET_STATUS\r\n"},                                          // sent by a script
+    {700, "FORCE_"}, {3, "FAN:2\r\n"},                                 // split by the USB bridge
+    {500, "GET_TEMP\r\nGET_STATUS\r\nSET_PASS:0000\r\nFORCE_FAN:0\r\n"
+          "GET_TEMP\r\nGET_STATUS\r\nFORCE_FAN:3\r\nGET_TEMP\n"},        // pasted, 100 bytes
+    {400, "0123456789012345678901234567890123456789012345678901234567890123456789\r\n"},
+    {300, "GET_TEMP\r\n"},
+};
+
+/* Replays the capture into USART2 and checks what the pipeline made of it */
+int sim_uart_replay(void) {
+    sim_stats_t before, after;
+    uint32_t bursts = 0, bytes = 0, lines = 0;
+    const uint32_t lines_before = uart2_rx.lines, long_before = uart2_rx.long_lines;
+
+    sim_get_stats(&before);
+    for (size_t i = 0; i < sizeof(uart_capture) / sizeof(uart_capture[0]); i++) {
+        const size_t n = strlen(uart_capture[i].bytes);
+        sim_run_until(sim_now_ns() + uart_capture[i].gap_ms * SIM_NS_PER_MS);
+        sim_uart_inject(&huart2, (const uint8_t *)uart_capture[i].bytes, n);
+        for (size_t k = 0; k < n; k++) {
+            lines += uart_capture[i].bytes[k] == '\n';
+        }
+        bursts++;
+        bytes += (uint32_t)n;
+    }
+    sim_run_until(sim_now_ns() + 100 * SIM_NS_PER_MS);
+    sim_get_stats(&after);
+
+    const uint32_t irqs = after.uart_rx_irqs - before.uart_rx_irqs;
+    printf("uart replay       %lu bytes in %lu bursts: %lu interrupts\n",
+           (unsigned long)bytes, (unsigned long)bursts, (unsigned long)irqs);
+    int failures = sim_check(uart2_rx.lines - lines_before == lines - 1 && uart2_rx.long_lines - long_before == 1 &&
+                             uart2_rx.dropped == 0, "UART lines framed from the replay");
+    // One IDLE per burst, plus a half/full transfer every time the DMA crosses half of its area
+    failures += sim_check(irqs <= bursts + (bytes + UART_RX_DMA_SIZE / 2 - 1) / (UART_RX_DMA_SIZE / 2),
+                          "UART one interrupt per burst");
+
+    // A framing error inside a line: the HAL stops the DMA, the pipeline restarts it and drops that line
+    static const char cut[] = "GET_TEMP\r\n", next[] = "GET_STATUS\r\n";
+    const uint32_t errors_before = uart2_rx.errors, broken_before = uart2_rx.broken_lines;
+    const uint32_t good_before = uart2_rx.lines;
+    sim_uart_framing_error(&huart2, 4);
+    sim_uart_inject(&huart2, (const uint8_t *)cut, sizeof(cut) - 1);
+    sim_run_until(sim_now_ns() + 50 * SIM_NS_PER_MS);
+    sim_uart_inject(&huart2, (const uint8_t *)next, sizeof(next) - 1);
+    sim_run_until(sim_now_ns() + 50 * SIM_NS_PER_MS);
+    failures += sim_check(uart2_rx.errors - errors_before == 1 && uart2_rx.broken_lines - broken_before == 1 &&
+                          uart2_rx.lines - good_before == 1 && huart2.RxState == HAL_UART_STATE_BUSY_RX,
+                          "UART RX restarts after a framing error");
+    return failures;
+}
+
+/* A burst larger than the TX queue: whole messages are sent or dropped, in order */
+int sim_uart_tx_burst(void) {
+    static char expected[SIM_UART_LOG_SIZE + 1], sent[SIM_UART_LOG_SIZE + 1];
+    const uint32_t queued_before = uart2_tx.queued, dropped_before = uart2_tx.dropped;
+    uint32_t accepted = 0, rejected = 0, len = 0, total = 0;
+    char msg[32];
+
+    sim_uart_take_tx(&huart2, sent, SIM_UART_LOG_SIZE);
+    for (int i = 0; i < 40; i++) {
+        const int n = snprintf(msg, sizeof(msg), "TELEMETRY %02d 0123456\r\n", i);
+        total += (uint32_t)n;
+        if (uart_tx_write(&uart2_tx, msg, (uint16_t)n)) {
+            memcpy(&expected[len], msg, (size_t)n);
+            len += (uint32_t)n;
+            accepted++;
+        } else {
+            rejected++;
+        }
+    }
+    expected[len] = '\0';
+    sim_run_until(sim_now_ns() + 100 * SIM_NS_PER_MS);
+    const size_t n = sim_uart_take_tx(&huart2, sent, SIM_UART_LOG_SIZE);
+    sent[n] = '\0';
+
+    printf("uart tx burst     %lu messages queued, %lu dropped\n", (unsigned long)accepted, (unsigned long)rejected);
+    int failures = sim_check(rejected > 0 && strcmp(sent, expected) == 0 && uart2_tx.sent == uart2_tx.queued &&
+                     uart2_tx.queued - queued_before == len &&
+                     uart2_tx.dropped - dropped_before == total - len, "UART TX queue drops whole messages");
+
+    // The main loop held up past the end of the transfer it started: each byte still goes out once
+    static const char once[] = "SENT ONCE\r\n";
+    sim_uart_preempt_tx(&huart2, 1);
+    uart_tx_puts(&uart2_tx, once);
+    sim_uart_preempt_tx(&huart2, 0);
+    sim_run_until(sim_now_ns() + 10 * SIM_NS_PER_MS);
+    const size_t m = sim_uart_take_tx(&huart2, sent, SIM_UART_LOG_SIZE);
+    sent[m] = '\0';
+    failures += sim_check(strcmp(sent, once) == 0 && uart2_tx.sent == uart2_tx.queued && uart2_tx.in_flight == 0,
+                          "UART TX completes during its own start");
+    return failures;
+}
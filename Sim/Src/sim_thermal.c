@@ -0,0 +1,79 @@
+/**
+ * Thermal model of the room, for closed-loop runs of the fan control.
+ *
+ * One lumped temperature T with a heat load and two ways out, both towards
+ * the outdoor air: the walls, and the fan blowing outdoor air in. With the
+ * fan at duty d (0..1):
+ *
+ *   tau dT/dt = load - (1 + fan_ratio d) (T - outdoor)
+ *
+ * so with the fan off the room settles load degrees above outdoor, in tau
+ * seconds, and a running fan both lowers that level and speeds it up. The
+ * duty is what the PWM output has at each step (compare over period), ramps
+ * included. Every step the temperature goes to the DHT11 model, rounded to
+ * tenths as the sensor reports it.
+ */
+
+#include "sim.h"
+
+#define THERMAL_STEP_NS    (1000ULL * SIM_NS_PER_MS)
+#define THERMAL_TRACE_STEPS 10
+#define THERMAL_HUMIDITY   50
+
+static sim_thermal_t plant;
+static double temp_c;
+static TIM_HandleTypeDef *fan_htim;
+static uint32_t fan_channel;
+static uint32_t generation;     /* a stop or restart orphans the scheduled step */
+static uint32_t steps;
+
+static double thermal_duty(void) {
+    const double period = (double)__HAL_TIM_GET_AUTORELOAD(fan_htim) + 1.0;
+    const double compare = (double)__HAL_TIM_GET_COMPARE(fan_htim, fan_channel);
+    return (compare < period) ? compare / period : 1.0;
+}
+
+static void thermal_report(void) {
+    const double tenths = temp_c * 10.0;
+    sim_dht11_set((int16_t)(tenths < 0 ? tenths - 0.5 : tenths + 0.5), THERMAL_HUMIDITY);
+}
+
+static void thermal_step(void *ctx) {
+    if ((uint32_t)(uintptr_t)ctx != generation) {
+        return;
+    }
+    const double dt = (double)THERMAL_STEP_NS / 1e9;
+    const double duty = thermal_duty();
+    temp_c += dt / plant.tau_s * (plant.load_k - (1.0 + plant.fan_ratio * duty) * (temp_c - plant.outdoor_c));
+    thermal_report();
+    if (++steps % THERMAL_TRACE_STEPS == 0) {
+        sim_trace("plant", "temp", "%.2f", temp_c);
+    }
+    sim_schedule_at(sim_now_ns() + THERMAL_STEP_NS, thermal_step, ctx);
+}
+
+/* Starts the model at temp, reading the fan duty from the given PWM channel */
+void sim_thermal_start(const sim_thermal_t *model, double temp, TIM_HandleTypeDef *htim, uint32_t channel) {
+    plant = *model;
+    temp_c = temp;
+    fan_htim = htim;
+    fan_channel = channel;
+    steps = 0;
+    generation++;
+    thermal_report();
+    sim_schedule_at(sim_now_ns() + THERMAL_STEP_NS, thermal_step, (void *)(uintptr_t)generation);
+}
+
+/* A new heat load from now on, e.g. the sun coming round */
+void sim_thermal_set_load(double load_k) {
+    plant.load_k = load_k;
+}
+
+/* Freezes the model; the DHT11 keeps reporting the last temperature */
+void sim_thermal_stop(void) {
+    generation++;
+}
+
+double sim_thermal_temp(void) {
+    return temp_c;
+}
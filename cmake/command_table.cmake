@@ -0,0 +1,27 @@
+# Perfect-hash dispatch table of the UART command parser, generated from the
+# COMMAND_LIST of Core/Inc/commands.h. When a Python 3 interpreter is found the
+# table header is generated and COMMAND_USE_PERFECT_HASH is defined; otherwise
+# commands.c looks the names up with a linear scan.
+find_package(Python3 COMPONENTS Interpreter)
+
+function(command_table target)
+    if(NOT Python3_Interpreter_FOUND)
+        return()
+    endif()
+    set(COMMAND_TABLE_DIR ${CMAKE_BINARY_DIR}/generated)
+    set(COMMAND_TABLE ${COMMAND_TABLE_DIR}/command_table.h)
+    if(NOT TARGET command_table)
+        add_custom_command(
+            OUTPUT ${COMMAND_TABLE}
+            COMMAND ${Python3_EXECUTABLE} ${CMAKE_SOURCE_DIR}/tools/command_hashgen.py
+                    ${CMAKE_SOURCE_DIR}/Core/Inc/commands.h ${COMMAND_TABLE}
+            DEPENDS ${CMAKE_SOURCE_DIR}/tools/command_hashgen.py
+                    ${CMAKE_SOURCE_DIR}/Core/Inc/commands.h
+            COMMENT "Generating the command perfect-hash table"
+        )
+        add_custom_target(command_table DEPENDS ${COMMAND_TABLE})
+    endif()
+    add_dependencies(${target} command_table)
+    target_include_directories(${target} PRIVATE ${COMMAND_TABLE_DIR})
+    target_compile_definitions(${target} PRIVATE COMMAND_USE_PERFECT_HASH)
+endfunction()
@@ -0,0 +1,27 @@
+# Page-native SSD1306 fonts generated from Drivers/ssd1306/ssd1306_fonts.c.
+# When a Python 3 interpreter is found, the generated tables are added to the
+# target and SSD1306_USE_PAGED_FONTS is defined; otherwise the row-major
+# tables are used as they are.
+find_package(Python3 COMPONENTS Interpreter)
+
+function(ssd1306_paged_fonts target)
+    if(NOT Python3_Interpreter_FOUND)
+        return()
+    endif()
+    set(SSD1306_FONTS_PAGED ${CMAKE_BINARY_DIR}/generated/ssd1306_fonts_paged.c)
+    if(NOT TARGET ssd1306_fonts_paged)
+        add_custom_command(
+            OUTPUT ${SSD1306_FONTS_PAGED}
+            COMMAND ${Python3_EXECUTABLE} ${CMAKE_SOURCE_DIR}/tools/ssd1306_fontgen.py
+                    ${CMAKE_SOURCE_DIR}/Drivers/ssd1306/ssd1306_fonts.c ${SSD1306_FONTS_PAGED}
+            DEPENDS ${CMAKE_SOURCE_DIR}/tools/ssd1306_fontgen.py
+                    ${CMAKE_SOURCE_DIR}/Drivers/ssd1306/ssd1306_fonts.c
+            COMMENT "Generating page-native SSD1306 fonts"
+        )
+        add_custom_target(ssd1306_fonts_paged DEPENDS ${SSD1306_FONTS_PAGED})
+    endif()
+    add_dependencies(${target} ssd1306_fonts_paged)
+    target_sources(${target} PRIVATE ${SSD1306_FONTS_PAGED})
+    set_source_files_properties(${SSD1306_FONTS_PAGED} PROPERTIES GENERATED TRUE)
+    target_compile_definitions(${target} PRIVATE SSD1306_USE_PAGED_FONTS)
+endfunction()
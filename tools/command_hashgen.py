@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""
+Generate the perfect-hash dispatch table of the UART command parser.
+
+Reads the X(NAME, handler) entries of COMMAND_LIST in commands.h and searches
+a seed for the hash used by commands.c (FNV-1a step over the name bytes,
+top COMMAND_TABLE_BITS bits of the result) so that every name lands in its
+own slot of the smallest power-of-two table that allows it. The header maps
+each slot to 1 + the position of the command in COMMAND_LIST, 0 if empty.
+
+Usage: command_hashgen.py <commands.h> <output.h>
+"""
+
+import os
+import re
+import sys
+
+LIST_RE = re.compile(r"#define\s+COMMAND_LIST\(X\)((?:.*\\\n)*.*)")
+ENTRY_RE = re.compile(r"X\(\s*([A-Z0-9_]+)\s*,")
+FNV_PRIME = 0x01000193
+MAX_SEEDS = 1 << 20
+
+
+def parse_names(source):
+    match = LIST_RE.search(source)
+    if not match:
+        raise SystemExit("COMMAND_LIST(X) not found")
+    names = ENTRY_RE.findall(match.group(1))
+    if not names or len(set(names)) != len(names):
+        raise SystemExit("COMMAND_LIST(X) must list distinct commands")
+    return names
+
+
+def command_hash(seed, name, bits):
+    h = seed
+    for c in name.encode():
+        h = ((h ^ c) * FNV_PRIME) & 0xFFFFFFFF
+    return h >> (32 - bits)
+
+
+def search(names):
+    bits = max(1, (len(names) - 1).bit_length())
+    while bits <= 8:
+        for seed in range(0x811C9DC5, 0x811C9DC5 + MAX_SEEDS):
+            slots = [command_hash(seed, name, bits) for name in names]
+            if len(set(slots)) == len(names):
+                return seed, bits, slots
+        bits += 1
+    raise SystemExit("no perfect hash found")
+
+
+def emit(names, seed, bits, slots, source_name):
+    table = [0] * (1 << bits)
+    for index, slot in enumerate(slots):
+        table[slot] = index + 1
+    lines = [
+        "/* Generated by tools/command_hashgen.py from %s. Do not edit. */" % source_name,
+        "",
+        "#define COMMAND_HASH_SEED  0x%08XU" % seed,
+        "#define COMMAND_TABLE_BITS %d" % bits,
+        "#define COMMAND_TABLE_COUNT %d" % len(names),
+        "",
+        "static const uint8_t command_slots[1U << COMMAND_TABLE_BITS] = {",
+    ]
+    for slot, entry in enumerate(table):
+        label = names[entry - 1] if entry else "-"
+        lines.append("    %d,  // %d: %s" % (entry, slot, label))
+    lines.append("};")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def main():
+    if len(sys.argv) != 3:
+        raise SystemExit(__doc__)
+    with open(sys.argv[1]) as f:
+        names = parse_names(f.read())
+    seed, bits, slots = search(names)
+    text = emit(names, seed, bits, slots, sys.argv[1].replace("\\", "/").split("/")[-1])
+    out_dir = os.path.dirname(sys.argv[2])
+    if out_dir:
+        os.makedirs(out_dir, exist_ok=True)
+    with open(sys.argv[2], "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""
+Generate page-native copies of the SSD1306 fonts.
+
+Reads the row-major uint16_t glyph tables of ssd1306_fonts.c (one word per
+pixel row, MSB = leftmost pixel) and writes a C file with the same glyphs in
+the layout of the SSD1306 screenbuffer: for each glyph, one run of `width`
+vertical bytes per 8px page, bit 0 being the top row of the page.
+
+Usage: ssd1306_fontgen.py <ssd1306_fonts.c> <output.c>
+"""
+
+import os
+import re
+import sys
+
+TABLE_RE = re.compile(r"static\s+const\s+uint16_t\s+(Font(\d+)x(\d+))\s*\[\]\s*=\s*\{(.*?)\};", re.S)
+COMMENT_RE = re.compile(r"/\*.*?\*/|//[^\n]*", re.S)
+FIRST_CHAR = 32
+LAST_CHAR = 126
+
+
+def parse_tables(source):
+    fonts = []
+    for match in TABLE_RE.finditer(source):
+        name, width, height, body = match.groups()
+        words = [int(tok, 0) for tok in re.findall(r"0x[0-9A-Fa-f]+|\d+", COMMENT_RE.sub("", body))]
+        width, height = int(width), int(height)
+        glyphs = LAST_CHAR - FIRST_CHAR + 1
+        if len(words) != glyphs * height:
+            raise SystemExit("%s: expected %d rows, found %d" % (name, glyphs * height, len(words)))
+        fonts.append((name, width, height, words))
+    return fonts
+
+
+def paged_glyph(rows, width, height):
+    pages = (height + 7) // 8
+    out = []
+    for page in range(pages):
+        for col in range(width):
+            byte = 0
+            for bit in range(8):
+                row = page * 8 + bit
+                if row < height and rows[row] & (0x8000 >> col):
+                    byte |= 1 << bit
+            out.append(byte)
+    return out
+
+
+def emit(fonts, source_name):
+    lines = [
+        "/* Generated by tools/ssd1306_fontgen.py from %s. Do not edit. */" % source_name,
+        "",
+        '#include "ssd1306_fonts.h"',
+        "",
+    ]
+    for name, width, height, words in fonts:
+        lines.append("#ifdef SSD1306_INCLUDE_FONT_%dx%d" % (width, height))
+        lines.append("const uint8_t %s_paged[] = {" % name)
+        for index in range(LAST_CHAR - FIRST_CHAR + 1):
+            rows = words[index * height:(index + 1) * height]
+            data = paged_glyph(rows, width, height)
+            char = chr(FIRST_CHAR + index)
+            label = {" ": "sp", "\\": "backslash"}.get(char, char)
+            lines.append("%s,  // %s" % (", ".join("0x%02X" % b for b in data), label))
+        lines.append("};")
+        lines.append("#endif")
+        lines.append("")
+    return "\n".join(lines)
+
+
+def main():
+    if len(sys.argv) != 3:
+        raise SystemExit(__doc__)
+    with open(sys.argv[1]) as f:
+        source = f.read()
+    text = emit(parse_tables(source), sys.argv[1].replace("\\", "/").split("/")[-1])
+    out_dir = os.path.dirname(sys.argv[2])
+    if out_dir:
+        os.makedirs(out_dir, exist_ok=True)
+    with open(sys.argv[2], "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()